@@ -0,0 +1,108 @@
+#include "graph.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace analysis {
+
+void bltOrder(const std::vector<std::vector<std::size_t>>& dependencies,
+              std::vector<std::vector<std::size_t>>& blocks, std::vector<std::size_t>& levels) {
+    // Tarjan's algorithm, with an explicit call stack so that long chains of
+    // dependencies cannot overflow the stack. Since we follow dependencies, a
+    // block is complete only once all the blocks it depends on are, so blocks
+    // come out in evaluation order.
+
+    static const auto Unvisited = std::numeric_limits<std::size_t>::max();
+
+    auto nodeCount = dependencies.size();
+    std::vector<std::size_t> indices(nodeCount, Unvisited);
+    std::vector<std::size_t> lowLinks(nodeCount);
+    std::vector<std::size_t> nodeBlocks(nodeCount, Unvisited);
+    std::vector<std::size_t> stack;
+    std::vector<std::pair<std::size_t, std::size_t>> callStack;
+    std::size_t index = 0;
+
+    blocks.clear();
+    levels.clear();
+
+    auto visit = [&](std::size_t node) {
+        indices[node] = index;
+        lowLinks[node] = index;
+        ++index;
+
+        stack.push_back(node);
+        callStack.emplace_back(node, 0);
+    };
+
+    for (std::size_t root = 0; root < nodeCount; ++root) {
+        if (indices[root] != Unvisited) {
+            continue;
+        }
+
+        visit(root);
+
+        while (!callStack.empty()) {
+            auto& [node, edge] = callStack.back();
+
+            if (edge < dependencies[node].size()) {
+                auto dependency = dependencies[node][edge++];
+
+                if (indices[dependency] == Unvisited) {
+                    visit(dependency);
+                } else if (nodeBlocks[dependency] == Unvisited) {
+                    // The dependency is still on our stack.
+
+                    lowLinks[node] = std::min(lowLinks[node], indices[dependency]);
+                }
+
+                continue;
+            }
+
+            auto done = node;
+
+            callStack.pop_back();
+
+            if (!callStack.empty()) {
+                auto parent = callStack.back().first;
+
+                lowLinks[parent] = std::min(lowLinks[parent], lowLinks[done]);
+            }
+
+            if (lowLinks[done] != indices[done]) {
+                continue;
+            }
+
+            // done is the root of a block, which holds it and the nodes above
+            // it on our stack.
+
+            auto blockIndex = blocks.size();
+            auto& block = blocks.emplace_back();
+            std::size_t member;
+
+            do {
+                member = stack.back();
+                stack.pop_back();
+
+                nodeBlocks[member] = blockIndex;
+                block.push_back(member);
+            } while (member != done);
+
+            std::sort(block.begin(), block.end());
+
+            std::size_t level = 0;
+
+            for (auto member : block) {
+                for (auto dependency : dependencies[member]) {
+                    if (nodeBlocks[dependency] != blockIndex) {
+                        level = std::max(level, levels[nodeBlocks[dependency]] + 1);
+                    }
+                }
+            }
+
+            levels.push_back(level);
+        }
+    }
+}
+
+}
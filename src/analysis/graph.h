@@ -0,0 +1,20 @@
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace analysis {
+
+// Sort the nodes of the given graph, where dependencies[i] are the nodes that
+// node i depends on, into blocks of strongly connected nodes (using Tarjan's
+// algorithm), in an order where each block comes after the blocks it depends
+// on, i.e. a block-lower-triangular (BLT) order. The nodes of a block are in
+// increasing order. Also give the level of each block: 0 for a block that
+// depends on no other block, and one more than the highest level of the blocks
+// it depends on otherwise, so that the blocks of a level only depend on blocks
+// of lower levels. Runs in linear time in the size of the graph.
+void bltOrder(const std::vector<std::vector<std::size_t>>& dependencies,
+              std::vector<std::vector<std::size_t>>& blocks, std::vector<std::size_t>& levels);
+
+}
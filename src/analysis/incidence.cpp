@@ -0,0 +1,202 @@
+
+#include "incidence.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "graph.h"
+#include "mathml/dom.h"
+
+namespace analysis {
+
+namespace {
+
+using mathml::elements;
+using mathml::text;
+
+void collectVariables(const utils::XmlNode& node, std::vector<std::string>& variables) {
+    if (node.name() == "ci") {
+        variables.push_back(text(node));
+    } else {
+        for (auto child : elements(node)) {
+            collectVariables(*child, variables);
+        }
+    }
+}
+
+// Sort the given rows and make them unique, and store them as a CSR matrix.
+void toSparseMatrix(std::vector<std::vector<std::size_t>>& rows, std::size_t columnCount, tomathml::SparseMatrix& matrix) {
+    matrix.rowCount = rows.size();
+    matrix.columnCount = columnCount;
+    matrix.rowOffsets.assign(1, 0);
+    matrix.columnIndices.clear();
+
+    for (auto& row : rows) {
+        std::sort(row.begin(), row.end());
+        row.erase(std::unique(row.begin(), row.end()), row.end());
+
+        matrix.columnIndices.insert(matrix.columnIndices.end(), row.begin(), row.end());
+        matrix.rowOffsets.push_back(matrix.columnIndices.size());
+    }
+}
+
+}
+
+bool structure(const utils::XmlNodePtr& document, tomathml::Structure& structure, std::string& error) {
+    structure = tomathml::Structure();
+
+    // Find our equations and, first, our states.
+
+    std::vector<const utils::XmlNode*> lhss;
+    std::vector<const utils::XmlNode*> rhss;
+    std::vector<bool> isOde;
+    std::unordered_map<std::string, std::size_t> columns;
+
+    for (const auto& child : document->children()) {
+        if ((child->type() != utils::XmlNodeType::Element) || (child->name() != "math")) {
+            continue;
+        }
+
+        for (auto equation : elements(*child)) {
+            auto children = elements(*equation);
+
+            if ((equation->name() != "apply") || (children.size() != 3) || (children[0]->name() != "eq")) {
+                error = "Only equations can be analysed.";
+
+                return false;
+            }
+
+            auto lhsChildren = elements(*children[1]);
+
+            if ((children[1]->name() == "apply") && (lhsChildren.size() == 3) && (lhsChildren[0]->name() == "diff")) {
+                auto state = text(*lhsChildren[2]);
+
+                if (columns.emplace(state, structure.variables.size()).second) {
+                    structure.variables.push_back(state);
+                }
+
+                // The variable of an ODE is its state.
+
+                lhss.push_back(lhsChildren[2]);
+                isOde.push_back(true);
+            } else {
+                lhss.push_back(children[1]);
+                isOde.push_back(false);
+            }
+
+            rhss.push_back(children[2]);
+        }
+    }
+
+    structure.stateCount = structure.variables.size();
+
+    // Build our incidence matrix, numbering our other variables as we go.
+
+    std::vector<std::vector<std::size_t>> rows(lhss.size());
+    std::vector<std::vector<std::size_t>> rhsColumns(lhss.size());
+    std::vector<std::string> variables;
+
+    auto column = [&](const std::string& variable) {
+        auto [iter, inserted] = columns.emplace(variable, structure.variables.size());
+
+        if (inserted) {
+            structure.variables.push_back(variable);
+        }
+
+        return iter->second;
+    };
+
+    for (std::size_t i = 0; i < lhss.size(); ++i) {
+        variables.clear();
+        collectVariables(*rhss[i], variables);
+
+        rows[i].push_back(column(text(*lhss[i])));
+        for (const auto& variable : variables) {
+            rhsColumns[i].push_back(column(variable));
+        }
+        rows[i].insert(rows[i].end(), rhsColumns[i].begin(), rhsColumns[i].end());
+    }
+
+    toSparseMatrix(rows, structure.variables.size(), structure.incidence);
+
+    // Sort our equations in evaluation order, with an equation depending on
+    // the algebraic equations that compute the variables it uses.
+
+    const auto none = lhss.size();
+    std::vector<std::size_t> algebraicEquations(structure.variables.size(), none);
+
+    for (std::size_t i = 0; i < lhss.size(); ++i) {
+        auto lhsColumn = columns[text(*lhss[i])];
+
+        if (!isOde[i] && (algebraicEquations[lhsColumn] == none)) {
+            algebraicEquations[lhsColumn] = i;
+        }
+    }
+
+    std::vector<std::vector<std::size_t>> dependencies(lhss.size());
+
+    for (std::size_t i = 0; i < lhss.size(); ++i) {
+        for (auto used : rhsColumns[i]) {
+            if (algebraicEquations[used] != none) {
+                dependencies[i].push_back(algebraicEquations[used]);
+            }
+        }
+    }
+
+    bltOrder(dependencies, structure.blocks, structure.blockLevels);
+
+    // Determine the states that each equation depends on, directly or through
+    // the equations it depends on. All the equations of a block depend on the
+    // same states.
+
+    std::vector<std::size_t> equationBlocks(lhss.size());
+
+    for (std::size_t i = 0; i < structure.blocks.size(); ++i) {
+        for (auto equation : structure.blocks[i]) {
+            equationBlocks[equation] = i;
+        }
+    }
+
+    std::vector<std::vector<std::size_t>> states(structure.blocks.size());
+
+    for (std::size_t i = 0; i < structure.blocks.size(); ++i) {
+        auto& blockStates = states[i];
+
+        for (auto equation : structure.blocks[i]) {
+            for (auto used : rhsColumns[equation]) {
+                if (used < structure.stateCount) {
+                    blockStates.push_back(used);
+                }
+            }
+
+            for (auto dependency : dependencies[equation]) {
+                if (equationBlocks[dependency] != i) {
+                    const auto& dependencyStates = states[equationBlocks[dependency]];
+
+                    blockStates.insert(blockStates.end(), dependencyStates.begin(), dependencyStates.end());
+                }
+            }
+        }
+
+        std::sort(blockStates.begin(), blockStates.end());
+        blockStates.erase(std::unique(blockStates.begin(), blockStates.end()), blockStates.end());
+    }
+
+    // Build our Jacobian sparsity pattern.
+
+    std::vector<std::vector<std::size_t>> jacobianRows;
+
+    for (std::size_t i = 0; i < lhss.size(); ++i) {
+        if (isOde[i]) {
+            const auto& equationStates = states[equationBlocks[i]];
+
+            jacobianRows.emplace_back(equationStates.begin(), equationStates.end());
+        }
+    }
+
+    toSparseMatrix(jacobianRows, structure.stateCount, structure.jacobianSparsity);
+
+    return true;
+}
+
+}
@@ -0,0 +1,16 @@
+
+#pragma once
+
+#include <string>
+
+#include "tomathml_structure.h"
+#include "utils/xmllite.h"
+
+namespace analysis {
+
+// Determine the structure of the equations of the given content MathML
+// document. Return false, with an error message, if the document has anything
+// but equations.
+bool structure(const utils::XmlNodePtr& document, tomathml::Structure& structure, std::string& error);
+
+}
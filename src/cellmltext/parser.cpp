@@ -2,12 +2,15 @@
 #include "cellmltext/parser.h"
 
 #include <algorithm>
+#include <array>
+#include <limits>
 
 #include "utils/stringhelp.h"
 
 namespace CellMLText {
 
 static const auto MathmlNamespace = "http://www.w3.org/1998/Math/MathML";
+static const auto CellmlNamespace = "http://www.cellml.org/cellml/2.0#";
 
 template<typename Key, typename Value>
 std::vector<Key> getKeys(const std::map<Key, Value>inMap)
@@ -82,7 +85,7 @@ std::string ParserMessage::message() const
 
 
 
-bool Parser::execute(const std::string &pCellmlText)
+bool Parser::execute(std::string_view pCellmlText)
 {
     // Get ready for the parsing of a model definition
 
@@ -93,7 +96,7 @@ bool Parser::execute(const std::string &pCellmlText)
 
 
 
-bool Parser::execute(const std::string &pCellmlText,
+bool Parser::execute(std::string_view pCellmlText,
                                    bool pFullParsing,
                                    bool cellmlMode)
 {
@@ -104,27 +107,9 @@ bool Parser::execute(const std::string &pCellmlText,
     // Either fully parse or partially parse a mathematical expression
 
     if (pFullParsing) {
-        // Parse a mathematical expression
+        // Parse all the mathematical expressions
 
-        static const Scanner::Tokens Tokens = { Scanner::Token::IdentifierOrCmetaId,
-                                                              Scanner::Token::Ode };
-
-        while (mScanner.token() != Scanner::Token::Eof) {
-            if (tokenType(mMathElement, "An identifier or 'ode'",
-                          Tokens)) {
-                if (!parseMathematicalExpression(mMathElement)) {
-                    return false;
-                }
-            } else {
-                return false;
-            }
-
-            // Expect the end of the mathematical expression
-
-            mScanner.getNextToken();
-        }
-
-        return true;
+        return parseStatements(std::numeric_limits<std::size_t>::max());
     }
 
     // Partially parse a mathematical expression
@@ -155,7 +140,9 @@ bool Parser::execute(const std::string &pCellmlText,
             return true;
         }
 
-        return parseMathematicalExpression(mDomDocument, pFullParsing);
+        return mCellmlMode ?
+                   parseMathematicalExpression<true>(mDomDocument, pFullParsing) :
+                   parseMathematicalExpression<false>(mDomDocument, pFullParsing);
     }
 
     return false;
@@ -163,6 +150,67 @@ bool Parser::execute(const std::string &pCellmlText,
 
 
 
+void Parser::start(std::string_view pCellmlText, bool pCellmlMode)
+{
+    // Get ready for the parsing of mathematical expressions, a few at a time
+
+    initialize(pCellmlText, pCellmlMode);
+}
+
+
+
+bool Parser::parseStatements(std::size_t pCount)
+{
+    // Parse up to the given number of mathematical expressions, in the mode
+    // we are in
+    // Note: the mode is a template parameter of our parsing methods, so that
+    //       each mode gets its own code, free of the checks and the parsing of
+    //       units that don't apply to it...
+
+    return mCellmlMode ?
+               parseMathematicalExpressions<true>(pCount) :
+               parseMathematicalExpressions<false>(pCount);
+}
+
+
+
+template<bool CellmlMode>
+bool Parser::parseMathematicalExpressions(std::size_t pCount)
+{
+    // Parse up to the given number of mathematical expressions
+
+    static const Scanner::Tokens Tokens = { Scanner::Token::IdentifierOrCmetaId,
+                                                          Scanner::Token::Ode };
+
+    for (std::size_t i = 0; (i < pCount) && (mScanner.token() != Scanner::Token::Eof); ++i) {
+        if (tokenType(mMathElement, "An identifier or 'ode'",
+                      Tokens)) {
+            if (!parseMathematicalExpression<CellmlMode>(mMathElement)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+
+        // Expect the end of the mathematical expression
+
+        mScanner.getNextToken();
+    }
+
+    return true;
+}
+
+
+
+bool Parser::atEnd() const
+{
+    // Return whether we have parsed all the mathematical expressions
+
+    return mScanner.token() == Scanner::Token::Eof;
+}
+
+
+
 utils::XmlNodePtr Parser::domDocument() const
 {
     // Return our DOM document
@@ -179,6 +227,33 @@ ParserMessages Parser::messages() const
 
 
 
+const std::vector<tomathml::Symbol> &Parser::symbols() const
+{
+    // Return our symbols
+
+    return mSymbols;
+}
+
+
+
+std::size_t Parser::odeCount() const
+{
+    // Return our number of ODEs
+
+    return mOdeCount;
+}
+
+
+
+std::size_t Parser::algebraicEquationCount() const
+{
+    // Return our number of algebraic equations
+
+    return mAlgebraicEquationCount;
+}
+
+
+
 Parser::Statement Parser::statement() const
 {
     // Return our statement type
@@ -188,16 +263,16 @@ Parser::Statement Parser::statement() const
 
 
 
-void Parser::initialize(const std::string &pCellmlText, bool pCellmlMode)
+void Parser::initialize(std::string_view pCellmlText, bool pCellmlMode)
 {
     // Initialize ourselves with the given CellML Text string
 
     mScanner.setText(pCellmlText);
     mCellmlMode = pCellmlMode;
 
-    mDomDocument = utils::createNode(utils::XmlNodeType::Root, "");
-    mDomDocument->addChild(utils::createNode(utils::XmlNodeType::Declaration, "xml version=\"1.0\" encoding=\"UTF-8\""));
-    mMathElement = utils::createNode(utils::XmlNodeType::Element, "math");
+    mDomDocument = utils::createNode(utils::XmlNodeType::Root, "", "", mMemoryResource);
+    mDomDocument->addChild(utils::createNode(utils::XmlNodeType::Declaration, "xml version=\"1.0\" encoding=\"UTF-8\"", "", mMemoryResource));
+    mMathElement = utils::createNode(utils::XmlNodeType::Element, "math", "", mMemoryResource);
     mMathElement->declareNamespace("", MathmlNamespace);
     mDomDocument->addChild(mMathElement);
 
@@ -205,6 +280,21 @@ void Parser::initialize(const std::string &pCellmlText, bool pCellmlMode)
 
     mNamespaces.clear();
 
+    if (mDomNodePool.resource() == mMemoryResource) {
+        mDomNodePool.clear();
+    } else {
+        mDomNodePool.reset(mMemoryResource);
+    }
+
+    mUnitsChecker.clear();
+
+    mSymbols.clear();
+    mSymbolIndices.clear();
+    mSymbolTextNodes.clear();
+
+    mOdeCount = 0;
+    mAlgebraicEquationCount = 0;
+
     mStatement = Statement::Unknown;
 }
 
@@ -223,108 +313,280 @@ void Parser::addUnexpectedTokenErrorMessage(const std::string &pExpectedString,
 
 
 
+utils::XmlNodePtr Parser::newDomNode(utils::XmlNodeType pType,
+                                     const std::string &pName)
+{
+    // Create and return a new DOM node or, if we are not building our DOM tree,
+    // return our placeholder DOM node, so that no DOM node gets allocated
+
+    if (!mBuildDom) {
+        return mPlaceholderDomNode;
+    }
+
+    return utils::createNode(pType, pName, "", mMemoryResource);
+}
+
+
+
+void Parser::addChildDomNode(const utils::XmlNodePtr &pDomNode,
+                             const utils::XmlNodePtr &pChildDomNode)
+{
+    // Append the given child DOM node to the given DOM node, if we are building
+    // our DOM tree
+
+    if (mBuildDom) {
+        pDomNode->addChild(pChildDomNode);
+    }
+}
+
+
+
+void Parser::addDomAttribute(const utils::XmlNodePtr &pDomNode,
+                             const std::string &pName,
+                             const std::string &pValue,
+                             const std::string &pPrefix)
+{
+    // Add the given attribute to the given DOM node, if we are building our DOM
+    // tree
+
+    if (mBuildDom) {
+        pDomNode->addAttribute(pName, pValue, pPrefix);
+    }
+}
+
+
+
 utils::XmlNodePtr Parser::newDomElement(utils::XmlNodePtr pDomNode,
                                                 const std::string &pElementName)
 {
     // Create a new DOM element with the given name and append it to the given
     // DOM node before returning it
 
-    utils::XmlNodePtr domElement = utils::createNode(utils::XmlNodeType::Element, pElementName);
+    utils::XmlNodePtr domElement = newDomNode(utils::XmlNodeType::Element, pElementName);
 
-    pDomNode->addChild(domElement);
+    addChildDomNode(pDomNode, domElement);
 
     return domElement;
 }
 
 
 
-utils::XmlNodePtr Parser::newIdentifierElement(const std::string &pValue)
+void Parser::declareNamespace(utils::XmlNodePtr &pDomElement,
+                              const std::string &pPrefix,
+                              const std::string &pUri)
 {
-    // Create and return a new identifier element with the given value
+    // Declare the given namespace on the given DOM element or, if we are
+    // hoisting namespaces, on our math element, unless it has already been
+    // declared there
+
+    if (!mBuildDom) {
+        return;
+    }
 
-    utils::XmlNodePtr identifierElement = utils::createNode(utils::XmlNodeType::Element, "ci");
+    if (!mHoistNamespaces) {
+        pDomElement->declareNamespace(pPrefix, pUri);
 
-    identifierElement->addChild(utils::createNode(utils::XmlNodeType::Text, pValue));
+        return;
+    }
 
-    return identifierElement;
+    if (mNamespaces.emplace(pPrefix, pUri).second) {
+        mMathElement->declareNamespace(pPrefix, pUri);
+    }
 }
 
 
 
-utils::XmlNodePtr Parser::newDerivativeElement(const std::string &pF,
-                                                       const std::string &pX)
+void Parser::declareNamespace(std::vector<utils::XmlAttribute> &pDomAttributes,
+                              const std::string &pPrefix,
+                              const std::string &pUri)
 {
-    // Create and return a new derivative element with the given parameters
+    // Declare the given namespace through the given DOM attributes of a DOM
+    // element that has yet to be created or, if we are hoisting namespaces, on
+    // our math element, unless it has already been declared there
 
-    utils::XmlNodePtr derivativeElement = utils::createNode(utils::XmlNodeType::Element, "apply");
-    utils::XmlNodePtr bvarElement = utils::createNode(utils::XmlNodeType::Element, "bvar");
+    if (!mBuildDom) {
+        return;
+    }
 
-    derivativeElement->addChild(utils::createNode(utils::XmlNodeType::Element, "diff"));
-    derivativeElement->addChild(bvarElement);
-    derivativeElement->addChild(newIdentifierElement(pF));
+    if (!mHoistNamespaces) {
+        pDomAttributes.emplace_back(pPrefix.empty() ? "xmlns" : "xmlns:" + pPrefix, pUri);
 
-    bvarElement->addChild(newIdentifierElement(pX));
+        return;
+    }
 
-    return derivativeElement;
+    if (mNamespaces.emplace(pPrefix, pUri).second) {
+        mMathElement->declareNamespace(pPrefix, pUri);
+    }
 }
 
 
 
-utils::XmlNodePtr Parser::newDerivativeElement(const std::string &pF,
-                                                       const std::string &pX,
-                                                       const std::string &pOrder)
+utils::XmlNodePtr Parser::sharedDomNode(const utils::XmlNodePtr &pDomNode)
+{
+    // Return the given DOM node or, if we are sharing subexpressions, the
+    // identical DOM node that we have already come across, if any
+    // Note: the given DOM node must be complete since it may end up being
+    //       shared, at which point it cannot be modified anymore...
+
+    if (!mShareSubexpressions || !mBuildDom) {
+        return pDomNode;
+    }
+
+    return mDomNodePool.intern(pDomNode);
+}
+
+
+
+utils::XmlNodePtr Parser::sharedDomNode(utils::XmlNodeType pType,
+                                        const std::string &pName,
+                                        std::span<const utils::XmlNodePtr> pChildDomNodes,
+                                        std::span<const utils::XmlAttribute> pDomAttributes)
+{
+    // Return a DOM node with the given type, name, children and attributes or,
+    // if we are sharing subexpressions, the identical DOM node that we have
+    // already come across, if any
+    // Note: we look for an identical DOM node before creating one, so that
+    //       nothing gets allocated for a DOM node that can be shared...
+
+    if (!mBuildDom) {
+        return mPlaceholderDomNode;
+    }
+
+    if (mShareSubexpressions) {
+        return mDomNodePool.intern(pType, pName, "", pDomAttributes, pChildDomNodes);
+    }
+
+    utils::XmlNodePtr res = newDomNode(pType, pName);
+
+    for (const auto &domAttribute : pDomAttributes) {
+        addDomAttribute(res, domAttribute.name(), domAttribute.value(), domAttribute.namespacePrefix());
+    }
+
+    for (const auto &childDomNode : pChildDomNodes) {
+        addChildDomNode(res, childDomNode);
+    }
+
+    return res;
+}
+
+
+
+std::size_t Parser::addSymbol(const std::string &pName,
+                              tomathml::Symbol::Role pRole)
+{
+    // Keep track of an occurrence of the given symbol, at the current position
+    // of our scanner, interning it if it is new, and return its index
+
+    auto [iter, inserted] = mSymbolIndices.emplace(pName, mSymbols.size());
+
+    if (inserted) {
+        tomathml::Symbol symbol;
+
+        symbol.name = pName;
+        symbol.line = mScanner.line();
+        symbol.column = mScanner.column();
+        symbol.role = pRole;
+
+        mSymbols.push_back(symbol);
+        mSymbolTextNodes.push_back(newDomNode(utils::XmlNodeType::Text, pName));
+    }
+
+    auto &symbol = mSymbols[iter->second];
+
+    ++symbol.count;
+
+    if (pRole < symbol.role) {
+        symbol.role = pRole;
+    }
+
+    return iter->second;
+}
+
+
+
+utils::XmlNodePtr Parser::newIdentifierElement(std::size_t pSymbol)
+{
+    // Create and return a new identifier element for the given symbol, sharing
+    // the text of its name with the other identifier elements for it
+
+    std::array childDomNodes = { sharedDomNode(mSymbolTextNodes[pSymbol]) };
+
+    return sharedDomNode(utils::XmlNodeType::Element, "ci", childDomNodes);
+}
+
+
+
+utils::XmlNodePtr Parser::newDerivativeElement(std::size_t pF,
+                                                       std::size_t pX)
 {
     // Create and return a new derivative element with the given parameters
 
-    utils::XmlNodePtr derivativeElement = utils::createNode(utils::XmlNodeType::Element, "apply");
-    utils::XmlNodePtr bvarElement = utils::createNode(utils::XmlNodeType::Element, "bvar");
-    utils::XmlNodePtr degreeElement = utils::createNode(utils::XmlNodeType::Element, "degree");
-    utils::XmlNodePtr cnElement = utils::createNode(utils::XmlNodeType::Element, "cn");
+    std::array bvarChildDomNodes = { newIdentifierElement(pX) };
+    std::array derivativeChildDomNodes = { sharedDomNode(utils::XmlNodeType::Element, "diff"),
+                                           sharedDomNode(utils::XmlNodeType::Element, "bvar", bvarChildDomNodes),
+                                           newIdentifierElement(pF) };
 
-    derivativeElement->addChild(utils::createNode(utils::XmlNodeType::Element, "diff"));
-    derivativeElement->addChild(bvarElement);
-    derivativeElement->addChild(newIdentifierElement(pF));
+    return sharedDomNode(utils::XmlNodeType::Element, "apply", derivativeChildDomNodes);
+}
 
-    bvarElement->addChild(newIdentifierElement(pX));
-    bvarElement->addChild(degreeElement);
 
-    degreeElement->addChild(cnElement);
 
-    cnElement->addChild(utils::createNode(utils::XmlNodeType::Text, pOrder));
-    if (mCellmlMode) {
-        cnElement->addAttribute("units", "dimensionless", "cellml");
-        cnElement->declareNamespace("cellml", "http://www.cellml.org/cellml/2.0#");
+template<bool CellmlMode>
+utils::XmlNodePtr Parser::newDerivativeElement(std::size_t pF,
+                                                       std::size_t pX,
+                                                       const std::string &pOrder)
+{
+    // Create and return a new derivative element with the given parameters
+
+    std::vector<utils::XmlAttribute> cnDomAttributes;
+
+    if constexpr (CellmlMode) {
+        cnDomAttributes.emplace_back("units", "dimensionless", "cellml");
+        declareNamespace(cnDomAttributes, "cellml", CellmlNamespace);
     }
 
-    return derivativeElement;
+    std::array cnChildDomNodes = { sharedDomNode(utils::XmlNodeType::Text, pOrder) };
+    std::array degreeChildDomNodes = { sharedDomNode(utils::XmlNodeType::Element, "cn", cnChildDomNodes, cnDomAttributes) };
+    std::array bvarChildDomNodes = { newIdentifierElement(pX),
+                                     sharedDomNode(utils::XmlNodeType::Element, "degree", degreeChildDomNodes) };
+    std::array derivativeChildDomNodes = { sharedDomNode(utils::XmlNodeType::Element, "diff"),
+                                           sharedDomNode(utils::XmlNodeType::Element, "bvar", bvarChildDomNodes),
+                                           newIdentifierElement(pF) };
+
+    return sharedDomNode(utils::XmlNodeType::Element, "apply", derivativeChildDomNodes);
 }
 
 
 
+template<bool CellmlMode>
 utils::XmlNodePtr Parser::newNumberElement(const std::string &pNumber,
                                                    const std::string &pUnit)
 {
     // Create and return a new number element with the given value
 
-    utils::XmlNodePtr numberElement = utils::createNode(utils::XmlNodeType::Element, "cn");
+    std::vector<utils::XmlAttribute> numberDomAttributes;
     auto ePos = utils::toUpper(pNumber).find("E");
 
-    if (ePos == std::string::npos) {
-        numberElement->addChild(utils::createNode(utils::XmlNodeType::Text, pNumber));
-    } else {
-        numberElement->addAttribute("type", "e-notation");
+    if (ePos != std::string::npos) {
+        numberDomAttributes.emplace_back("type", "e-notation");
+    }
 
-        numberElement->addChild(utils::createNode(utils::XmlNodeType::Text, utils::left(pNumber, ePos)));
-        numberElement->addChild(utils::createNode(utils::XmlNodeType::Element, "sep"));
-        numberElement->addChild(utils::createNode(utils::XmlNodeType::Text, utils::right(pNumber, pNumber.length() - ePos - 1)));
+    if constexpr (CellmlMode) {
+        numberDomAttributes.emplace_back("units", pUnit, "cellml");
+        declareNamespace(numberDomAttributes, "cellml", CellmlNamespace);
     }
 
-    if (mCellmlMode) {
-        numberElement->addAttribute("units", pUnit, "cellml");
-        numberElement->declareNamespace("cellml", "http://www.cellml.org/cellml/2.0#");
+    if (ePos == std::string::npos) {
+        std::array numberChildDomNodes = { sharedDomNode(utils::XmlNodeType::Text, pNumber) };
+
+        return sharedDomNode(utils::XmlNodeType::Element, "cn", numberChildDomNodes, numberDomAttributes);
     }
 
-    return numberElement;
+    std::array numberChildDomNodes = { sharedDomNode(utils::XmlNodeType::Text, utils::left(pNumber, ePos)),
+                                       sharedDomNode(utils::XmlNodeType::Element, "sep"),
+                                       sharedDomNode(utils::XmlNodeType::Text, utils::right(pNumber, pNumber.length() - ePos - 1)) };
+
+    return sharedDomNode(utils::XmlNodeType::Element, "cn", numberChildDomNodes, numberDomAttributes);
 }
 
 
@@ -334,52 +596,55 @@ utils::XmlNodePtr Parser::newMathematicalConstantElement(Scanner::Token pTokenTy
     // Create and return a new mathematical constant element for the given token
     // typewith the given value
 
-    return utils::createNode(utils::XmlNodeType::Element, mathmlName(pTokenType));
+    return sharedDomNode(utils::XmlNodeType::Element, mathmlName(pTokenType));
 }
 
 
 
+template<bool CellmlMode>
 utils::XmlNodePtr Parser::newMathematicalFunctionElement(Scanner::Token pTokenType,
                                                          const std::vector<utils::XmlNodePtr> &pArgumentElements)
 {
     // Create and return a new mathematical function element for the given token
     // and arguments
 
-    utils::XmlNodePtr mathematicalFunctionElement = utils::createNode(utils::XmlNodeType::Element, "apply");
+    if (!mBuildDom) {
+        return mPlaceholderDomNode;
+    }
+
+    std::vector<utils::XmlNodePtr> mathematicalFunctionChildDomNodes;
+
+    mathematicalFunctionChildDomNodes.reserve(pArgumentElements.size() + 1);
 
-    mathematicalFunctionElement->addChild(utils::createNode(utils::XmlNodeType::Element, mathmlName(pTokenType)));
+    mathematicalFunctionChildDomNodes.push_back(sharedDomNode(utils::XmlNodeType::Element, mathmlName(pTokenType)));
 
     if (pArgumentElements.size() == 2) {
-        if (pTokenType == Scanner::Token::Log) {
-            utils::XmlNodePtr logBaseElement = utils::createNode(utils::XmlNodeType::Element, "logbase");
+        std::span<const utils::XmlNodePtr> qualifierChildDomNodes(&pArgumentElements[1], 1);
 
-            logBaseElement->addChild(pArgumentElements[1]);
-            mathematicalFunctionElement->addChild(logBaseElement);
+        if (pTokenType == Scanner::Token::Log) {
+            mathematicalFunctionChildDomNodes.push_back(sharedDomNode(utils::XmlNodeType::Element, "logbase", qualifierChildDomNodes));
         } else if (pTokenType == Scanner::Token::Root) {
-            utils::XmlNodePtr degreeElement = utils::createNode(utils::XmlNodeType::Element, "degree");
-
-            degreeElement->addChild(pArgumentElements[1]);
-            mathematicalFunctionElement->addChild(degreeElement);
+            mathematicalFunctionChildDomNodes.push_back(sharedDomNode(utils::XmlNodeType::Element, "degree", qualifierChildDomNodes));
         }
     }
 
-    mathematicalFunctionElement->addChild(pArgumentElements[0]);
+    mathematicalFunctionChildDomNodes.push_back(pArgumentElements[0]);
 
     if (pArgumentElements.size() == 1) {
         if (pTokenType == Scanner::Token::Sqr) {
-            mathematicalFunctionElement->addChild(newNumberElement("2", "dimensionless"));
+            mathematicalFunctionChildDomNodes.push_back(newNumberElement<CellmlMode>("2", "dimensionless"));
         }
     } else if (   (pTokenType >= Scanner::Token::FirstTwoOrMoreArgumentMathematicalFunction)
                && (pTokenType <= Scanner::Token::LastTwoOrMoreArgumentMathematicalFunction)) {
         for (size_t i = 1, iMax = pArgumentElements.size(); i < iMax; ++i) {
-            mathematicalFunctionElement->addChild(pArgumentElements[i]);
+            mathematicalFunctionChildDomNodes.push_back(pArgumentElements[i]);
         }
     } else if (   (pTokenType != Scanner::Token::Log)
                && (pTokenType != Scanner::Token::Root)) {
-        mathematicalFunctionElement->addChild(pArgumentElements[1]);
+        mathematicalFunctionChildDomNodes.push_back(pArgumentElements[1]);
     }
 
-    return mathematicalFunctionElement;
+    return sharedDomNode(utils::XmlNodeType::Element, "apply", mathematicalFunctionChildDomNodes);
 }
 
 
@@ -564,21 +829,20 @@ bool Parser::eqToken(utils::XmlNodePtr &pDomNode)
 bool Parser::identifierOrSiUnitToken(utils::XmlNodePtr &pDomNode)
 {
     // Expect an identifier or an SI unit
+    // Note: our tokens are static locals, whose initialisation is thread safe,
+    //       since parsers may be used from several threads at once...
 
-    static Scanner::Tokens tokens;
-    static bool needInitializeTokens = true;
+    static const Scanner::Tokens Tokens = [] {
+        auto res = rangeOfTokens(Scanner::Token::FirstUnit,
+                                 Scanner::Token::LastUnit);
 
-    if (needInitializeTokens) {
-        auto tokenRange = rangeOfTokens(Scanner::Token::FirstUnit,
-                               Scanner::Token::LastUnit);
-        tokenRange.push_back(Scanner::Token::IdentifierOrCmetaId);
-        tokens = tokenRange;
+        res.push_back(Scanner::Token::IdentifierOrCmetaId);
 
-        needInitializeTokens = false;
-    }
+        return res;
+    }();
 
     return tokenType(pDomNode, "An identifier or an SI unit (e.g. 'second')",
-                     tokens);
+                     Tokens);
 }
 
 
@@ -775,10 +1039,10 @@ void Parser::parseComments(utils::XmlNodePtr &pDomNode)
                     //          have a comment before the first element of the
                     //          document (i.e. the model element)...
 
-                    auto comment = utils::createNode(utils::XmlNodeType::Comment, singleLineComments.empty() ? " " : singleLineComments);
+                    auto comment = newDomNode(utils::XmlNodeType::Comment, singleLineComments.empty() ? " " : singleLineComments);
 
                     if (pDomNode) {
-                        pDomNode->addChild(comment);
+                        addChildDomNode(pDomNode, comment);
                     }
 
                     singleLineComments = processCommentString(mScanner.string());
@@ -797,10 +1061,10 @@ void Parser::parseComments(utils::XmlNodePtr &pDomNode)
             if (prevLineCommentLine != 0) {
                 // Note: see the two notes above...
 
-                auto comment = utils::createNode(utils::XmlNodeType::Comment, singleLineComments.empty() ? " " : singleLineComments);
+                auto comment = newDomNode(utils::XmlNodeType::Comment, singleLineComments.empty() ? " " : singleLineComments);
 
                 if (pDomNode) {
-                    pDomNode->addChild(comment);
+                    addChildDomNode(pDomNode, comment);
                 }
             }
 
@@ -814,17 +1078,25 @@ void Parser::parseComments(utils::XmlNodePtr &pDomNode)
 }
 
 
+template<bool CellmlMode>
 bool Parser::parseMathematicalExpression(utils::XmlNodePtr &pDomNode,
                                                        bool pFullParsing)
 {
+    // Keep track of where our mathematical expression starts, for the
+    // messages about its units, if any
+
+    int line = mScanner.line();
+    int column = mScanner.column();
+    bool ode = mScanner.token() == Scanner::Token::Ode;
+
     // Check whether we have got an identifier or "ode"
 
     utils::XmlNodePtr lhsElement;
 
     if (mScanner.token() == Scanner::Token::IdentifierOrCmetaId) {
-        lhsElement = newIdentifierElement(mScanner.string());
+        lhsElement = newIdentifierElement(addSymbol(mScanner.string(), tomathml::Symbol::Role::Algebraic));
     } else if (mScanner.token() == Scanner::Token::Ode) {
-        lhsElement = parseDerivativeIdentifier(pDomNode);
+        lhsElement = parseDerivativeIdentifier<CellmlMode>(pDomNode, true);
     }
 
     // Check whether we have got an LHS element
@@ -892,10 +1164,10 @@ bool Parser::parseMathematicalExpression(utils::XmlNodePtr &pDomNode,
         mScanner = origScanner;
 
         rhsElement = selFunction?
-                         parseNormalMathematicalExpression(pDomNode):
-                         parsePiecewiseMathematicalExpression(pDomNode, true);
+                         parseNormalMathematicalExpression<CellmlMode>(pDomNode):
+                         parsePiecewiseMathematicalExpression<CellmlMode>(pDomNode, true);
     } else {
-        rhsElement = parseNormalMathematicalExpression(pDomNode);
+        rhsElement = parseNormalMathematicalExpression<CellmlMode>(pDomNode);
     }
 
     if (rhsElement == nullptr) {
@@ -912,8 +1184,29 @@ bool Parser::parseMathematicalExpression(utils::XmlNodePtr &pDomNode,
 
     newDomElement(applyElement, "eq");
 
-    applyElement->addChild(lhsElement);
-    applyElement->addChild(rhsElement);
+    addChildDomNode(applyElement, lhsElement);
+    addChildDomNode(applyElement, rhsElement);
+
+    // Check the units of our mathematical expression, if needed
+
+    if (CellmlMode && mCheckUnits && mBuildDom) {
+        std::vector<std::string> messages;
+
+        mUnitsChecker.check(*applyElement, messages);
+
+        for (const auto &message : messages) {
+            mMessages.push_back(ParserMessage(ParserMessage::Type::Warning,
+                                              line, column, message));
+        }
+    }
+
+    // Keep track of the number of ODEs and algebraic equations
+
+    if (ode) {
+        ++mOdeCount;
+    } else {
+        ++mAlgebraicEquationCount;
+    }
 
     return true;
 }
@@ -1169,7 +1462,9 @@ std::string Parser::mathmlName(Scanner::Token pTokenType) const
 
 
 
-utils::XmlNodePtr Parser::parseDerivativeIdentifier(utils::XmlNodePtr &pDomNode)
+template<bool CellmlMode>
+utils::XmlNodePtr Parser::parseDerivativeIdentifier(utils::XmlNodePtr &pDomNode,
+                                                  bool pLeftHandSide)
 {
     // At this stage, we have already come across "ode", so now expect "("
 
@@ -1187,9 +1482,12 @@ utils::XmlNodePtr Parser::parseDerivativeIdentifier(utils::XmlNodePtr &pDomNode)
         return {};
     }
 
-    // Keep track of our f
+    // Keep track of our f, which is a state if we are on the left-hand side of
+    // an ODE
 
-    std::string f = mScanner.string();
+    auto f = addSymbol(mScanner.string(), pLeftHandSide?
+                                              tomathml::Symbol::Role::State:
+                                              tomathml::Symbol::Role::RightHandSide);
 
     // Expect ","
 
@@ -1209,7 +1507,7 @@ utils::XmlNodePtr Parser::parseDerivativeIdentifier(utils::XmlNodePtr &pDomNode)
 
     // Keep track of our x
 
-    std::string x = mScanner.string();
+    auto x = addSymbol(mScanner.string(), tomathml::Symbol::Role::VariableOfIntegration);
 
     // Expect "," or ")"
 
@@ -1238,7 +1536,7 @@ utils::XmlNodePtr Parser::parseDerivativeIdentifier(utils::XmlNodePtr &pDomNode)
 
         std::string order = mScanner.string();
 
-        if (mCellmlMode) {
+        if constexpr (CellmlMode) {
             // Expect "{"
 
             mScanner.getNextToken();
@@ -1274,7 +1572,7 @@ utils::XmlNodePtr Parser::parseDerivativeIdentifier(utils::XmlNodePtr &pDomNode)
 
         // Return a derivative element with an order
 
-        return newDerivativeElement(f, x, order);
+        return newDerivativeElement<CellmlMode>(f, x, order);
     }
 
     // Return a derivative element with no order
@@ -1284,6 +1582,7 @@ utils::XmlNodePtr Parser::parseDerivativeIdentifier(utils::XmlNodePtr &pDomNode)
 
 
 
+template<bool CellmlMode>
 utils::XmlNodePtr Parser::parseNumber(utils::XmlNodePtr &pDomNode)
 {
     // Keep track of the number
@@ -1293,7 +1592,7 @@ utils::XmlNodePtr Parser::parseNumber(utils::XmlNodePtr &pDomNode)
     std::string number = mScanner.string();
     std::string unit = "";
 
-    if (mCellmlMode) {
+    if constexpr (CellmlMode) {
         // Expect "{"
 
         mScanner.getNextToken();
@@ -1325,11 +1624,12 @@ utils::XmlNodePtr Parser::parseNumber(utils::XmlNodePtr &pDomNode)
 
     // Return a number element
 
-    return newNumberElement(number, unit);
+    return newNumberElement<CellmlMode>(number, unit);
 }
 
 
 
+template<bool CellmlMode>
 utils::XmlNodePtr Parser::parseMathematicalFunction(utils::XmlNodePtr &pDomNode,
                                                             bool pOneArgument,
                                                             bool pTwoArguments,
@@ -1352,7 +1652,7 @@ utils::XmlNodePtr Parser::parseMathematicalFunction(utils::XmlNodePtr &pDomNode,
     mScanner.getNextToken();
 
     std::vector<utils::XmlNodePtr> argumentElements;
-    utils::XmlNodePtr argumentElement = parseNormalMathematicalExpression(pDomNode);
+    utils::XmlNodePtr argumentElement = parseNormalMathematicalExpression<CellmlMode>(pDomNode);
 
     if (argumentElement == nullptr) {
         return {};
@@ -1375,7 +1675,7 @@ utils::XmlNodePtr Parser::parseMathematicalFunction(utils::XmlNodePtr &pDomNode,
 
         mScanner.getNextToken();
 
-        argumentElement = parseNormalMathematicalExpression(pDomNode);
+        argumentElement = parseNormalMathematicalExpression<CellmlMode>(pDomNode);
 
         if (argumentElement == nullptr) {
             return {};
@@ -1392,7 +1692,7 @@ utils::XmlNodePtr Parser::parseMathematicalFunction(utils::XmlNodePtr &pDomNode,
 
         mScanner.getNextToken();
 
-        argumentElement = parseNormalMathematicalExpression(pDomNode);
+        argumentElement = parseNormalMathematicalExpression<CellmlMode>(pDomNode);
 
         if (argumentElement == nullptr) {
             return {};
@@ -1409,18 +1709,19 @@ utils::XmlNodePtr Parser::parseMathematicalFunction(utils::XmlNodePtr &pDomNode,
 
     // Return a mathematical function element
 
-    return newMathematicalFunctionElement(tokenType, argumentElements);
+    return newMathematicalFunctionElement<CellmlMode>(tokenType, argumentElements);
 }
 
 
 
+template<bool CellmlMode>
 utils::XmlNodePtr Parser::parseParenthesizedMathematicalExpression(utils::XmlNodePtr &pDomNode)
 {
     // Try to parse a normal mathematical expression
 
     mScanner.getNextToken();
 
-    utils::XmlNodePtr res = parseNormalMathematicalExpression(pDomNode);
+    utils::XmlNodePtr res = parseNormalMathematicalExpression<CellmlMode>(pDomNode);
 
     if (res == nullptr) {
         return {};
@@ -1439,6 +1740,7 @@ utils::XmlNodePtr Parser::parseParenthesizedMathematicalExpression(utils::XmlNod
 
 
 
+template<bool CellmlMode>
 utils::XmlNodePtr Parser::parseMathematicalExpressionElement(utils::XmlNodePtr &pDomNode,
                                                                      const Scanner::Tokens &pTokens,
                                                                      ParseNormalMathematicalExpressionFunction pFunction)
@@ -1458,8 +1760,12 @@ utils::XmlNodePtr Parser::parseMathematicalExpressionElement(utils::XmlNodePtr &
     }
 
     // Loop while we have a valid operator and operand
+    // Note: the children of our current apply element, if any, are kept aside
+    //       until we have all of them, so that it can be created (or shared) in
+    //       one go...
 
     Scanner::Token prevOperator = Scanner::Token::Unknown;
+    std::vector<utils::XmlNodePtr> applyChildDomNodes;
 
     while(true) {
         // Try to parse comments, if any
@@ -1471,7 +1777,11 @@ utils::XmlNodePtr Parser::parseMathematicalExpressionElement(utils::XmlNodePtr &
         Scanner::Token crtOperator = mScanner.token();
 
         if (!containsToken(pTokens, crtOperator)) {
-            return res;
+            if (!applyChildDomNodes.empty()) {
+                return sharedDomNode(utils::XmlNodeType::Element, "apply", applyChildDomNodes);
+            }
+
+            return sharedDomNode(res);
         }
 
         // Expect an operand
@@ -1497,21 +1807,22 @@ utils::XmlNodePtr Parser::parseMathematicalExpressionElement(utils::XmlNodePtr &
                                                                      Scanner::Token::Or,
                                                                      Scanner::Token::Xor };
 
-        if ((crtOperator == prevOperator) && containsToken(NaryOperators, crtOperator)) {
-            res->addChild(otherOperand);
+        if (!mBuildDom) {
+            // We are not building our DOM tree, so nothing to update
+        } else if ((crtOperator == prevOperator) && containsToken(NaryOperators, crtOperator)) {
+            applyChildDomNodes.push_back(otherOperand);
         } else {
-            // Create an apply element and populate it with our operator and two
-            // operands
-
-            utils::XmlNodePtr applyElement = utils::createNode(utils::XmlNodeType::Element, "apply");
+            // Create the apply element for our previous operator, if any, and
+            // make it our new result element, before starting a new apply
+            // element with our current operator and two operands
 
-            applyElement->addChild(utils::createNode(utils::XmlNodeType::Element, mathmlName(crtOperator)));
-            applyElement->addChild(res);
-            applyElement->addChild(otherOperand);
-
-            // Make our apply element our new result element
+            if (!applyChildDomNodes.empty()) {
+                res = sharedDomNode(utils::XmlNodeType::Element, "apply", applyChildDomNodes);
+            }
 
-            res = applyElement;
+            applyChildDomNodes = { sharedDomNode(utils::XmlNodeType::Element, mathmlName(crtOperator)),
+                                   sharedDomNode(res),
+                                   otherOperand };
         }
 
         // Keep track of our operator
@@ -1522,89 +1833,97 @@ utils::XmlNodePtr Parser::parseMathematicalExpressionElement(utils::XmlNodePtr &
 
 
 
+template<bool CellmlMode>
 utils::XmlNodePtr Parser::parseNormalMathematicalExpression(utils::XmlNodePtr &pDomNode)
 {
     // Look for "or"
 
-    return parseMathematicalExpressionElement(pDomNode,
+    return parseMathematicalExpressionElement<CellmlMode>(pDomNode,
                                               { Scanner::Token::Or },
-                                              &Parser::parseNormalMathematicalExpression2);
+                                              &Parser::parseNormalMathematicalExpression2<CellmlMode>);
 }
 
 
 
+template<bool CellmlMode>
 utils::XmlNodePtr Parser::parseNormalMathematicalExpression2(utils::XmlNodePtr &pDomNode)
 {
     // Look for "and"
 
-    return parseMathematicalExpressionElement(pDomNode,
+    return parseMathematicalExpressionElement<CellmlMode>(pDomNode,
                                               { Scanner::Token::And },
-                                              &Parser::parseNormalMathematicalExpression3);
+                                              &Parser::parseNormalMathematicalExpression3<CellmlMode>);
 }
 
 
 
+template<bool CellmlMode>
 utils::XmlNodePtr Parser::parseNormalMathematicalExpression3(utils::XmlNodePtr &pDomNode)
 {
     // Look for "xor"
 
-    return parseMathematicalExpressionElement(pDomNode,
+    return parseMathematicalExpressionElement<CellmlMode>(pDomNode,
                                               { Scanner::Token::Xor },
-                                              &Parser::parseNormalMathematicalExpression4);
+                                              &Parser::parseNormalMathematicalExpression4<CellmlMode>);
 }
 
 
 
+template<bool CellmlMode>
 utils::XmlNodePtr Parser::parseNormalMathematicalExpression4(utils::XmlNodePtr &pDomNode)
 {
     // Look for "==" or "<>"
 
-    return parseMathematicalExpressionElement(pDomNode,
+    return parseMathematicalExpressionElement<CellmlMode>(pDomNode,
                                               { Scanner::Token::EqEq,
                                                 Scanner::Token::Neq },
-                                              &Parser::parseNormalMathematicalExpression5);
+                                              &Parser::parseNormalMathematicalExpression5<CellmlMode>);
 }
 
 
 
+template<bool CellmlMode>
 utils::XmlNodePtr Parser::parseNormalMathematicalExpression5(utils::XmlNodePtr &pDomNode)
 {
     // Look for "<", ">", "<=" or ">="
 
-    return parseMathematicalExpressionElement(pDomNode,
+    return parseMathematicalExpressionElement<CellmlMode>(pDomNode,
                                               { Scanner::Token::Lt,
                                                 Scanner::Token::Gt,
                                                 Scanner::Token::Leq,
                                                 Scanner::Token::Geq },
-                                              &Parser::parseNormalMathematicalExpression6);
+                                              &Parser::parseNormalMathematicalExpression6<CellmlMode>);
 }
 
 
 
+template<bool CellmlMode>
 utils::XmlNodePtr Parser::parseNormalMathematicalExpression6(utils::XmlNodePtr &pDomNode)
 {
     // Look for "+" or "-"
 
-    return parseMathematicalExpressionElement(pDomNode,
+    return parseMathematicalExpressionElement<CellmlMode>(pDomNode,
                                               { Scanner::Token::Plus,
                                                 Scanner::Token::Minus },
-                                              &Parser::parseNormalMathematicalExpression7);
+                                              &Parser::parseNormalMathematicalExpression7<CellmlMode>);
 }
 
 
 
+template<bool CellmlMode>
 utils::XmlNodePtr Parser::parseNormalMathematicalExpression7(utils::XmlNodePtr &pDomNode)
 {
     // Look for "*" or "/"
 
-    return parseMathematicalExpressionElement(pDomNode,
+    return parseMathematicalExpressionElement<CellmlMode>(pDomNode,
                                               { Scanner::Token::Times,
                                                 Scanner::Token::Divide },
-                                              &Parser::parseNormalMathematicalExpression8);
+                                              &Parser::parseNormalMathematicalExpression8<CellmlMode>);
 }
 
 
 
+template<bool CellmlMode>
 utils::XmlNodePtr Parser::parseNormalMathematicalExpression8(utils::XmlNodePtr &pDomNode)
 {
     // Try to parse comments, if any
@@ -1625,11 +1944,11 @@ utils::XmlNodePtr Parser::parseNormalMathematicalExpression8(utils::XmlNodePtr &
         if (mScanner.token() == Scanner::Token::Not) {
             mScanner.getNextToken();
 
-            operand = parseNormalMathematicalExpression(pDomNode);
+            operand = parseNormalMathematicalExpression<CellmlMode>(pDomNode);
         } else {
             mScanner.getNextToken();
 
-            operand = parseNormalMathematicalExpression8(pDomNode);
+            operand = parseNormalMathematicalExpression8<CellmlMode>(pDomNode);
         }
 
         if (operand == nullptr) {
@@ -1639,19 +1958,18 @@ utils::XmlNodePtr Parser::parseNormalMathematicalExpression8(utils::XmlNodePtr &
         // Create and return an apply element that has been populated with our
         // operator and operand
 
-        utils::XmlNodePtr res = utils::createNode(utils::XmlNodeType::Element, "apply");
+        std::array childDomNodes = { sharedDomNode(utils::XmlNodeType::Element, mathmlName(crtOperator)),
+                                     operand };
 
-        res->addChild(utils::createNode(utils::XmlNodeType::Element, mathmlName(crtOperator)));
-        res->addChild(operand);
-
-        return res;
+        return sharedDomNode(utils::XmlNodeType::Element, "apply", childDomNodes);
     }
 
-    return parseNormalMathematicalExpression9(pDomNode);
+    return parseNormalMathematicalExpression9<CellmlMode>(pDomNode);
 }
 
 
 
+template<bool CellmlMode>
 utils::XmlNodePtr Parser::parseNormalMathematicalExpression9(utils::XmlNodePtr &pDomNode)
 {
     // Look for an identifier, "ode", a number, a mathematical constant, a
@@ -1659,68 +1977,57 @@ utils::XmlNodePtr Parser::parseNormalMathematicalExpression9(utils::XmlNodePtr &
 
     utils::XmlNodePtr res;
 
-    static Scanner::Tokens mahematicalConstantTokens;
-    static Scanner::Tokens oneArgumentMathematicalFunctionTokens;
-    static Scanner::Tokens oneOrTwoArgumentMathematicalFunctionTokens;
-    static Scanner::Tokens twoArgumentMathematicalFunctionTokens;
-    static Scanner::Tokens twoOrMoreArgumentMathematicalFunctionTokens;
-    static bool needInitializeTokens = true;
-
-    if (needInitializeTokens) {
-        mahematicalConstantTokens = rangeOfTokens(Scanner::Token::FirstMathematicalConstant,
-                                                  Scanner::Token::LastMathematicalConstant);
-        oneArgumentMathematicalFunctionTokens = rangeOfTokens(Scanner::Token::FirstOneArgumentMathematicalFunction,
-                                                              Scanner::Token::LastOneArgumentMathematicalFunction);
-        oneOrTwoArgumentMathematicalFunctionTokens = rangeOfTokens(Scanner::Token::FirstOneOrTwoArgumentMathematicalFunction,
-                                                                   Scanner::Token::LastOneOrTwoArgumentMathematicalFunction);
-        twoArgumentMathematicalFunctionTokens = rangeOfTokens(Scanner::Token::FirstTwoArgumentMathematicalFunction,
-                                                              Scanner::Token::LastTwoArgumentMathematicalFunction);
-        twoOrMoreArgumentMathematicalFunctionTokens = rangeOfTokens(Scanner::Token::FirstTwoOrMoreArgumentMathematicalFunction,
-                                                                    Scanner::Token::LastTwoOrMoreArgumentMathematicalFunction);
-
-        needInitializeTokens = false;
-    }
+    static const Scanner::Tokens MathematicalConstantTokens = rangeOfTokens(Scanner::Token::FirstMathematicalConstant,
+                                                                            Scanner::Token::LastMathematicalConstant);
+    static const Scanner::Tokens OneArgumentMathematicalFunctionTokens = rangeOfTokens(Scanner::Token::FirstOneArgumentMathematicalFunction,
+                                                                                       Scanner::Token::LastOneArgumentMathematicalFunction);
+    static const Scanner::Tokens OneOrTwoArgumentMathematicalFunctionTokens = rangeOfTokens(Scanner::Token::FirstOneOrTwoArgumentMathematicalFunction,
+                                                                                            Scanner::Token::LastOneOrTwoArgumentMathematicalFunction);
+    static const Scanner::Tokens TwoArgumentMathematicalFunctionTokens = rangeOfTokens(Scanner::Token::FirstTwoArgumentMathematicalFunction,
+                                                                                       Scanner::Token::LastTwoArgumentMathematicalFunction);
+    static const Scanner::Tokens TwoOrMoreArgumentMathematicalFunctionTokens = rangeOfTokens(Scanner::Token::FirstTwoOrMoreArgumentMathematicalFunction,
+                                                                                             Scanner::Token::LastTwoOrMoreArgumentMathematicalFunction);
 
     if (mScanner.token() == Scanner::Token::IdentifierOrCmetaId) {
         // Create an identifier element
 
-        res = newIdentifierElement(mScanner.string());
+        res = newIdentifierElement(addSymbol(mScanner.string(), tomathml::Symbol::Role::RightHandSide));
     } else if (mScanner.token() == Scanner::Token::Ode) {
         // Try to parse a derivative identifier
 
-        res = parseDerivativeIdentifier(pDomNode);
+        res = parseDerivativeIdentifier<CellmlMode>(pDomNode);
     } else if (mScanner.token() == Scanner::Token::Number) {
         // Try to parse a number
 
-        res = parseNumber(pDomNode);
-    } else if (containsToken(mahematicalConstantTokens, mScanner.token())) {
+        res = parseNumber<CellmlMode>(pDomNode);
+    } else if (containsToken(MathematicalConstantTokens, mScanner.token())) {
         // Create a mathematical constant element
 
         res = newMathematicalConstantElement(mScanner.token());
-    } else if (containsToken(oneArgumentMathematicalFunctionTokens, mScanner.token())) {
+    } else if (containsToken(OneArgumentMathematicalFunctionTokens, mScanner.token())) {
         // Try to parse a one-argument mathematical function
 
-        res = parseMathematicalFunction(pDomNode, true, false, false);
+        res = parseMathematicalFunction<CellmlMode>(pDomNode, true, false, false);
     } else if (mScanner.token() == Scanner::Token::Sel) {
         // Try to parse a piecewise statement using the sel() function
 
-        res = parsePiecewiseMathematicalExpression(pDomNode);
-    } else if (containsToken(oneOrTwoArgumentMathematicalFunctionTokens, mScanner.token())) {
+        res = parsePiecewiseMathematicalExpression<CellmlMode>(pDomNode);
+    } else if (containsToken(OneOrTwoArgumentMathematicalFunctionTokens, mScanner.token())) {
         // Try to parse a one- or two-argument mathematical function
 
-        res = parseMathematicalFunction(pDomNode, true, true, false);
-    } else if (containsToken(twoArgumentMathematicalFunctionTokens, mScanner.token())) {
+        res = parseMathematicalFunction<CellmlMode>(pDomNode, true, true, false);
+    } else if (containsToken(TwoArgumentMathematicalFunctionTokens, mScanner.token())) {
         // Try to parse a two-argument mathematical function
 
-        res = parseMathematicalFunction(pDomNode, false, true, false);
-    } else if (containsToken(twoOrMoreArgumentMathematicalFunctionTokens, mScanner.token())) {
+        res = parseMathematicalFunction<CellmlMode>(pDomNode, false, true, false);
+    } else if (containsToken(TwoOrMoreArgumentMathematicalFunctionTokens, mScanner.token())) {
         // Try to parse a two-or-more argument mathematical function
 
-        res = parseMathematicalFunction(pDomNode, false, true, true);
+        res = parseMathematicalFunction<CellmlMode>(pDomNode, false, true, true);
     } else if (mScanner.token() == Scanner::Token::OpeningBracket) {
         // Try to parse a parenthesised mathematical expression
 
-        res = parseParenthesizedMathematicalExpression(pDomNode);
+        res = parseParenthesizedMathematicalExpression<CellmlMode>(pDomNode);
     } else {
         std::string foundString = mScanner.string();
 
@@ -1742,6 +2049,7 @@ utils::XmlNodePtr Parser::parseNormalMathematicalExpression9(utils::XmlNodePtr &
 
 
 
+template<bool CellmlMode>
 utils::XmlNodePtr Parser::parsePiecewiseMathematicalExpression(utils::XmlNodePtr &pDomNode,
                                                                        bool pAllowTopPiecewiseStatement)
 {
@@ -1774,7 +2082,7 @@ utils::XmlNodePtr Parser::parsePiecewiseMathematicalExpression(utils::XmlNodePtr
                                                                              Scanner::Token::Otherwise,
                                                                              Scanner::Token::EndSel };
 
-    utils::XmlNodePtr piecewiseElement = newDomElement(mDomDocument, "piecewise");
+    utils::XmlNodePtr piecewiseElement = newDomNode(utils::XmlNodeType::Element, "piecewise");
     bool hasOtherwiseClause = false;
 
     if (selFunction) {
@@ -1796,7 +2104,7 @@ utils::XmlNodePtr Parser::parsePiecewiseMathematicalExpression(utils::XmlNodePtr
 
             mScanner.getNextToken();
 
-            conditionElement = parseNormalMathematicalExpression(piecewiseElement);
+            conditionElement = parseNormalMathematicalExpression<CellmlMode>(piecewiseElement);
 
             if (conditionElement == nullptr) {
                 return {};
@@ -1826,7 +2134,7 @@ utils::XmlNodePtr Parser::parsePiecewiseMathematicalExpression(utils::XmlNodePtr
 
         mScanner.getNextToken();
 
-        utils::XmlNodePtr expressionElement = parseNormalMathematicalExpression(piecewiseElement);
+        utils::XmlNodePtr expressionElement = parseNormalMathematicalExpression<CellmlMode>(piecewiseElement);
 
         if (expressionElement == nullptr) {
             return {};
@@ -1842,15 +2150,15 @@ utils::XmlNodePtr Parser::parsePiecewiseMathematicalExpression(utils::XmlNodePtr
         // Create and populate our piece/otherwise element, and add it to our
         // piecewise element
 
-        utils::XmlNodePtr pieceOrOtherwiseElement = newDomElement(mDomDocument, caseClause ? "piece" : "otherwise");
+        utils::XmlNodePtr pieceOrOtherwiseElement = newDomNode(utils::XmlNodeType::Element, caseClause ? "piece" : "otherwise");
 
-        pieceOrOtherwiseElement->addChild(expressionElement);
+        addChildDomNode(pieceOrOtherwiseElement, expressionElement);
 
         if (caseClause) {
-            pieceOrOtherwiseElement->addChild(conditionElement);
+            addChildDomNode(pieceOrOtherwiseElement, conditionElement);
         }
 
-        piecewiseElement->addChild(pieceOrOtherwiseElement);
+        addChildDomNode(piecewiseElement, pieceOrOtherwiseElement);
 
         // Fetch the next token and consider ourselves done if we have ")" in
         // the case of the sel() function or "endsel" otherwise
@@ -1892,4 +2200,82 @@ void Parser::setCellmlMode(bool pState)
     mCellmlMode = pState;
 }
 
+
+bool Parser::hoistNamespaces() const
+{
+    return mHoistNamespaces;
+}
+
+
+void Parser::setHoistNamespaces(bool pState)
+{
+    mHoistNamespaces = pState;
+}
+
+
+bool Parser::shareSubexpressions() const
+{
+    return mShareSubexpressions;
+}
+
+
+void Parser::setShareSubexpressions(bool pState)
+{
+    mShareSubexpressions = pState;
+}
+
+
+bool Parser::checkUnits() const
+{
+    return mCheckUnits;
+}
+
+
+void Parser::setCheckUnits(bool pState)
+{
+    mCheckUnits = pState;
+}
+
+
+bool Parser::buildDom() const
+{
+    return mBuildDom;
+}
+
+
+void Parser::setBuildDom(bool pState)
+{
+    mBuildDom = pState;
+}
+
+
+
+std::pmr::memory_resource *Parser::memoryResource() const
+{
+    // Return the memory resource from which we allocate our DOM tree
+
+    return mMemoryResource;
+}
+
+
+
+void Parser::setMemoryResource(std::pmr::memory_resource *pMemoryResource)
+{
+    // Set the memory resource from which we allocate our DOM tree, starting
+    // with our next parsing, or the default one if none is given
+    // Note: our current DOM tree, if any, was allocated from our previous
+    //       memory resource, which must therefore outlive it...
+
+    mMemoryResource = (pMemoryResource != nullptr) ? pMemoryResource : std::pmr::get_default_resource();
+}
+
+
+void printMessages(const Parser &pParser, std::ostream &pStream)
+{
+    pStream << "Messages from parser (" << pParser.messages().size() << ")\n";
+    for (const auto& msg: pParser.messages()) {
+        pStream << "[" << msg.line() << ", " << msg.column() << "]: " << msg.message() << '\n';
+    }
+}
+
 }
@@ -4,9 +4,17 @@
 
 #include <list>
 #include <map>
+#include <memory_resource>
+#include <ostream>
+#include <span>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 #include "scanner.h"
+#include "tomathml_symbols.h"
+#include "mathml/units.h"
 #include "utils/xmllite.h"
 
 namespace CellMLText {
@@ -61,21 +69,50 @@ public:
         PiecewiseEndSel
     };
 
-    bool execute(const std::string &pCellmlText);
-    bool execute(const std::string &pCellmlText, bool pFullParsing, bool cellmlMode);
+    bool execute(std::string_view pCellmlText);
+    bool execute(std::string_view pCellmlText, bool pFullParsing, bool cellmlMode);
+
+    void start(std::string_view pCellmlText, bool pCellmlMode);
+    bool parseStatements(std::size_t pCount);
+    bool atEnd() const;
 
     utils::XmlNodePtr domDocument() const;
     // utils::XmlNodePtr modelElement() const;
 
     ParserMessages messages() const;
 
+    const std::vector<tomathml::Symbol> &symbols() const;
+
+    std::size_t odeCount() const;
+    std::size_t algebraicEquationCount() const;
+
     Statement statement() const;
 
     bool cellmlMode() const;
     void setCellmlMode(bool pState);
 
+    bool hoistNamespaces() const;
+    void setHoistNamespaces(bool pState);
+
+    bool shareSubexpressions() const;
+    void setShareSubexpressions(bool pState);
+
+    bool checkUnits() const;
+    void setCheckUnits(bool pState);
+
+    bool buildDom() const;
+    void setBuildDom(bool pState);
+
+    std::pmr::memory_resource *memoryResource() const;
+    void setMemoryResource(std::pmr::memory_resource *pMemoryResource);
+
 private:
     bool mCellmlMode = true;
+    bool mHoistNamespaces = false;
+    bool mShareSubexpressions = false;
+    bool mCheckUnits = false;
+    bool mBuildDom = true;
+    std::pmr::memory_resource *mMemoryResource = std::pmr::get_default_resource();
     Scanner mScanner;
 
     utils::XmlNodePtr mDomDocument;
@@ -85,25 +122,61 @@ private:
 
     std::map<std::string, std::string> mNamespaces;
 
+    utils::XmlNodePool mDomNodePool;
+
+    mathml::UnitsChecker mUnitsChecker;
+
+    std::vector<tomathml::Symbol> mSymbols;
+    std::unordered_map<std::string, std::size_t> mSymbolIndices;
+    std::vector<utils::XmlNodePtr> mSymbolTextNodes;
+
+    std::size_t mOdeCount = 0;
+    std::size_t mAlgebraicEquationCount = 0;
+
+    utils::XmlNodePtr mPlaceholderDomNode = utils::createNode(utils::XmlNodeType::Element, "placeholder");
+
     Statement mStatement = Statement::Unknown;
 
-    void initialize(const std::string &pCellmlText, bool pCellmlMode = true);
+    void initialize(std::string_view pCellmlText, bool pCellmlMode = true);
+
+    template<bool CellmlMode>
+    bool parseMathematicalExpressions(std::size_t pCount);
 
     void addUnexpectedTokenErrorMessage(const std::string &pExpectedString,
                                         const std::string &pFoundString);
 
+    utils::XmlNodePtr newDomNode(utils::XmlNodeType pType, const std::string &pName);
+    void addChildDomNode(const utils::XmlNodePtr &pDomNode, const utils::XmlNodePtr &pChildDomNode);
+    void addDomAttribute(const utils::XmlNodePtr &pDomNode, const std::string &pName,
+                         const std::string &pValue, const std::string &pPrefix = "");
+
     utils::XmlNodePtr newDomElement(utils::XmlNodePtr pDomNode, const std::string &pElementName);
 
-    utils::XmlNodePtr newIdentifierElement(const std::string &pValue);
-    utils::XmlNodePtr newDerivativeElement(const std::string &pF, const std::string &pX);
-    utils::XmlNodePtr newDerivativeElement(const std::string &pF, const std::string &pX,
+    utils::XmlNodePtr sharedDomNode(const utils::XmlNodePtr &pDomNode);
+    utils::XmlNodePtr sharedDomNode(utils::XmlNodeType pType, const std::string &pName,
+                                    std::span<const utils::XmlNodePtr> pChildDomNodes = {},
+                                    std::span<const utils::XmlAttribute> pDomAttributes = {});
+
+    void declareNamespace(utils::XmlNodePtr &pDomElement, const std::string &pPrefix,
+                          const std::string &pUri);
+    void declareNamespace(std::vector<utils::XmlAttribute> &pDomAttributes,
+                          const std::string &pPrefix, const std::string &pUri);
+
+    std::size_t addSymbol(const std::string &pName, tomathml::Symbol::Role pRole);
+
+    utils::XmlNodePtr newIdentifierElement(std::size_t pSymbol);
+    utils::XmlNodePtr newDerivativeElement(std::size_t pF, std::size_t pX);
+    template<bool CellmlMode>
+    utils::XmlNodePtr newDerivativeElement(std::size_t pF, std::size_t pX,
                                      const std::string &pOrder);
+    template<bool CellmlMode>
     utils::XmlNodePtr newNumberElement(const std::string &pNumber, const std::string &pUnit);
     utils::XmlNodePtr newMathematicalConstantElement(Scanner::Token pTokenType);
+    template<bool CellmlMode>
     utils::XmlNodePtr newMathematicalFunctionElement(Scanner::Token pTokenType,
                                                      const std::vector<utils::XmlNodePtr> &pArgumentElements);
 
-    Scanner::Tokens rangeOfTokens(Scanner::Token pFromTokenType,
+    static Scanner::Tokens rangeOfTokens(Scanner::Token pFromTokenType,
                                                 Scanner::Token pToTokenType);
 
     bool tokenType(utils::XmlNodePtr &pDomNode, const std::string &pExpectedString,
@@ -151,6 +224,7 @@ private:
     // bool parseUnitDefinition(utils::XmlNodePtr &pDomNode);
     // bool parseComponentDefinition(utils::XmlNodePtr &pDomNode);
     // bool parseVariableDeclaration(utils::XmlNodePtr &pDomNode);
+    template<bool CellmlMode>
     bool parseMathematicalExpression(utils::XmlNodePtr &pDomNode,
                                      bool pFullParsing = true);
     // bool parseGroupDefinition(utils::XmlNodePtr &pDomNode);
@@ -159,30 +233,49 @@ private:
 
     std::string mathmlName(Scanner::Token pTokenType) const;
 
-    utils::XmlNodePtr parseDerivativeIdentifier(utils::XmlNodePtr &pDomNode);
+    template<bool CellmlMode>
+    utils::XmlNodePtr parseDerivativeIdentifier(utils::XmlNodePtr &pDomNode,
+                                                bool pLeftHandSide = false);
+    template<bool CellmlMode>
     utils::XmlNodePtr parseNumber(utils::XmlNodePtr &pDomNode);
+    template<bool CellmlMode>
     utils::XmlNodePtr parseMathematicalFunction(utils::XmlNodePtr &pDomNode, bool pOneArgument,
                                           bool pTwoArguments,
                                           bool pMoreArguments);
+    template<bool CellmlMode>
     utils::XmlNodePtr parseParenthesizedMathematicalExpression(utils::XmlNodePtr &pDomNode);
 
+    template<bool CellmlMode>
     utils::XmlNodePtr parseMathematicalExpressionElement(utils::XmlNodePtr &pDomNode,
                                                    const Scanner::Tokens &pTokens,
                                                    ParseNormalMathematicalExpressionFunction pFunction);
+    template<bool CellmlMode>
     utils::XmlNodePtr parseNormalMathematicalExpression(utils::XmlNodePtr &pDomNode);
+    template<bool CellmlMode>
     utils::XmlNodePtr parseNormalMathematicalExpression2(utils::XmlNodePtr &pDomNode);
+    template<bool CellmlMode>
     utils::XmlNodePtr parseNormalMathematicalExpression3(utils::XmlNodePtr &pDomNode);
+    template<bool CellmlMode>
     utils::XmlNodePtr parseNormalMathematicalExpression4(utils::XmlNodePtr &pDomNode);
+    template<bool CellmlMode>
     utils::XmlNodePtr parseNormalMathematicalExpression5(utils::XmlNodePtr &pDomNode);
+    template<bool CellmlMode>
     utils::XmlNodePtr parseNormalMathematicalExpression6(utils::XmlNodePtr &pDomNode);
+    template<bool CellmlMode>
     utils::XmlNodePtr parseNormalMathematicalExpression7(utils::XmlNodePtr &pDomNode);
+    template<bool CellmlMode>
     utils::XmlNodePtr parseNormalMathematicalExpression8(utils::XmlNodePtr &pDomNode);
+    template<bool CellmlMode>
     utils::XmlNodePtr parseNormalMathematicalExpression9(utils::XmlNodePtr &pDomNode);
+    template<bool CellmlMode>
     utils::XmlNodePtr parsePiecewiseMathematicalExpression(utils::XmlNodePtr &pDomNode,
                                                      bool pAllowTopPiecewiseStatement = false);
 
     // void moveTrailingComments(utils::XmlNodePtr &pFromDomNode, utils::XmlNodePtr &pToDomNode);
 };
 
+// Print the messages of the given parser in the form returned by the library.
+void printMessages(const Parser &pParser, std::ostream &pStream);
+
 }
 
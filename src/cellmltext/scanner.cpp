@@ -43,13 +43,13 @@ void Scanner::operator=(const Scanner &pScanner)
 
 
 
-void Scanner::setText(const std::string &pText)
+void Scanner::setText(std::string_view pText)
 {
     // Initialise ourselves with the text to scan
 
-    mText = pText;
+    mText.assign(pText);
 
-    mChar = &mText.at(size_t(0));
+    mChar = mText.c_str();
 
     mCharType = Char::Eof;
     mCharLine = 1;
@@ -95,6 +95,15 @@ int Scanner::column() const
 
 
 
+std::size_t Scanner::offset() const
+{
+    // Return the offset of the end of our token
+
+    return static_cast<std::size_t>(mChar-mText.data());
+}
+
+
+
 std::string Scanner::string() const
 {
     // Return our token as a string
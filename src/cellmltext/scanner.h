@@ -4,6 +4,7 @@
 #include <list>
 #include <map>
 #include <string>
+#include <string_view>
 
 namespace CellMLText {
 
@@ -98,11 +99,12 @@ public:
 
     void operator=(const Scanner &pScanner);
 
-    void setText(const std::string &pText);
+    void setText(std::string_view pText);
 
     Token token() const;
     int line() const;
     int column() const;
+    std::size_t offset() const;
     std::string string() const;
     std::string comment() const;
 
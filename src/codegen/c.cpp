@@ -0,0 +1,737 @@
+
+#include "c.h"
+
+#include <charconv>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "mathml/derivative.h"
+#include "mathml/dom.h"
+
+namespace codegen {
+
+namespace {
+
+using mathml::childElements;
+using mathml::elements;
+using mathml::text;
+
+// The <math.h> function of each MathML function that has one.
+const std::unordered_map<std::string, std::string> MathFunctions = {
+    { "abs", "fabs" },
+    { "ceiling", "ceil" },
+    { "floor", "floor" },
+    { "exp", "exp" },
+    { "ln", "log" },
+    { "rem", "fmod" },
+    { "power", "pow" },
+    { "min", "fmin" },
+    { "max", "fmax" },
+    { "sin", "sin" },
+    { "cos", "cos" },
+    { "tan", "tan" },
+    { "sinh", "sinh" },
+    { "cosh", "cosh" },
+    { "tanh", "tanh" },
+    { "arcsin", "asin" },
+    { "arccos", "acos" },
+    { "arctan", "atan" },
+    { "arcsinh", "asinh" },
+    { "arccosh", "acosh" },
+    { "arctanh", "atanh" },
+    { "gcd", "gcd" },
+    { "lcm", "lcm" }
+};
+
+// The reciprocal functions, which are computed from the <math.h> function of
+// their reciprocal or of the reciprocal of their argument.
+const std::unordered_map<std::string, std::string> ReciprocalFunctions = {
+    { "sec", "cos" },
+    { "csc", "sin" },
+    { "cot", "tan" },
+    { "sech", "cosh" },
+    { "csch", "sinh" },
+    { "coth", "tanh" }
+};
+
+const std::unordered_map<std::string, std::string> ReciprocalArgumentFunctions = {
+    { "arcsec", "acos" },
+    { "arccsc", "asin" },
+    { "arccot", "atan" },
+    { "arcsech", "acosh" },
+    { "arccsch", "asinh" },
+    { "arccoth", "atanh" }
+};
+
+const std::unordered_map<std::string, std::string> Operators = {
+    { "plus", " + " },
+    { "times", " * " },
+    { "divide", " / " },
+    { "eq", " == " },
+    { "neq", " != " },
+    { "lt", " < " },
+    { "leq", " <= " },
+    { "gt", " > " },
+    { "geq", " >= " },
+    { "and", " && " },
+    { "or", " || " }
+};
+
+const std::unordered_map<std::string, std::string> Constants = {
+    { "true", "1.0" },
+    { "false", "0.0" },
+    { "notanumber", "NAN" },
+    { "pi", "3.14159265358979323846" },
+    { "infinity", "INFINITY" },
+    { "exponentiale", "2.71828182845904523536" }
+};
+
+// Names that our variables must not shadow.
+const std::unordered_set<std::string> ReservedNames = {
+    "auto", "break", "case", "char", "const", "continue", "default", "do",
+    "double", "else", "enum", "extern", "float", "for", "goto", "if", "inline",
+    "int", "long", "register", "restrict", "return", "short", "signed",
+    "sizeof", "static", "struct", "switch", "typedef", "union", "unsigned",
+    "void", "volatile", "while",
+    "alignas", "alignof", "asm", "bool", "constexpr", "false", "nullptr",
+    "static_assert", "thread_local", "true", "typeof", "typeof_unqual",
+    "float_t", "double_t", "math_errhandling", "errno",
+    "fabs", "ceil", "floor", "exp", "log", "log10", "fmod", "pow", "sqrt",
+    "fmin", "fmax", "tgamma", "sin", "cos", "tan", "sinh", "cosh", "tanh",
+    "asin", "acos", "atan", "asinh", "acosh", "atanh", "gcd", "lcm",
+    "NAN", "INFINITY", "rhs", "states", "params", "rates", "jacobian"
+};
+
+// Prefixes of the macros that <math.h> may define, e.g. M_PI, FP_NAN,
+// MATH_ERRNO and HUGE_VALF. Names that start with two underscores, or with an
+// underscore and an uppercase letter (e.g. _Bool), are reserved too.
+
+const char* const ReservedPrefixes[] = {"M_", "FP_", "MATH_", "HUGE_VAL", "__"};
+
+bool hasReservedPrefix(const std::string& name) {
+    if ((name.size() >= 2) && (name[0] == '_') && (name[1] >= 'A') && (name[1] <= 'Z')) {
+        return true;
+    }
+
+    for (auto prefix : ReservedPrefixes) {
+        if (name.rfind(prefix, 0) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const char* const GcdFunction =
+    "static double gcd(double a, double b)\n"
+    "{\n"
+    "    a = fabs(a);\n"
+    "    b = fabs(b);\n"
+    "    while (b != 0.0) {\n"
+    "        double r = fmod(a, b);\n"
+    "        a = b;\n"
+    "        b = r;\n"
+    "    }\n"
+    "    return a;\n"
+    "}\n"
+    "\n";
+
+const char* const LcmFunction =
+    "static double lcm(double a, double b)\n"
+    "{\n"
+    "    double d = gcd(a, b);\n"
+    "    return (d == 0.0) ? 0.0 : fabs(a * b) / d;\n"
+    "}\n"
+    "\n";
+
+// A C double literal for the given number.
+std::string number(const std::string& text) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), std::strtod(text.c_str(), nullptr));
+    std::string res(buffer, result.ptr);
+
+    if (res.find_first_of(".en") == std::string::npos) {
+        res += ".0";
+    }
+
+    return (res == "inf") ? "INFINITY" : res;
+}
+
+class CGenerator {
+public:
+    CGenerator(std::string& code, std::string& error)
+        : mCode(code), mError(error), mDifferentiator(mPool) {
+    }
+
+    bool generate(const utils::XmlNodePtr& math, bool jacobian);
+
+private:
+    std::string& mCode;
+    std::string& mError;
+
+    std::unordered_map<std::string, std::string> mNames;
+    std::unordered_set<std::string> mUsedNames;
+    bool mUsesGcd = false;
+    bool mUsesLcm = false;
+
+    std::vector<std::string> mStates;
+    std::vector<utils::XmlNodePtr> mOdes;
+    std::unordered_set<std::string> mStateNames;
+    std::vector<std::string> mAlgebraicVariables;
+    std::vector<utils::XmlNodePtr> mAlgebraicEquations;
+    std::unordered_map<std::string, std::size_t> mAlgebraicIndices;
+    std::vector<std::size_t> mOrder;
+    std::vector<std::string> mParams;
+
+    utils::XmlNodePool mPool;
+    mathml::Differentiator mDifferentiator;
+    std::unordered_map<const utils::XmlNode*, std::string> mTemporaries;
+
+    bool fail(const std::string& error);
+    const std::string& name(const std::string& variable);
+    std::string uniqueName(const std::string& name);
+    void collectVariables(const utils::XmlNode& node, std::vector<std::string>& variables);
+    bool analyse(const utils::XmlNodePtr& math);
+    bool prologue(std::string& body);
+    bool rhsBody(std::string& body);
+    bool jacobianBody(std::string& body);
+    bool expression(const utils::XmlNode& node, std::string& res);
+    bool apply(const utils::XmlNode& node, std::string& res);
+    bool piecewise(const utils::XmlNode& node, std::string& res);
+};
+
+bool CGenerator::fail(const std::string& error) {
+    mError = error;
+
+    return false;
+}
+
+// The C name of the given variable, which is the variable name itself unless
+// it is reserved.
+const std::string& CGenerator::name(const std::string& variable) {
+    auto iter = mNames.find(variable);
+
+    if (iter != mNames.end()) {
+        return iter->second;
+    }
+
+    return mNames.emplace(variable, uniqueName(variable)).first->second;
+}
+
+// A C name, based on the given one, that is not reserved nor already used.
+std::string CGenerator::uniqueName(const std::string& name) {
+    // Note: appending underscores to a name with a reserved prefix would still
+    //       leave it reserved, hence we prefix it instead.
+
+    std::string res = hasReservedPrefix(name) ? "v_" + name : name;
+
+    while ((ReservedNames.count(res) != 0) || (mUsedNames.count(res) != 0)) {
+        res += '_';
+    }
+
+    mUsedNames.insert(res);
+
+    return res;
+}
+
+void CGenerator::collectVariables(const utils::XmlNode& node, std::vector<std::string>& variables) {
+    if (node.name() == "ci") {
+        variables.push_back(text(node));
+    } else {
+        for (auto child : elements(node)) {
+            collectVariables(*child, variables);
+        }
+    }
+}
+
+bool CGenerator::analyse(const utils::XmlNodePtr& math) {
+    // Sort our equations into algebraic equations and ODEs.
+
+    std::vector<utils::XmlNodePtr> rhss;
+
+    for (const auto& equation : childElements(math)) {
+        auto children = childElements(equation);
+
+        if ((equation->name() != "apply") || (children.size() != 3) || (children[0]->name() != "eq")) {
+            return fail("Only equations can be generated.");
+        }
+
+        rhss.push_back(children[2]);
+
+        const auto& lhs = *children[1];
+        auto lhsChildren = elements(lhs);
+
+        if (lhs.name() == "ci") {
+            auto variable = text(lhs);
+
+            if (!mAlgebraicIndices.emplace(variable, mAlgebraicEquations.size()).second) {
+                return fail("'" + variable + "' is computed by more than one equation.");
+            }
+
+            mAlgebraicVariables.push_back(variable);
+            mAlgebraicEquations.push_back(children[2]);
+        } else if ((lhs.name() == "apply") && (lhsChildren.size() == 3) && (lhsChildren[0]->name() == "diff")) {
+            auto state = text(*lhsChildren[2]);
+
+            if (elements(*lhsChildren[1]).size() != 1) {
+                return fail("The ODE of '" + state + "' is not of first order.");
+            }
+
+            if (!mStateNames.insert(state).second) {
+                return fail("'" + state + "' has more than one ODE.");
+            }
+
+            mStates.push_back(state);
+            mOdes.push_back(children[2]);
+        } else {
+            return fail("The left-hand side of an equation must be a variable or a derivative.");
+        }
+    }
+
+    for (const auto& variable : mAlgebraicVariables) {
+        if (mStateNames.count(variable) != 0) {
+            return fail("'" + variable + "' is both a state and computed by an equation.");
+        }
+    }
+
+    // Order our algebraic equations so that each one comes after the ones it
+    // depends on, keeping the original order where possible.
+
+    std::vector<std::vector<std::size_t>> dependents(mAlgebraicEquations.size());
+    std::vector<std::size_t> dependencyCounts(mAlgebraicEquations.size());
+
+    for (std::size_t i = 0; i < mAlgebraicEquations.size(); ++i) {
+        std::vector<std::string> variables;
+        std::unordered_set<std::size_t> dependencies;
+
+        collectVariables(*mAlgebraicEquations[i], variables);
+
+        for (const auto& variable : variables) {
+            auto iter = mAlgebraicIndices.find(variable);
+
+            if ((iter != mAlgebraicIndices.end()) && dependencies.insert(iter->second).second) {
+                dependents[iter->second].push_back(i);
+            }
+        }
+
+        dependencyCounts[i] = dependencies.size();
+    }
+
+    std::priority_queue<std::size_t, std::vector<std::size_t>, std::greater<>> ready;
+
+    for (std::size_t i = 0; i < mAlgebraicEquations.size(); ++i) {
+        if (dependencyCounts[i] == 0) {
+            ready.push(i);
+        }
+    }
+
+    while (!ready.empty()) {
+        auto i = ready.top();
+
+        ready.pop();
+        mOrder.push_back(i);
+
+        for (auto dependent : dependents[i]) {
+            if (--dependencyCounts[dependent] == 0) {
+                ready.push(dependent);
+            }
+        }
+    }
+
+    if (mOrder.size() != mAlgebraicEquations.size()) {
+        for (std::size_t i = 0; i < mAlgebraicEquations.size(); ++i) {
+            if (dependencyCounts[i] != 0) {
+                return fail("'" + mAlgebraicVariables[i] + "' is part of a cycle of algebraic equations.");
+            }
+        }
+    }
+
+    // Our parameters are the variables that no equation computes.
+
+    std::unordered_set<std::string> paramNames;
+    std::vector<std::string> variables;
+
+    for (const auto& rhs : rhss) {
+        collectVariables(*rhs, variables);
+    }
+
+    for (const auto& variable : variables) {
+        if ((mStateNames.count(variable) == 0) && (mAlgebraicIndices.count(variable) == 0)
+            && paramNames.insert(variable).second) {
+            mParams.push_back(variable);
+        }
+    }
+
+    return true;
+}
+
+// The part of a function body that loads the states and parameters, and then
+// computes the algebraic variables.
+bool CGenerator::prologue(std::string& body) {
+    for (std::size_t i = 0; i < mStates.size(); ++i) {
+        body += "    const double " + name(mStates[i]) + " = states[" + std::to_string(i) + "];\n";
+    }
+
+    for (std::size_t i = 0; i < mParams.size(); ++i) {
+        body += "    const double " + name(mParams[i]) + " = params[" + std::to_string(i) + "];\n";
+    }
+
+    for (auto i : mOrder) {
+        std::string rhs;
+
+        if (!expression(*mAlgebraicEquations[i], rhs)) {
+            return false;
+        }
+
+        body += "    const double " + name(mAlgebraicVariables[i]) + " = " + rhs + ";\n";
+    }
+
+    return true;
+}
+
+bool CGenerator::rhsBody(std::string& body) {
+    if (!prologue(body)) {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < mOdes.size(); ++i) {
+        std::string rhs;
+
+        if (!expression(*mOdes[i], rhs)) {
+            return false;
+        }
+
+        body += "    rates[" + std::to_string(i) + "] = " + rhs + ";\n";
+    }
+
+    return true;
+}
+
+bool CGenerator::jacobianBody(std::string& body) {
+    if (!prologue(body)) {
+        return false;
+    }
+
+    // Share the subterms of our equations with those of their derivatives.
+
+    for (auto& equation : mAlgebraicEquations) {
+        equation = mDifferentiator.intern(equation);
+    }
+
+    for (auto& ode : mOdes) {
+        ode = mDifferentiator.intern(ode);
+    }
+
+    // Differentiate with respect to each state in turn, going through the
+    // algebraic variables (chain rule) by giving each of them a local variable
+    // for its derivative, if it is not zero.
+
+    auto stateCount = mStates.size();
+    std::vector<std::pair<std::string, utils::XmlNodePtr>> locals;
+    std::vector<utils::XmlNodePtr> entries(stateCount * stateCount);
+
+    for (std::size_t j = 0; j < stateCount; ++j) {
+        std::unordered_map<std::string, utils::XmlNodePtr> derivatives = { { mStates[j], mDifferentiator.number(1.0) } };
+
+        for (auto i : mOrder) {
+            utils::XmlNodePtr derivative;
+
+            if (!mDifferentiator.differentiate(mAlgebraicEquations[i], derivatives, derivative, mError)) {
+                return false;
+            }
+
+            if (derivative != nullptr) {
+                // The derivative is referenced through an identifier that
+                // cannot clash with a variable.
+
+                auto key = "d(" + mAlgebraicVariables[i] + ")/d(" + mStates[j] + ")";
+
+                mNames.emplace(key, uniqueName("d_" + name(mAlgebraicVariables[i]) + "_d_" + name(mStates[j])));
+                derivatives[mAlgebraicVariables[i]] = mDifferentiator.identifier(key);
+                locals.emplace_back(key, derivative);
+            }
+        }
+
+        for (std::size_t i = 0; i < stateCount; ++i) {
+            if (!mDifferentiator.differentiate(mOdes[i], derivatives, entries[i * stateCount + j], mError)) {
+                return false;
+            }
+        }
+    }
+
+    // Subterms that are used more than once are computed once, as temporaries.
+
+    std::unordered_map<const utils::XmlNode*, std::size_t> useCounts;
+    std::function<void(const utils::XmlNode&)> countUses = [&](const utils::XmlNode& node) {
+        if (++useCounts[&node] == 1) {
+            for (auto child : elements(node)) {
+                countUses(*child);
+            }
+        }
+    };
+
+    for (const auto& local : locals) {
+        countUses(*local.second);
+    }
+
+    for (const auto& entry : entries) {
+        if (entry != nullptr) {
+            countUses(*entry);
+        }
+    }
+
+    std::unordered_set<const utils::XmlNode*> visited;
+    std::function<bool(const utils::XmlNode&)> addTemporaries = [&](const utils::XmlNode& node) {
+        if (!visited.insert(&node).second) {
+            return true;
+        }
+
+        for (auto child : elements(node)) {
+            if (!addTemporaries(*child)) {
+                return false;
+            }
+        }
+
+        if ((useCounts[&node] > 1) && ((node.name() == "apply") || (node.name() == "piecewise"))) {
+            std::string value;
+
+            if (!expression(node, value)) {
+                return false;
+            }
+
+            auto temporary = uniqueName("s" + std::to_string(mTemporaries.size()));
+
+            body += "    const double " + temporary + " = " + value + ";\n";
+            mTemporaries.emplace(&node, temporary);
+        }
+
+        return true;
+    };
+
+    for (const auto& [key, derivative] : locals) {
+        std::string value;
+
+        if (!addTemporaries(*derivative) || !expression(*derivative, value)) {
+            return false;
+        }
+
+        body += "    const double " + name(key) + " = " + value + ";\n";
+    }
+
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        std::string value = "0.0";
+
+        if ((entries[i] != nullptr) && (!addTemporaries(*entries[i]) || !expression(*entries[i], value))) {
+            return false;
+        }
+
+        body += "    jacobian[" + std::to_string(i) + "] = " + value + ";\n";
+    }
+
+    return true;
+}
+
+bool CGenerator::generate(const utils::XmlNodePtr& math, bool jacobian) {
+    std::string rhs;
+    std::string jacobianFunction;
+
+    if (!analyse(math) || !rhsBody(rhs) || (jacobian && !jacobianBody(jacobianFunction))) {
+        return false;
+    }
+
+    mCode += "#include <math.h>\n\n";
+
+    if (mUsesGcd || mUsesLcm) {
+        mCode += GcdFunction;
+    }
+
+    if (mUsesLcm) {
+        mCode += LcmFunction;
+    }
+
+    mCode += "/*\n";
+    for (std::size_t i = 0; i < mStates.size(); ++i) {
+        mCode += " * states[" + std::to_string(i) + "]: " + mStates[i] + "\n";
+    }
+    for (std::size_t i = 0; i < mParams.size(); ++i) {
+        mCode += " * params[" + std::to_string(i) + "]: " + mParams[i] + "\n";
+    }
+    mCode += " */\n";
+    mCode += "void rhs(const double *states, const double *params, double *rates)\n{\n";
+    mCode += rhs;
+    mCode += "}\n";
+
+    if (jacobian) {
+        mCode += "\n/*\n"
+                 " * jacobian[i*" + std::to_string(mStates.size()) + "+j]: d(rates[i])/d(states[j])\n"
+                 " */\n"
+                 "void jacobian(const double *states, const double *params, double *jacobian)\n{\n";
+        mCode += jacobianFunction;
+        mCode += "}\n";
+    }
+
+    return true;
+}
+
+bool CGenerator::expression(const utils::XmlNode& node, std::string& res) {
+    const auto& nodeName = node.name();
+
+    if (auto iter = mTemporaries.find(&node); iter != mTemporaries.end()) {
+        res = iter->second;
+    } else if (nodeName == "ci") {
+        res = name(text(node));
+    } else if (nodeName == "cn") {
+        res = number(text(node));
+    } else if (nodeName == "apply") {
+        return apply(node, res);
+    } else if (nodeName == "piecewise") {
+        return piecewise(node, res);
+    } else if (auto iter = Constants.find(nodeName); iter != Constants.end()) {
+        res = iter->second;
+    } else {
+        return fail("'" + nodeName + "' cannot be generated.");
+    }
+
+    return true;
+}
+
+bool CGenerator::apply(const utils::XmlNode& node, std::string& res) {
+    auto children = elements(node);
+
+    if (children.empty()) {
+        return fail("An empty apply element cannot be generated.");
+    }
+
+    const auto& op = children[0]->name();
+
+    // The qualifier of log or root, if any, comes right after the operator.
+
+    std::string qualifier;
+    std::size_t first = 1;
+
+    if ((children.size() > 1) && ((children[1]->name() == "logbase") || (children[1]->name() == "degree"))) {
+        if (!expression(*elements(*children[1]).front(), qualifier)) {
+            return false;
+        }
+
+        first = 2;
+    }
+
+    std::vector<std::string> args;
+
+    for (std::size_t i = first; i < children.size(); ++i) {
+        std::string arg;
+
+        if (!expression(*children[i], arg)) {
+            return false;
+        }
+
+        args.push_back(arg);
+    }
+
+    if (args.empty()) {
+        return fail("'" + op + "' needs arguments.");
+    }
+
+    if (op == "minus") {
+        res = (args.size() == 1) ? "(-" + args[0] + ")" : "(" + args[0] + " - " + args[1] + ")";
+    } else if (op == "not") {
+        res = "(!" + args[0] + ")";
+    } else if (op == "xor") {
+        res = "(!" + args[0] + " != !" + args[1] + ")";
+    } else if (op == "log") {
+        res = qualifier.empty() ? "log10(" + args[0] + ")" : "(log(" + args[0] + ") / log(" + qualifier + "))";
+    } else if (op == "root") {
+        res = qualifier.empty() ? "sqrt(" + args[0] + ")" : "pow(" + args[0] + ", 1.0 / " + qualifier + ")";
+    } else if (op == "factorial") {
+        res = "tgamma(" + args[0] + " + 1.0)";
+    } else if (auto iter = ReciprocalFunctions.find(op); iter != ReciprocalFunctions.end()) {
+        res = "(1.0 / " + iter->second + "(" + args[0] + "))";
+    } else if (auto iter = ReciprocalArgumentFunctions.find(op); iter != ReciprocalArgumentFunctions.end()) {
+        res = iter->second + "(1.0 / " + args[0] + ")";
+    } else if (auto iter = Operators.find(op); iter != Operators.end()) {
+        res = "(" + args[0];
+        for (std::size_t i = 1; i < args.size(); ++i) {
+            res += iter->second + args[i];
+        }
+        res += ")";
+    } else if (auto iter = MathFunctions.find(op); iter != MathFunctions.end()) {
+        // Functions of more than two arguments are nested, e.g. min(a, b, c) is
+        // fmin(fmin(a, b), c).
+
+        mUsesGcd = mUsesGcd || (op == "gcd");
+        mUsesLcm = mUsesLcm || (op == "lcm");
+
+        res = args[0];
+        for (std::size_t i = 1; i < args.size(); ++i) {
+            res = iter->second + "(" + res + ", " + args[i] + ")";
+        }
+
+        if (args.size() == 1) {
+            res = iter->second + "(" + res + ")";
+        }
+    } else {
+        return fail("'" + op + "' cannot be generated.");
+    }
+
+    return true;
+}
+
+bool CGenerator::piecewise(const utils::XmlNode& node, std::string& res) {
+    // Nested conditional expressions, which C compilers can turn into selects
+    // rather than branches when the pieces are cheap.
+
+    auto children = elements(node);
+
+    res = "NAN";
+
+    if (!children.empty() && (children.back()->name() == "otherwise")) {
+        if (!expression(*elements(*children.back()).front(), res)) {
+            return false;
+        }
+
+        children.pop_back();
+    }
+
+    for (auto piece = children.rbegin(); piece != children.rend(); ++piece) {
+        auto values = elements(**piece);
+        std::string value;
+        std::string condition;
+
+        if (!expression(*values[0], value) || !expression(*values[1], condition)) {
+            return false;
+        }
+
+        res = "(" + condition + " ? " + value + " : " + res + ")";
+    }
+
+    return true;
+}
+
+}
+
+bool generateC(const utils::XmlNodePtr& document, bool jacobian, std::string& code, std::string& error) {
+    for (const auto& child : document->children()) {
+        if ((child->type() == utils::XmlNodeType::Element) && (child->name() == "math")) {
+            std::string res;
+
+            if (!CGenerator(res, error).generate(child, jacobian)) {
+                return false;
+            }
+
+            code += res;
+
+            return true;
+        }
+    }
+
+    error = "There is no math element to generate code from.";
+
+    return false;
+}
+
+}
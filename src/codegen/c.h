@@ -0,0 +1,32 @@
+
+#pragma once
+
+#include <string>
+
+#include "utils/xmllite.h"
+
+namespace codegen {
+
+// Generate a self-contained C function computing the rates of the ODEs of the
+// given content MathML document:
+//
+//     void rhs(const double *states, const double *params, double *rates);
+//
+// The states are the variables of the ODEs, in the order of the ODEs, and so
+// are their rates. The parameters are the variables that no equation computes
+// (including the variable of integration, if it is used), in order of first
+// use. The algebraic equations are computed first, in an order that respects
+// their dependencies. Return false, with an error message, if the document
+// cannot be turned into such a function.
+//
+// If requested, also generate a function computing the Jacobian of the rates
+// with respect to the states, by symbolic differentiation:
+//
+//     void jacobian(const double *states, const double *params, double *jacobian);
+//
+// with jacobian[i*n+j] the derivative of the ith rate with respect to the jth
+// state, n being the number of states. Subterms shared by the entries of the
+// Jacobian are computed only once.
+bool generateC(const utils::XmlNodePtr& document, bool jacobian, std::string& code, std::string& error);
+
+}
@@ -0,0 +1,74 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "utils/xmllite.h"
+
+namespace eval {
+
+// Register bytecode for the right-hand sides of a set of equations.
+//
+// Every instruction reads up to three registers and writes one. Booleans are
+// 1.0 and 0.0, and anything but 0.0 is true. Piecewise expressions evaluate
+// all their pieces and pick a result with Select instructions, so that the
+// code has no branches and can run over several lanes at once.
+
+enum class OpCode : std::uint8_t {
+    // Unary: dst = op(a).
+    Neg, Not, Abs, Ceiling, Floor, Exp, Ln, Log10, Sqrt, Factorial,
+    Sin, Cos, Tan, Sec, Csc, Cot,
+    Sinh, Cosh, Tanh, Sech, Csch, Coth,
+    Arcsin, Arccos, Arctan, Arcsec, Arccsc, Arccot,
+    Arcsinh, Arccosh, Arctanh, Arcsech, Arccsch, Arccoth,
+
+    // Binary: dst = op(a, b).
+    Add, Sub, Mul, Div, Power, Root, Log, Rem, Min, Max, Gcd, Lcm,
+    Eq, Neq, Lt, Leq, Gt, Geq, And, Or, Xor,
+
+    // Ternary: dst = a? b: c.
+    Select
+};
+
+struct Instruction {
+    OpCode op;
+    std::uint32_t dst;
+    std::uint32_t a;
+    std::uint32_t b;
+    std::uint32_t c;
+};
+
+struct Program {
+    std::size_t registerCount = 0;
+
+    std::vector<std::string> inputs;
+    std::vector<std::uint32_t> inputRegisters;
+
+    std::vector<std::uint32_t> constantRegisters;
+    std::vector<double> constants;
+
+    std::vector<Instruction> code;
+
+    std::vector<std::string> outputs;
+    std::vector<std::uint32_t> outputRegisters;
+};
+
+// Compile the right-hand sides of the equations of the given content MathML
+// document. The output of an equation is named after its left-hand side, i.e.
+// "x" for an algebraic equation and "ode(x, t)" for an ODE. The variables that
+// no equation computes are the inputs of the program, while the ones that an
+// algebraic equation computes can be used by the equations that follow it.
+// Return false, with an error message, if the document cannot be compiled.
+bool compile(const utils::XmlNodePtr& document, Program& program, std::string& error);
+
+// Number of parameter sets evaluated together by run().
+constexpr std::size_t Lanes = 8;
+
+// Run the given program over count parameter sets, with inputs[i][j] the value
+// of the ith input for the jth parameter set, and similarly for the outputs.
+void run(const Program& program, const double* const* inputs, double* const* outputs, std::size_t count);
+
+}
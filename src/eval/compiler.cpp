@@ -0,0 +1,464 @@
+
+#include "bytecode.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <numbers>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "analysis/graph.h"
+#include "mathml/dom.h"
+
+namespace eval {
+
+namespace {
+
+using mathml::elements;
+using mathml::text;
+
+const std::unordered_map<std::string, OpCode> UnaryOperators = {
+    { "not", OpCode::Not },
+    { "abs", OpCode::Abs },
+    { "ceiling", OpCode::Ceiling },
+    { "floor", OpCode::Floor },
+    { "exp", OpCode::Exp },
+    { "ln", OpCode::Ln },
+    { "factorial", OpCode::Factorial },
+    { "sin", OpCode::Sin },
+    { "cos", OpCode::Cos },
+    { "tan", OpCode::Tan },
+    { "sec", OpCode::Sec },
+    { "csc", OpCode::Csc },
+    { "cot", OpCode::Cot },
+    { "sinh", OpCode::Sinh },
+    { "cosh", OpCode::Cosh },
+    { "tanh", OpCode::Tanh },
+    { "sech", OpCode::Sech },
+    { "csch", OpCode::Csch },
+    { "coth", OpCode::Coth },
+    { "arcsin", OpCode::Arcsin },
+    { "arccos", OpCode::Arccos },
+    { "arctan", OpCode::Arctan },
+    { "arcsec", OpCode::Arcsec },
+    { "arccsc", OpCode::Arccsc },
+    { "arccot", OpCode::Arccot },
+    { "arcsinh", OpCode::Arcsinh },
+    { "arccosh", OpCode::Arccosh },
+    { "arctanh", OpCode::Arctanh },
+    { "arcsech", OpCode::Arcsech },
+    { "arccsch", OpCode::Arccsch },
+    { "arccoth", OpCode::Arccoth }
+};
+
+// Operators taking exactly two arguments.
+const std::unordered_map<std::string, OpCode> BinaryOperators = {
+    { "divide", OpCode::Div },
+    { "power", OpCode::Power },
+    { "rem", OpCode::Rem },
+    { "eq", OpCode::Eq },
+    { "neq", OpCode::Neq },
+    { "lt", OpCode::Lt },
+    { "leq", OpCode::Leq },
+    { "gt", OpCode::Gt },
+    { "geq", OpCode::Geq }
+};
+
+// Operators taking two or more arguments, which are folded from the left.
+const std::unordered_map<std::string, OpCode> NaryOperators = {
+    { "plus", OpCode::Add },
+    { "times", OpCode::Mul },
+    { "min", OpCode::Min },
+    { "max", OpCode::Max },
+    { "gcd", OpCode::Gcd },
+    { "lcm", OpCode::Lcm },
+    { "and", OpCode::And },
+    { "or", OpCode::Or },
+    { "xor", OpCode::Xor }
+};
+
+const std::unordered_map<std::string, double> Constants = {
+    { "true", 1.0 },
+    { "false", 0.0 },
+    { "notanumber", std::nan("") },
+    { "pi", std::numbers::pi },
+    { "infinity", INFINITY },
+    { "exponentiale", std::numbers::e }
+};
+
+class Compiler {
+public:
+    Compiler(Program& program, std::string& error)
+        : mProgram(program), mError(error) {
+    }
+
+    bool compile(const utils::XmlNode& math);
+
+private:
+    Program& mProgram;
+    std::string& mError;
+
+    std::unordered_set<std::string> mComputedVariables;
+    std::unordered_map<std::string, std::uint32_t> mVariables;
+    std::unordered_map<std::uint64_t, std::uint32_t> mConstants;
+    std::unordered_map<const utils::XmlNode*, std::uint32_t> mNodes;
+
+    std::uint32_t newRegister();
+    std::uint32_t emit(OpCode op, std::uint32_t a, std::uint32_t b = 0, std::uint32_t c = 0);
+    std::uint32_t constant(double value);
+
+    bool fail(const std::string& error);
+    bool outputName(const utils::XmlNode& lhs, std::string& name);
+    void collectDependencies(const utils::XmlNode& node, const std::unordered_map<std::string, std::size_t>& equationIndices,
+                             std::vector<std::size_t>& dependencies);
+    bool compileExpression(const utils::XmlNode& node, std::uint32_t& reg);
+    bool compileVariable(const utils::XmlNode& node, std::uint32_t& reg);
+    bool compileApply(const utils::XmlNode& node, std::uint32_t& reg);
+    bool compilePiecewise(const utils::XmlNode& node, std::uint32_t& reg);
+};
+
+std::uint32_t Compiler::newRegister() {
+    return static_cast<std::uint32_t>(mProgram.registerCount++);
+}
+
+std::uint32_t Compiler::emit(OpCode op, std::uint32_t a, std::uint32_t b, std::uint32_t c) {
+    std::uint32_t dst = newRegister();
+
+    mProgram.code.push_back({ op, dst, a, b, c });
+
+    return dst;
+}
+
+std::uint32_t Compiler::constant(double value) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    auto [iter, inserted] = mConstants.try_emplace(bits, 0);
+
+    if (inserted) {
+        iter->second = newRegister();
+
+        mProgram.constantRegisters.push_back(iter->second);
+        mProgram.constants.push_back(value);
+    }
+
+    return iter->second;
+}
+
+bool Compiler::fail(const std::string& error) {
+    mError = error;
+
+    return false;
+}
+
+bool Compiler::outputName(const utils::XmlNode& lhs, std::string& name) {
+    if (lhs.name() == "ci") {
+        name = text(lhs);
+
+        if (!mComputedVariables.insert(name).second) {
+            return fail("'" + name + "' is computed by more than one equation.");
+        }
+
+        return true;
+    }
+
+    // An ODE, i.e. <apply><diff/><bvar><ci>t</ci>[<degree>...</degree>]</bvar><ci>x</ci></apply>.
+
+    auto children = elements(lhs);
+
+    if ((lhs.name() == "apply") && (children.size() == 3) && (children[0]->name() == "diff")) {
+        auto bvar = elements(*children[1]);
+
+        name = "ode(" + text(*children[2]) + ", " + text(*bvar[0]);
+        if (bvar.size() == 2) {
+            name += ", " + text(*elements(*bvar[1]).front());
+        }
+        name += ")";
+
+        return true;
+    }
+
+    return fail("The left-hand side of an equation must be a variable or a derivative.");
+}
+
+// The equations, given their index, that compute the variables used by the
+// given node.
+void Compiler::collectDependencies(const utils::XmlNode& node,
+                                   const std::unordered_map<std::string, std::size_t>& equationIndices,
+                                   std::vector<std::size_t>& dependencies) {
+    if (node.name() == "ci") {
+        auto iter = equationIndices.find(text(node));
+
+        if (iter != equationIndices.end()) {
+            dependencies.push_back(iter->second);
+        }
+    } else {
+        for (auto child : elements(node)) {
+            collectDependencies(*child, equationIndices, dependencies);
+        }
+    }
+}
+
+bool Compiler::compile(const utils::XmlNode& math) {
+    // Find out which variables get computed, so that we can tell them apart
+    // from the inputs of our program.
+
+    std::vector<const utils::XmlNode*> equations;
+
+    for (auto equation : elements(math)) {
+        auto children = elements(*equation);
+
+        if ((equation->name() != "apply") || (children.size() != 3) || (children[0]->name() != "eq")) {
+            return fail("Only equations can be compiled.");
+        }
+
+        std::string name;
+
+        if (!outputName(*children[1], name)) {
+            return false;
+        }
+
+        mProgram.outputs.push_back(name);
+        equations.push_back(children[2]);
+    }
+
+    // Compile our equations in BLT order, i.e. each one after the ones that
+    // compute the variables it uses, whatever their order in the text.
+
+    std::unordered_map<std::string, std::size_t> equationIndices;
+    std::vector<std::vector<std::size_t>> dependencies(equations.size());
+
+    for (std::size_t i = 0; i < equations.size(); ++i) {
+        if (mComputedVariables.count(mProgram.outputs[i]) != 0) {
+            equationIndices.emplace(mProgram.outputs[i], i);
+        }
+    }
+
+    for (std::size_t i = 0; i < equations.size(); ++i) {
+        collectDependencies(*equations[i], equationIndices, dependencies[i]);
+    }
+
+    std::vector<std::vector<std::size_t>> blocks;
+    std::vector<std::size_t> levels;
+
+    analysis::bltOrder(dependencies, blocks, levels);
+
+    mProgram.outputRegisters.resize(equations.size());
+
+    for (const auto& block : blocks) {
+        auto i = block.front();
+
+        if ((block.size() > 1) || (std::find(dependencies[i].begin(), dependencies[i].end(), i) != dependencies[i].end())) {
+            return fail("'" + mProgram.outputs[i] + "' is part of a cycle of algebraic equations.");
+        }
+
+        std::uint32_t reg;
+
+        if (!compileExpression(*equations[i], reg)) {
+            return false;
+        }
+
+        if (mComputedVariables.count(mProgram.outputs[i]) != 0) {
+            mVariables.emplace(mProgram.outputs[i], reg);
+        }
+
+        mProgram.outputRegisters[i] = reg;
+    }
+
+    return true;
+}
+
+bool Compiler::compileExpression(const utils::XmlNode& node, std::uint32_t& reg) {
+    // Subexpressions that the parser shared only need to be computed once.
+
+    auto iter = mNodes.find(&node);
+
+    if (iter != mNodes.end()) {
+        reg = iter->second;
+
+        return true;
+    }
+
+    const auto& name = node.name();
+    bool res;
+
+    if (name == "ci") {
+        res = compileVariable(node, reg);
+    } else if (name == "cn") {
+        reg = constant(std::strtod(text(node).c_str(), nullptr));
+        res = true;
+    } else if (name == "apply") {
+        res = compileApply(node, reg);
+    } else if (name == "piecewise") {
+        res = compilePiecewise(node, reg);
+    } else if (auto constantIter = Constants.find(name); constantIter != Constants.end()) {
+        reg = constant(constantIter->second);
+        res = true;
+    } else {
+        res = fail("'" + name + "' cannot be compiled.");
+    }
+
+    if (res) {
+        mNodes.emplace(&node, reg);
+    }
+
+    return res;
+}
+
+bool Compiler::compileVariable(const utils::XmlNode& node, std::uint32_t& reg) {
+    auto name = text(node);
+    auto iter = mVariables.find(name);
+
+    if (iter != mVariables.end()) {
+        reg = iter->second;
+
+        return true;
+    }
+
+    if (mComputedVariables.count(name) != 0) {
+        return fail("'" + name + "' is used before it is computed.");
+    }
+
+    reg = newRegister();
+
+    mVariables.emplace(name, reg);
+    mProgram.inputs.push_back(name);
+    mProgram.inputRegisters.push_back(reg);
+
+    return true;
+}
+
+bool Compiler::compileApply(const utils::XmlNode& node, std::uint32_t& reg) {
+    auto children = elements(node);
+
+    if (children.empty()) {
+        return fail("An empty apply element cannot be compiled.");
+    }
+
+    const auto& op = children[0]->name();
+
+    // The qualifier of log or root, if any, comes right after the operator.
+
+    const utils::XmlNode* qualifier = nullptr;
+    std::size_t first = 1;
+
+    if ((children.size() > 1) && ((children[1]->name() == "logbase") || (children[1]->name() == "degree"))) {
+        qualifier = elements(*children[1]).front();
+        first = 2;
+    }
+
+    std::vector<std::uint32_t> args;
+
+    for (std::size_t i = first; i < children.size(); ++i) {
+        std::uint32_t arg;
+
+        if (!compileExpression(*children[i], arg)) {
+            return false;
+        }
+
+        args.push_back(arg);
+    }
+
+    std::uint32_t qualifierReg = 0;
+
+    if ((qualifier != nullptr) && !compileExpression(*qualifier, qualifierReg)) {
+        return false;
+    }
+
+    if (op == "minus") {
+        if (args.size() == 1) {
+            reg = emit(OpCode::Neg, args[0]);
+        } else if (args.size() == 2) {
+            reg = emit(OpCode::Sub, args[0], args[1]);
+        } else {
+            return fail("'minus' takes one or two arguments.");
+        }
+    } else if ((op == "log") || (op == "root")) {
+        if (args.size() != 1) {
+            return fail("'" + op + "' takes one argument.");
+        }
+
+        if (qualifier == nullptr) {
+            reg = emit((op == "log") ? OpCode::Log10 : OpCode::Sqrt, args[0]);
+        } else {
+            reg = emit((op == "log") ? OpCode::Log : OpCode::Root, args[0], qualifierReg);
+        }
+    } else if (auto iter = UnaryOperators.find(op); iter != UnaryOperators.end()) {
+        if (args.size() != 1) {
+            return fail("'" + op + "' takes one argument.");
+        }
+
+        reg = emit(iter->second, args[0]);
+    } else if (auto iter = BinaryOperators.find(op); iter != BinaryOperators.end()) {
+        if (args.size() != 2) {
+            return fail("'" + op + "' takes two arguments.");
+        }
+
+        reg = emit(iter->second, args[0], args[1]);
+    } else if (auto iter = NaryOperators.find(op); iter != NaryOperators.end()) {
+        if (args.size() < 2) {
+            return fail("'" + op + "' takes two or more arguments.");
+        }
+
+        reg = args[0];
+        for (std::size_t i = 1; i < args.size(); ++i) {
+            reg = emit(iter->second, reg, args[i]);
+        }
+    } else {
+        return fail("'" + op + "' cannot be compiled.");
+    }
+
+    return true;
+}
+
+bool Compiler::compilePiecewise(const utils::XmlNode& node, std::uint32_t& reg) {
+    // The first piece whose condition holds gives the value, so select from
+    // the last piece to the first one, starting from the otherwise value (or
+    // NaN if there is none).
+
+    auto children = elements(node);
+
+    reg = constant(std::nan(""));
+
+    if (!children.empty() && (children.back()->name() == "otherwise")) {
+        if (!compileExpression(*elements(*children.back()).front(), reg)) {
+            return false;
+        }
+
+        children.pop_back();
+    }
+
+    for (auto piece = children.rbegin(); piece != children.rend(); ++piece) {
+        auto values = elements(**piece);
+        std::uint32_t value;
+        std::uint32_t condition;
+
+        if (!compileExpression(*values[0], value) || !compileExpression(*values[1], condition)) {
+            return false;
+        }
+
+        reg = emit(OpCode::Select, condition, value, reg);
+    }
+
+    return true;
+}
+
+}
+
+bool compile(const utils::XmlNodePtr& document, Program& program, std::string& error) {
+    program = Program();
+
+    for (const auto& child : document->children()) {
+        if ((child->type() == utils::XmlNodeType::Element) && (child->name() == "math")) {
+            return Compiler(program, error).compile(*child);
+        }
+    }
+
+    error = "There is no math element to compile.";
+
+    return false;
+}
+
+}
@@ -0,0 +1,281 @@
+
+#include "bytecode.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Let GCC compile our kernel for several instruction sets and pick the best
+// one at load time, so that the lanes of a block fit in one AVX-512 register,
+// or two AVX2 ones, without requiring a particular CPU. Not with
+// ThreadSanitizer, which crashes in the resolvers since they run before it is
+// initialised.
+
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__ELF__) && !defined(__SANITIZE_THREAD__)
+#    define TOMATHML_TARGET_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#    define TOMATHML_TARGET_CLONES
+#endif
+
+namespace eval {
+
+namespace {
+
+double factorial(double x) {
+    return std::tgamma(x + 1.0);
+}
+
+double gcd(double a, double b) {
+    a = std::fabs(a);
+    b = std::fabs(b);
+
+    while (b != 0.0) {
+        double r = std::fmod(a, b);
+
+        a = b;
+        b = r;
+    }
+
+    return a;
+}
+
+double lcm(double a, double b) {
+    double divisor = gcd(a, b);
+
+    return (divisor == 0.0) ? 0.0 : std::fabs(a * b) / divisor;
+}
+
+// Apply the given function to every lane of a block.
+
+template<typename Function>
+inline void lanes(double* __restrict dst, const double* __restrict a, Function function) {
+    for (std::size_t i = 0; i < Lanes; ++i) {
+        dst[i] = function(a[i]);
+    }
+}
+
+template<typename Function>
+inline void lanes(double* __restrict dst, const double* __restrict a, const double* __restrict b, Function function) {
+    for (std::size_t i = 0; i < Lanes; ++i) {
+        dst[i] = function(a[i], b[i]);
+    }
+}
+
+// Run the given program over one block of lanes, with registers holding Lanes
+// values per register and the inputs and constants already loaded.
+TOMATHML_TARGET_CLONES
+void runBlock(const Program& program, double* registers) {
+    for (const auto& instruction : program.code) {
+        double* dst = registers + instruction.dst * Lanes;
+        const double* a = registers + instruction.a * Lanes;
+        const double* b = registers + instruction.b * Lanes;
+
+        switch (instruction.op) {
+            case OpCode::Neg:
+                lanes(dst, a, [](double x) { return -x; });
+                break;
+            case OpCode::Not:
+                lanes(dst, a, [](double x) { return (x == 0.0) ? 1.0 : 0.0; });
+                break;
+            case OpCode::Abs:
+                lanes(dst, a, [](double x) { return std::fabs(x); });
+                break;
+            case OpCode::Ceiling:
+                lanes(dst, a, [](double x) { return std::ceil(x); });
+                break;
+            case OpCode::Floor:
+                lanes(dst, a, [](double x) { return std::floor(x); });
+                break;
+            case OpCode::Exp:
+                lanes(dst, a, [](double x) { return std::exp(x); });
+                break;
+            case OpCode::Ln:
+                lanes(dst, a, [](double x) { return std::log(x); });
+                break;
+            case OpCode::Log10:
+                lanes(dst, a, [](double x) { return std::log10(x); });
+                break;
+            case OpCode::Sqrt:
+                lanes(dst, a, [](double x) { return std::sqrt(x); });
+                break;
+            case OpCode::Factorial:
+                lanes(dst, a, factorial);
+                break;
+            case OpCode::Sin:
+                lanes(dst, a, [](double x) { return std::sin(x); });
+                break;
+            case OpCode::Cos:
+                lanes(dst, a, [](double x) { return std::cos(x); });
+                break;
+            case OpCode::Tan:
+                lanes(dst, a, [](double x) { return std::tan(x); });
+                break;
+            case OpCode::Sec:
+                lanes(dst, a, [](double x) { return 1.0 / std::cos(x); });
+                break;
+            case OpCode::Csc:
+                lanes(dst, a, [](double x) { return 1.0 / std::sin(x); });
+                break;
+            case OpCode::Cot:
+                lanes(dst, a, [](double x) { return 1.0 / std::tan(x); });
+                break;
+            case OpCode::Sinh:
+                lanes(dst, a, [](double x) { return std::sinh(x); });
+                break;
+            case OpCode::Cosh:
+                lanes(dst, a, [](double x) { return std::cosh(x); });
+                break;
+            case OpCode::Tanh:
+                lanes(dst, a, [](double x) { return std::tanh(x); });
+                break;
+            case OpCode::Sech:
+                lanes(dst, a, [](double x) { return 1.0 / std::cosh(x); });
+                break;
+            case OpCode::Csch:
+                lanes(dst, a, [](double x) { return 1.0 / std::sinh(x); });
+                break;
+            case OpCode::Coth:
+                lanes(dst, a, [](double x) { return 1.0 / std::tanh(x); });
+                break;
+            case OpCode::Arcsin:
+                lanes(dst, a, [](double x) { return std::asin(x); });
+                break;
+            case OpCode::Arccos:
+                lanes(dst, a, [](double x) { return std::acos(x); });
+                break;
+            case OpCode::Arctan:
+                lanes(dst, a, [](double x) { return std::atan(x); });
+                break;
+            case OpCode::Arcsec:
+                lanes(dst, a, [](double x) { return std::acos(1.0 / x); });
+                break;
+            case OpCode::Arccsc:
+                lanes(dst, a, [](double x) { return std::asin(1.0 / x); });
+                break;
+            case OpCode::Arccot:
+                lanes(dst, a, [](double x) { return std::atan(1.0 / x); });
+                break;
+            case OpCode::Arcsinh:
+                lanes(dst, a, [](double x) { return std::asinh(x); });
+                break;
+            case OpCode::Arccosh:
+                lanes(dst, a, [](double x) { return std::acosh(x); });
+                break;
+            case OpCode::Arctanh:
+                lanes(dst, a, [](double x) { return std::atanh(x); });
+                break;
+            case OpCode::Arcsech:
+                lanes(dst, a, [](double x) { return std::acosh(1.0 / x); });
+                break;
+            case OpCode::Arccsch:
+                lanes(dst, a, [](double x) { return std::asinh(1.0 / x); });
+                break;
+            case OpCode::Arccoth:
+                lanes(dst, a, [](double x) { return std::atanh(1.0 / x); });
+                break;
+            case OpCode::Add:
+                lanes(dst, a, b, [](double x, double y) { return x + y; });
+                break;
+            case OpCode::Sub:
+                lanes(dst, a, b, [](double x, double y) { return x - y; });
+                break;
+            case OpCode::Mul:
+                lanes(dst, a, b, [](double x, double y) { return x * y; });
+                break;
+            case OpCode::Div:
+                lanes(dst, a, b, [](double x, double y) { return x / y; });
+                break;
+            case OpCode::Power:
+                lanes(dst, a, b, [](double x, double y) { return std::pow(x, y); });
+                break;
+            case OpCode::Root:
+                lanes(dst, a, b, [](double x, double y) { return std::pow(x, 1.0 / y); });
+                break;
+            case OpCode::Log:
+                lanes(dst, a, b, [](double x, double y) { return std::log(x) / std::log(y); });
+                break;
+            case OpCode::Rem:
+                lanes(dst, a, b, [](double x, double y) { return std::fmod(x, y); });
+                break;
+            case OpCode::Min:
+                lanes(dst, a, b, [](double x, double y) { return (y < x) ? y : x; });
+                break;
+            case OpCode::Max:
+                lanes(dst, a, b, [](double x, double y) { return (x < y) ? y : x; });
+                break;
+            case OpCode::Gcd:
+                lanes(dst, a, b, gcd);
+                break;
+            case OpCode::Lcm:
+                lanes(dst, a, b, lcm);
+                break;
+            case OpCode::Eq:
+                lanes(dst, a, b, [](double x, double y) { return (x == y) ? 1.0 : 0.0; });
+                break;
+            case OpCode::Neq:
+                lanes(dst, a, b, [](double x, double y) { return (x != y) ? 1.0 : 0.0; });
+                break;
+            case OpCode::Lt:
+                lanes(dst, a, b, [](double x, double y) { return (x < y) ? 1.0 : 0.0; });
+                break;
+            case OpCode::Leq:
+                lanes(dst, a, b, [](double x, double y) { return (x <= y) ? 1.0 : 0.0; });
+                break;
+            case OpCode::Gt:
+                lanes(dst, a, b, [](double x, double y) { return (x > y) ? 1.0 : 0.0; });
+                break;
+            case OpCode::Geq:
+                lanes(dst, a, b, [](double x, double y) { return (x >= y) ? 1.0 : 0.0; });
+                break;
+            case OpCode::And:
+                lanes(dst, a, b, [](double x, double y) { return ((x != 0.0) && (y != 0.0)) ? 1.0 : 0.0; });
+                break;
+            case OpCode::Or:
+                lanes(dst, a, b, [](double x, double y) { return ((x != 0.0) || (y != 0.0)) ? 1.0 : 0.0; });
+                break;
+            case OpCode::Xor:
+                lanes(dst, a, b, [](double x, double y) { return ((x != 0.0) != (y != 0.0)) ? 1.0 : 0.0; });
+                break;
+            case OpCode::Select: {
+                const double* c = registers + instruction.c * Lanes;
+
+                for (std::size_t i = 0; i < Lanes; ++i) {
+                    dst[i] = (a[i] != 0.0) ? b[i] : c[i];
+                }
+
+                break;
+            }
+        }
+    }
+}
+
+}
+
+void run(const Program& program, const double* const* inputs, double* const* outputs, std::size_t count) {
+    std::vector<double> registers(program.registerCount * Lanes);
+
+    for (std::size_t i = 0; i < program.constants.size(); ++i) {
+        std::fill_n(registers.begin() + program.constantRegisters[i] * Lanes, Lanes, program.constants[i]);
+    }
+
+    for (std::size_t first = 0; first < count; first += Lanes) {
+        std::size_t laneCount = std::min(Lanes, count - first);
+
+        // Load our inputs, padding the lanes of a last partial block with the
+        // values of its first lane, so that they compute something sensible.
+
+        for (std::size_t i = 0; i < program.inputs.size(); ++i) {
+            double* reg = registers.data() + program.inputRegisters[i] * Lanes;
+
+            std::copy_n(inputs[i] + first, laneCount, reg);
+            std::fill(reg + laneCount, reg + Lanes, inputs[i][first]);
+        }
+
+        runBlock(program, registers.data());
+
+        for (std::size_t i = 0; i < program.outputs.size(); ++i) {
+            std::copy_n(registers.data() + program.outputRegisters[i] * Lanes, laneCount, outputs[i] + first);
+        }
+    }
+}
+
+}
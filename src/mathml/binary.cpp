@@ -0,0 +1,354 @@
+
+#include "binary.h"
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <limits>
+
+namespace mathml {
+
+namespace {
+
+const unsigned char Magic[] = { 'T', 'M', 'B' };
+const unsigned char Version = 1;
+
+// The seeds of our name dictionary and string table.
+// Note: these lists are part of the encoding, so entries may only ever be
+//       appended to them. The names mirror those used by
+//       CellMLText::Parser::mathmlName()...
+
+const char* const SeedNames[] = {
+    "math", "apply", "eq", "ci", "cn", "sep", "diff", "bvar", "degree",
+    "logbase", "piecewise", "piece", "otherwise",
+    "and", "or", "xor", "not",
+    "abs", "ceiling", "exp", "factorial", "floor", "ln", "power", "root",
+    "min", "max", "gcd", "lcm",
+    "sin", "cos", "tan", "sec", "csc", "cot",
+    "sinh", "cosh", "tanh", "sech", "csch", "coth",
+    "arcsin", "arccos", "arctan", "arcsec", "arccsc", "arccot",
+    "arcsinh", "arccosh", "arctanh", "arcsech", "arccsch", "arccoth",
+    "log", "rem",
+    "true", "false", "notanumber", "pi", "infinity", "exponentiale",
+    "neq", "lt", "leq", "gt", "geq",
+    "plus", "minus", "times", "divide",
+    "xmlns", "xmlns:cellml", "cellml:units", "type"
+};
+
+const char* const SeedStrings[] = {
+    "http://www.w3.org/1998/Math/MathML",
+    "http://www.cellml.org/cellml/2.0#",
+    "e-notation",
+    "dimensionless"
+};
+
+template<std::size_t N>
+std::unordered_map<std::string, std::size_t> seededEntries(const char* const (&seeds)[N]) {
+    std::unordered_map<std::string, std::size_t> entries;
+
+    for (std::size_t i = 0; i < N; ++i) {
+        entries.emplace(seeds[i], i);
+    }
+
+    return entries;
+}
+
+template<std::size_t N>
+std::deque<std::string> seededTable(const char* const (&seeds)[N]) {
+    return std::deque<std::string>(std::begin(seeds), std::end(seeds));
+}
+
+// Return whether the given text is the shortest representation of a double,
+// in which case it can be encoded as that double without any loss.
+bool exactDouble(std::string_view text, double& value) {
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+
+    if ((error != std::errc()) || (end != text.data() + text.size())) {
+        return false;
+    }
+
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+
+    return (result.ec == std::errc()) && (std::string_view(buffer, result.ptr - buffer) == text);
+}
+
+class BinaryReader {
+public:
+    BinaryReader(const unsigned char* data, std::size_t size)
+        : mData(data), mEnd(data + size), mNames(seededTable(SeedNames)), mStrings(seededTable(SeedStrings)) {
+    }
+
+    bool read(tomathml::EventHandler& handler);
+
+private:
+    const unsigned char* mData;
+    const unsigned char* mEnd;
+    std::deque<std::string> mNames;
+    std::deque<std::string> mStrings;
+
+    bool readVarint(std::size_t& value);
+    bool readBytes(std::string_view& bytes);
+    bool readReference(std::deque<std::string>& entries, std::string_view& entry);
+};
+
+bool BinaryReader::readVarint(std::size_t& value) {
+    // Decode into 64 bits, rejecting a varint that is longer than it needs to
+    // be, or whose value does not fit in 64 bits or in a std::size_t.
+
+    std::uint64_t res = 0;
+
+    for (unsigned int shift = 0; (mData != mEnd) && (shift < 64); shift += 7) {
+        unsigned char byte = *mData++;
+        std::uint64_t bits = byte & 0x7f;
+
+        if ((shift == 63) && (bits > 1)) {
+            return false;
+        }
+
+        res |= bits << shift;
+
+        if ((byte & 0x80) == 0) {
+            if ((byte == 0) && (shift != 0)) {
+                return false;
+            }
+
+            if constexpr (sizeof(std::size_t) < sizeof(std::uint64_t)) {
+                if (res > std::numeric_limits<std::size_t>::max()) {
+                    return false;
+                }
+            }
+
+            value = static_cast<std::size_t>(res);
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool BinaryReader::readBytes(std::string_view& bytes) {
+    std::size_t length;
+
+    if (!readVarint(length) || (length > std::size_t(mEnd - mData))) {
+        return false;
+    }
+
+    bytes = std::string_view(reinterpret_cast<const char*>(mData), length);
+    mData += length;
+
+    return true;
+}
+
+bool BinaryReader::readReference(std::deque<std::string>& entries, std::string_view& entry) {
+    std::size_t reference;
+
+    if (!readVarint(reference)) {
+        return false;
+    }
+
+    if (reference == 0) {
+        std::string_view bytes;
+
+        if (!readBytes(bytes)) {
+            return false;
+        }
+
+        entries.emplace_back(bytes);
+        entry = entries.back();
+
+        return true;
+    }
+
+    if (reference > entries.size()) {
+        return false;
+    }
+
+    entry = entries[reference - 1];
+
+    return true;
+}
+
+bool BinaryReader::read(tomathml::EventHandler& handler) {
+    if ((std::size_t(mEnd - mData) < sizeof(Magic) + 1)
+        || (std::memcmp(mData, Magic, sizeof(Magic)) != 0)
+        || (mData[sizeof(Magic)] != Version)) {
+        return false;
+    }
+
+    mData += sizeof(Magic) + 1;
+
+    std::vector<std::string_view> elements;
+    std::vector<tomathml::Attribute> attributes;
+
+    while (mData != mEnd) {
+        auto record = static_cast<BinaryRecord>(*mData++);
+
+        switch (record) {
+            case BinaryRecord::End:
+                return elements.empty() && (mData == mEnd);
+            case BinaryRecord::StartElement: {
+                std::string_view name;
+                std::size_t attributeCount;
+
+                if (!readReference(mNames, name) || !readVarint(attributeCount)
+                    || (attributeCount > std::size_t(mEnd - mData))) {
+                    return false;
+                }
+
+                attributes.clear();
+                for (std::size_t i = 0; i < attributeCount; ++i) {
+                    tomathml::Attribute attribute;
+
+                    if (!readReference(mNames, attribute.name) || !readReference(mStrings, attribute.value)) {
+                        return false;
+                    }
+
+                    attributes.push_back(attribute);
+                }
+
+                elements.push_back(name);
+                handler.startElement(name, attributes);
+                break;
+            }
+            case BinaryRecord::EndElement:
+                if (elements.empty()) {
+                    return false;
+                }
+
+                handler.endElement(elements.back());
+                elements.pop_back();
+                break;
+            case BinaryRecord::Text: {
+                std::string_view text;
+
+                if (!readReference(mStrings, text)) {
+                    return false;
+                }
+
+                handler.text(text);
+                break;
+            }
+            case BinaryRecord::Number: {
+                if (mEnd - mData < 8) {
+                    return false;
+                }
+
+                std::uint64_t bits = 0;
+                for (int i = 0; i < 8; ++i) {
+                    bits |= std::uint64_t(*mData++) << (8 * i);
+                }
+
+                double value;
+                std::memcpy(&value, &bits, sizeof(value));
+
+                char buffer[32];
+                auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+
+                handler.text(std::string_view(buffer, result.ptr - buffer));
+                break;
+            }
+            case BinaryRecord::Comment: {
+                std::string_view comment;
+
+                if (!readBytes(comment)) {
+                    return false;
+                }
+
+                handler.comment(comment);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+
+    // We ran out of data before the end of the encoding.
+
+    return false;
+}
+
+}
+
+BinaryWriter::BinaryWriter(std::vector<unsigned char>& output)
+    : mOutput(output), mNames(seededEntries(SeedNames)), mStrings(seededEntries(SeedStrings)) {
+    mOutput.insert(mOutput.end(), std::begin(Magic), std::end(Magic));
+    mOutput.push_back(Version);
+}
+
+void BinaryWriter::writeVarint(std::size_t value) {
+    while (value >= 0x80) {
+        mOutput.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+
+    mOutput.push_back(static_cast<unsigned char>(value));
+}
+
+void BinaryWriter::writeBytes(std::string_view bytes) {
+    writeVarint(bytes.size());
+    mOutput.insert(mOutput.end(), bytes.begin(), bytes.end());
+}
+
+void BinaryWriter::writeReference(std::unordered_map<std::string, std::size_t>& entries, std::string_view entry) {
+    auto [iter, inserted] = entries.try_emplace(std::string(entry), entries.size());
+
+    if (inserted) {
+        writeVarint(0);
+        writeBytes(entry);
+    } else {
+        writeVarint(iter->second + 1);
+    }
+}
+
+void BinaryWriter::startElement(std::string_view name, std::span<const tomathml::Attribute> attributes) {
+    mOutput.push_back(static_cast<unsigned char>(BinaryRecord::StartElement));
+    writeReference(mNames, name);
+    writeVarint(attributes.size());
+    for (const auto& attribute : attributes) {
+        writeReference(mNames, attribute.name);
+        writeReference(mStrings, attribute.value);
+    }
+
+    mNumberElements.push_back(name == "cn");
+}
+
+void BinaryWriter::endElement(std::string_view) {
+    mOutput.push_back(static_cast<unsigned char>(BinaryRecord::EndElement));
+
+    mNumberElements.pop_back();
+}
+
+void BinaryWriter::text(std::string_view text) {
+    double value;
+
+    if (!mNumberElements.empty() && mNumberElements.back() && exactDouble(text, value)) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        mOutput.push_back(static_cast<unsigned char>(BinaryRecord::Number));
+        for (int i = 0; i < 8; ++i) {
+            mOutput.push_back(static_cast<unsigned char>(bits >> (8 * i)));
+        }
+    } else {
+        mOutput.push_back(static_cast<unsigned char>(BinaryRecord::Text));
+        writeReference(mStrings, text);
+    }
+}
+
+void BinaryWriter::comment(std::string_view comment) {
+    mOutput.push_back(static_cast<unsigned char>(BinaryRecord::Comment));
+    writeBytes(comment);
+}
+
+void BinaryWriter::finish() {
+    mOutput.push_back(static_cast<unsigned char>(BinaryRecord::End));
+}
+
+bool readBinary(const unsigned char* data, std::size_t size, tomathml::EventHandler& handler) {
+    return BinaryReader(data, size).read(handler);
+}
+
+}
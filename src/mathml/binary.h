@@ -0,0 +1,75 @@
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tomathml_events.h"
+
+namespace mathml {
+
+// Compact binary encoding of content MathML.
+//
+// An encoding starts with the magic bytes "TMB" and a version byte, and is
+// followed by a sequence of records, each starting with a record type byte:
+//
+//     StartElement  <name> <attribute count> (<name> <string>)*
+//     EndElement
+//     Text          <string>
+//     Number        <8-byte little-endian IEEE 754 double>
+//     Comment       <length> <bytes>
+//     End
+//
+// Counts and lengths are unsigned LEB128 varints. A <name> is a reference to
+// the name dictionary and a <string> a reference to the string table: 0 means
+// that a new entry follows, as a length and its bytes, and gets appended to the
+// dictionary/table, while n refers to the (n-1)th entry. Both are seeded with
+// the fixed MathML vocabulary, so that the common names and strings never need
+// to be spelled out. Entries are defined on first use, so an encoding can be
+// written and read in a single pass.
+//
+// Numbers are the text of <cn> elements that a double represents exactly, i.e.
+// that is the shortest representation of its double value. Any other text of
+// a <cn> element is encoded as a string, so that decoding is lossless.
+
+enum class BinaryRecord : unsigned char {
+    End,
+    StartElement,
+    EndElement,
+    Text,
+    Number,
+    Comment
+};
+
+// Handler encoding the events it is given, appending them to a buffer.
+class BinaryWriter: public tomathml::EventHandler {
+public:
+    explicit BinaryWriter(std::vector<unsigned char>& output);
+
+    void startElement(std::string_view name, std::span<const tomathml::Attribute> attributes) override;
+    void endElement(std::string_view name) override;
+    void text(std::string_view text) override;
+    void comment(std::string_view comment) override;
+
+    // Mark the end of the encoding.
+    void finish();
+
+private:
+    std::vector<unsigned char>& mOutput;
+    std::unordered_map<std::string, std::size_t> mNames;
+    std::unordered_map<std::string, std::size_t> mStrings;
+    std::vector<bool> mNumberElements;
+
+    void writeVarint(std::size_t value);
+    void writeBytes(std::string_view bytes);
+    void writeReference(std::unordered_map<std::string, std::size_t>& entries, std::string_view entry);
+};
+
+// Decode the given encoding and report it to the given handler. Return false
+// if the encoding is invalid, in which case the handler may have been given
+// part of the document.
+bool readBinary(const unsigned char* data, std::size_t size, tomathml::EventHandler& handler);
+
+}
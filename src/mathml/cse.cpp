@@ -0,0 +1,210 @@
+#include "cse.h"
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "dom.h"
+
+namespace mathml {
+
+namespace {
+
+bool isOperation(const utils::XmlNode& node) {
+    return (node.name() == "apply") || (node.name() == "piecewise");
+}
+
+bool isEquation(const utils::XmlNode& node) {
+    auto children = elements(node);
+
+    return (node.name() == "apply") && (children.size() == 3) && (children[0]->name() == "eq");
+}
+
+class Eliminator {
+public:
+    explicit Eliminator(std::size_t minimumCost)
+        : mMinimumCost(minimumCost) {
+    }
+
+    void eliminate(utils::XmlNode& math);
+
+private:
+    struct Subexpression {
+        std::size_t uses = 0;
+        std::size_t cost = 0;
+    };
+
+    std::size_t mMinimumCost;
+    std::unordered_map<const utils::XmlNode*, Subexpression> mSubexpressions;
+    std::unordered_set<std::string> mNames;
+    std::unordered_map<const utils::XmlNode*, utils::XmlNodePtr> mRewrites;
+    std::vector<utils::XmlNodePtr> mEquations;
+    std::size_t mTemporaryCount = 0;
+
+    std::size_t count(const utils::XmlNode& node);
+    bool isCommon(const utils::XmlNode& node) const;
+    std::string temporaryName();
+    utils::XmlNodePtr rewrite(const utils::XmlNodePtr& node);
+};
+
+// Count the uses of the operations of the given expression, and return its
+// cost. The operands of an operation are only counted the first time we come
+// across it, since it will be computed only once if it is common.
+
+std::size_t Eliminator::count(const utils::XmlNode& node) {
+    if (node.type() != utils::XmlNodeType::Element) {
+        return 0;
+    }
+
+    if (node.name() == "ci") {
+        mNames.insert(text(node));
+
+        return 0;
+    }
+
+    auto operation = isOperation(node);
+
+    if (operation) {
+        auto& subexpression = mSubexpressions[&node];
+
+        if (subexpression.uses++ != 0) {
+            return subexpression.cost;
+        }
+    }
+
+    std::size_t cost = operation ? 1 : 0;
+
+    for (const auto& child : node.children()) {
+        cost += count(*child);
+    }
+
+    if (operation) {
+        mSubexpressions[&node].cost = cost;
+    }
+
+    return cost;
+}
+
+bool Eliminator::isCommon(const utils::XmlNode& node) const {
+    auto iter = mSubexpressions.find(&node);
+
+    return (iter != mSubexpressions.end()) && (iter->second.uses > 1) && (iter->second.cost >= mMinimumCost);
+}
+
+std::string Eliminator::temporaryName() {
+    std::string res;
+
+    do {
+        res = "tmp_" + std::to_string(++mTemporaryCount);
+    } while (mNames.contains(res));
+
+    return res;
+}
+
+utils::XmlNodePtr Eliminator::rewrite(const utils::XmlNodePtr& node) {
+    auto iter = mRewrites.find(node.get());
+
+    if (iter != mRewrites.end()) {
+        return iter->second;
+    }
+
+    // Rewrite the operands first, so that the common subexpressions they use
+    // get computed before us.
+
+    auto res = node;
+    std::vector<utils::XmlNodePtr> children;
+    bool changed = false;
+
+    for (const auto& child : node->children()) {
+        children.push_back(rewrite(child));
+
+        changed = changed || (children.back() != child);
+    }
+
+    if (changed) {
+        res = utils::createNode(node->type(), node->name(), node->namespacePrefix());
+
+        for (const auto& attribute : node->attributes()) {
+            res->addAttribute(attribute.name(), attribute.value(), attribute.namespacePrefix());
+        }
+
+        for (const auto& child : children) {
+            res->addChild(child);
+        }
+    }
+
+    if (isCommon(*node)) {
+        auto name = temporaryName();
+        auto equation = utils::createNode(utils::XmlNodeType::Element, "apply");
+        auto variable = utils::createNode(utils::XmlNodeType::Element, "ci");
+
+        variable->addChild(utils::createNode(utils::XmlNodeType::Text, name));
+
+        equation->addChild(utils::createNode(utils::XmlNodeType::Element, "eq"));
+        equation->addChild(variable);
+        equation->addChild(res);
+
+        mEquations.push_back(equation);
+
+        res = variable;
+    }
+
+    mRewrites.emplace(node.get(), res);
+
+    return res;
+}
+
+void Eliminator::eliminate(utils::XmlNode& math) {
+    // Count the uses of the operations of the right-hand sides of our
+    // equations, and the names of all our variables. The left-hand side of an
+    // equation, e.g. the derivative of an ODE, is not to be eliminated.
+
+    for (const auto& child : math.children()) {
+        if (isEquation(*child)) {
+            auto sides = elements(*child);
+
+            count(*sides[1]);
+            mSubexpressions.erase(sides[1]);
+
+            count(*sides[2]);
+        }
+    }
+
+    for (const auto& child : math.children()) {
+        if (!isEquation(*child)) {
+            mEquations.push_back(child);
+
+            continue;
+        }
+
+        auto sides = childElements(child);
+        auto rhs = rewrite(sides[2]);
+
+        if (rhs == sides[2]) {
+            mEquations.push_back(child);
+        } else {
+            auto equation = utils::createNode(utils::XmlNodeType::Element, "apply");
+
+            equation->addChild(sides[0]);
+            equation->addChild(sides[1]);
+            equation->addChild(rhs);
+
+            mEquations.push_back(equation);
+        }
+    }
+
+    math.setChildren(std::move(mEquations));
+}
+
+}
+
+void eliminateCommonSubexpressions(const utils::XmlNodePtr& document, std::size_t minimumCost) {
+    for (const auto& child : document->children()) {
+        if ((child->type() == utils::XmlNodeType::Element) && (child->name() == "math")) {
+            Eliminator(minimumCost).eliminate(*child);
+        }
+    }
+}
+
+}
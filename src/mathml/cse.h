@@ -0,0 +1,19 @@
+
+#pragma once
+
+#include <cstddef>
+
+#include "utils/xmllite.h"
+
+namespace mathml {
+
+// Common subexpression elimination on the equations of a content MathML
+// document, which must share identical subexpressions (see
+// XmlNodePool). Every operation (apply or piecewise element) that is used more
+// than once and whose cost, i.e. its number of operations, is at least the
+// given minimum cost is computed once by a new tmp_N = ... equation, placed
+// just before the first equation that uses it, and replaced by tmp_N wherever
+// it is used. The new names do not collide with any variable of the document.
+void eliminateCommonSubexpressions(const utils::XmlNodePtr& document, std::size_t minimumCost);
+
+}
@@ -0,0 +1,459 @@
+
+#include "derivative.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+
+#include "dom.h"
+
+namespace mathml {
+
+namespace {
+
+bool isNumber(const utils::XmlNodePtr& node, double value) {
+    return (node != nullptr) && (node->name() == "cn") && (std::strtod(text(*node).c_str(), nullptr) == value);
+}
+
+// The operators whose result is piecewise constant, and whose derivative is
+// therefore zero wherever it is defined.
+bool isPiecewiseConstant(const std::string& op) {
+    return (op == "ceiling") || (op == "floor") || (op == "gcd") || (op == "lcm")
+           || (op == "eq") || (op == "neq") || (op == "lt") || (op == "leq") || (op == "gt") || (op == "geq")
+           || (op == "and") || (op == "or") || (op == "xor") || (op == "not");
+}
+
+}
+
+Differentiator::Differentiator(utils::XmlNodePool& pool)
+    : mPool(pool) {
+}
+
+bool Differentiator::differentiate(const utils::XmlNodePtr& expression,
+                                   const std::unordered_map<std::string, utils::XmlNodePtr>& derivatives,
+                                   utils::XmlNodePtr& derivative, std::string& error) {
+    mDerivatives = &derivatives;
+    mCache.clear();
+
+    if (!derive(expression, derivative)) {
+        error = mError;
+
+        return false;
+    }
+
+    return true;
+}
+
+utils::XmlNodePtr Differentiator::intern(const utils::XmlNodePtr& expression) {
+    auto iter = mInterned.find(expression.get());
+
+    if (iter != mInterned.end()) {
+        return iter->second;
+    }
+
+    auto res = utils::createNode(expression->type(), expression->name(), expression->namespacePrefix());
+
+    for (const auto& attribute : expression->attributes()) {
+        res->addAttribute(attribute.name(), attribute.value(), attribute.namespacePrefix());
+    }
+
+    for (const auto& child : expression->children()) {
+        res->addChild(intern(child));
+    }
+
+    res = mPool.intern(res);
+    mInterned.emplace(expression.get(), res);
+
+    return res;
+}
+
+utils::XmlNodePtr Differentiator::element(const std::string& name) {
+    return mPool.intern(utils::createNode(utils::XmlNodeType::Element, name));
+}
+
+utils::XmlNodePtr Differentiator::number(double value) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    auto res = utils::createNode(utils::XmlNodeType::Element, "cn");
+
+    res->addChild(mPool.intern(utils::createNode(utils::XmlNodeType::Text, std::string(buffer, result.ptr))));
+
+    return mPool.intern(res);
+}
+
+utils::XmlNodePtr Differentiator::identifier(const std::string& name) {
+    auto res = utils::createNode(utils::XmlNodeType::Element, "ci");
+
+    res->addChild(mPool.intern(utils::createNode(utils::XmlNodeType::Text, name)));
+
+    return mPool.intern(res);
+}
+
+utils::XmlNodePtr Differentiator::apply(const std::string& op, const std::vector<utils::XmlNodePtr>& args) {
+    auto res = utils::createNode(utils::XmlNodeType::Element, "apply");
+
+    res->addChild(element(op));
+    for (const auto& arg : args) {
+        res->addChild(arg);
+    }
+
+    return mPool.intern(res);
+}
+
+utils::XmlNodePtr Differentiator::plus(const utils::XmlNodePtr& a, const utils::XmlNodePtr& b) {
+    if (a == nullptr) {
+        return b;
+    }
+
+    if (b == nullptr) {
+        return a;
+    }
+
+    return apply("plus", { a, b });
+}
+
+utils::XmlNodePtr Differentiator::minus(const utils::XmlNodePtr& a, const utils::XmlNodePtr& b) {
+    if (b == nullptr) {
+        return a;
+    }
+
+    if (a == nullptr) {
+        return negate(b);
+    }
+
+    return apply("minus", { a, b });
+}
+
+utils::XmlNodePtr Differentiator::negate(const utils::XmlNodePtr& a) {
+    if (a == nullptr) {
+        return nullptr;
+    }
+
+    if (a->name() == "cn") {
+        return number(-std::strtod(text(*a).c_str(), nullptr));
+    }
+
+    // -(-x) is x.
+
+    auto children = childElements(a);
+
+    if ((a->name() == "apply") && (children.size() == 2) && (children[0]->name() == "minus")) {
+        return children[1];
+    }
+
+    return apply("minus", { a });
+}
+
+utils::XmlNodePtr Differentiator::times(const utils::XmlNodePtr& a, const utils::XmlNodePtr& b) {
+    if ((a == nullptr) || (b == nullptr)) {
+        return nullptr;
+    }
+
+    if (isNumber(a, 1.0)) {
+        return b;
+    }
+
+    if (isNumber(b, 1.0)) {
+        return a;
+    }
+
+    if (isNumber(a, -1.0)) {
+        return negate(b);
+    }
+
+    if (isNumber(b, -1.0)) {
+        return negate(a);
+    }
+
+    return apply("times", { a, b });
+}
+
+utils::XmlNodePtr Differentiator::divide(const utils::XmlNodePtr& a, const utils::XmlNodePtr& b) {
+    if (a == nullptr) {
+        return nullptr;
+    }
+
+    if (isNumber(b, 1.0)) {
+        return a;
+    }
+
+    return apply("divide", { a, b });
+}
+
+utils::XmlNodePtr Differentiator::square(const utils::XmlNodePtr& a) {
+    return apply("power", { a, number(2.0) });
+}
+
+utils::XmlNodePtr Differentiator::select(const utils::XmlNodePtr& condition, const utils::XmlNodePtr& a, const utils::XmlNodePtr& b) {
+    if ((a == nullptr) && (b == nullptr)) {
+        return nullptr;
+    }
+
+    auto piece = utils::createNode(utils::XmlNodeType::Element, "piece");
+    auto otherwise = utils::createNode(utils::XmlNodeType::Element, "otherwise");
+    auto res = utils::createNode(utils::XmlNodeType::Element, "piecewise");
+
+    piece->addChild((a != nullptr) ? a : number(0.0));
+    piece->addChild(condition);
+    otherwise->addChild((b != nullptr) ? b : number(0.0));
+
+    res->addChild(mPool.intern(piece));
+    res->addChild(mPool.intern(otherwise));
+
+    return mPool.intern(res);
+}
+
+bool Differentiator::derive(const utils::XmlNodePtr& node, utils::XmlNodePtr& res) {
+    auto iter = mCache.find(node.get());
+
+    if (iter != mCache.end()) {
+        res = iter->second;
+
+        return true;
+    }
+
+    const auto& name = node->name();
+
+    if (name == "ci") {
+        auto derivative = mDerivatives->find(text(*node));
+
+        res = (derivative != mDerivatives->end()) ? derivative->second : nullptr;
+    } else if (name == "apply") {
+        if (!deriveApply(node, res)) {
+            return false;
+        }
+    } else if (name == "piecewise") {
+        if (!derivePiecewise(node, res)) {
+            return false;
+        }
+    } else {
+        // A number or a constant.
+
+        res = nullptr;
+    }
+
+    mCache.emplace(node.get(), res);
+
+    return true;
+}
+
+bool Differentiator::deriveApply(const utils::XmlNodePtr& node, utils::XmlNodePtr& res) {
+    auto children = childElements(node);
+    const auto& op = children[0]->name();
+
+    // The qualifier of log or root, if any, comes right after the operator.
+
+    utils::XmlNodePtr qualifier;
+    std::size_t first = 1;
+
+    if ((children.size() > 1) && ((children[1]->name() == "logbase") || (children[1]->name() == "degree"))) {
+        qualifier = childElements(children[1]).front();
+        first = 2;
+    }
+
+    std::vector<utils::XmlNodePtr> args(children.begin() + first, children.end());
+    std::vector<utils::XmlNodePtr> dargs(args.size());
+    bool constant = true;
+
+    for (std::size_t i = 0; i < args.size(); ++i) {
+        if (!derive(args[i], dargs[i])) {
+            return false;
+        }
+
+        constant = constant && (dargs[i] == nullptr);
+    }
+
+    utils::XmlNodePtr dqualifier;
+
+    if ((qualifier != nullptr) && !derive(qualifier, dqualifier)) {
+        return false;
+    }
+
+    res = nullptr;
+
+    if ((constant && (dqualifier == nullptr)) || isPiecewiseConstant(op)) {
+        return true;
+    }
+
+    if (op == "plus") {
+        for (const auto& darg : dargs) {
+            res = plus(res, darg);
+        }
+    } else if (op == "minus") {
+        res = (args.size() == 1) ? negate(dargs[0]) : minus(dargs[0], dargs[1]);
+    } else if (op == "times") {
+        // Product rule: the derivative of each factor times the other factors.
+
+        for (std::size_t i = 0; i < args.size(); ++i) {
+            if (dargs[i] != nullptr) {
+                std::vector<utils::XmlNodePtr> others;
+
+                for (std::size_t j = 0; j < args.size(); ++j) {
+                    if (j != i) {
+                        others.push_back(args[j]);
+                    }
+                }
+
+                res = plus(res, times(dargs[i], (others.size() == 1) ? others[0] : apply("times", others)));
+            }
+        }
+    } else if (op == "divide") {
+        res = minus(divide(dargs[0], args[1]), divide(times(args[0], dargs[1]), square(args[1])));
+    } else if (op == "power") {
+        const auto& u = args[0];
+        const auto& w = args[1];
+
+        if (dargs[1] == nullptr) {
+            auto exponent = (w->name() == "cn") ? number(std::strtod(text(*w).c_str(), nullptr) - 1.0) : apply("minus", { w, number(1.0) });
+
+            if (isNumber(exponent, 0.0)) {
+                res = times(w, dargs[0]);
+            } else {
+                res = times(times(w, isNumber(exponent, 1.0) ? u : apply("power", { u, exponent })), dargs[0]);
+            }
+        } else {
+            res = times(node, plus(times(dargs[1], apply("ln", { u })), divide(times(w, dargs[0]), u)));
+        }
+    } else if ((op == "root") && (qualifier != nullptr)) {
+        return derive(apply("power", { args[0], apply("divide", { number(1.0), qualifier }) }), res);
+    } else if ((op == "log") && (qualifier != nullptr)) {
+        return derive(apply("divide", { apply("ln", { args[0] }), apply("ln", { qualifier }) }), res);
+    } else if (op == "rem") {
+        // rem(a, b) is a-q*b, with q = (a-rem(a, b))/b an integer.
+
+        res = minus(dargs[0], times(dargs[1], apply("divide", { apply("minus", { args[0], node }), args[1] })));
+    } else if ((op == "min") || (op == "max")) {
+        // The derivative of whichever argument is selected.
+
+        auto current = args[0];
+
+        res = dargs[0];
+        for (std::size_t i = 1; i < args.size(); ++i) {
+            res = select(apply((op == "min") ? "leq" : "geq", { current, args[i] }), res, dargs[i]);
+            current = apply(op, { current, args[i] });
+        }
+    } else if (op == "factorial") {
+        mError = "'factorial' cannot be differentiated.";
+
+        return false;
+    } else if (args.size() == 1) {
+        return deriveFunction(op, node, dargs[0], res);
+    } else {
+        mError = "'" + op + "' cannot be differentiated.";
+
+        return false;
+    }
+
+    return true;
+}
+
+bool Differentiator::deriveFunction(const std::string& op, const utils::XmlNodePtr& node, const utils::XmlNodePtr& du, utils::XmlNodePtr& res) {
+    // Chain rule: f'(u)*du, with node being f(u).
+
+    auto u = childElements(node).back();
+    auto one = number(1.0);
+    auto sqrt = [this](const utils::XmlNodePtr& a) { return apply("root", { a }); };
+    auto abs = [this](const utils::XmlNodePtr& a) { return apply("abs", { a }); };
+    utils::XmlNodePtr derivative;
+
+    if (op == "abs") {
+        res = select(apply("lt", { u, number(0.0) }), negate(du), du);
+
+        return true;
+    } else if (op == "root") {
+        derivative = divide(one, times(number(2.0), node));
+    } else if (op == "log") {
+        derivative = divide(one, times(u, number(std::log(10.0))));
+    } else if (op == "ln") {
+        derivative = divide(one, u);
+    } else if (op == "exp") {
+        derivative = node;
+    } else if (op == "sin") {
+        derivative = apply("cos", { u });
+    } else if (op == "cos") {
+        derivative = negate(apply("sin", { u }));
+    } else if (op == "tan") {
+        derivative = divide(one, square(apply("cos", { u })));
+    } else if (op == "sec") {
+        derivative = times(node, apply("tan", { u }));
+    } else if (op == "csc") {
+        derivative = negate(times(node, apply("cot", { u })));
+    } else if (op == "cot") {
+        derivative = negate(divide(one, square(apply("sin", { u }))));
+    } else if (op == "sinh") {
+        derivative = apply("cosh", { u });
+    } else if (op == "cosh") {
+        derivative = apply("sinh", { u });
+    } else if (op == "tanh") {
+        derivative = divide(one, square(apply("cosh", { u })));
+    } else if (op == "sech") {
+        derivative = negate(times(node, apply("tanh", { u })));
+    } else if (op == "csch") {
+        derivative = negate(times(node, apply("coth", { u })));
+    } else if (op == "coth") {
+        derivative = negate(divide(one, square(apply("sinh", { u }))));
+    } else if (op == "arcsin") {
+        derivative = divide(one, sqrt(minus(one, square(u))));
+    } else if (op == "arccos") {
+        derivative = negate(divide(one, sqrt(minus(one, square(u)))));
+    } else if (op == "arctan") {
+        derivative = divide(one, plus(one, square(u)));
+    } else if (op == "arcsec") {
+        derivative = divide(one, times(abs(u), sqrt(minus(square(u), one))));
+    } else if (op == "arccsc") {
+        derivative = negate(divide(one, times(abs(u), sqrt(minus(square(u), one)))));
+    } else if (op == "arccot") {
+        derivative = negate(divide(one, plus(one, square(u))));
+    } else if (op == "arcsinh") {
+        derivative = divide(one, sqrt(plus(square(u), one)));
+    } else if (op == "arccosh") {
+        derivative = divide(one, sqrt(minus(square(u), one)));
+    } else if ((op == "arctanh") || (op == "arccoth")) {
+        derivative = divide(one, minus(one, square(u)));
+    } else if (op == "arcsech") {
+        derivative = negate(divide(one, times(u, sqrt(minus(one, square(u))))));
+    } else if (op == "arccsch") {
+        derivative = negate(divide(one, times(abs(u), sqrt(plus(one, square(u))))));
+    } else {
+        mError = "'" + op + "' cannot be differentiated.";
+
+        return false;
+    }
+
+    res = times(derivative, du);
+
+    return true;
+}
+
+bool Differentiator::derivePiecewise(const utils::XmlNodePtr& node, utils::XmlNodePtr& res) {
+    // The derivative of the piece that holds, with the same conditions.
+
+    auto piecewise = utils::createNode(utils::XmlNodeType::Element, "piecewise");
+    bool constant = true;
+
+    for (const auto& child : childElements(node)) {
+        auto values = childElements(child);
+        utils::XmlNodePtr derivative;
+
+        if (!derive(values[0], derivative)) {
+            return false;
+        }
+
+        constant = constant && (derivative == nullptr);
+
+        auto newChild = utils::createNode(utils::XmlNodeType::Element, child->name());
+
+        newChild->addChild((derivative != nullptr) ? derivative : number(0.0));
+        if (values.size() == 2) {
+            newChild->addChild(values[1]);
+        }
+
+        piecewise->addChild(mPool.intern(newChild));
+    }
+
+    res = constant ? nullptr : mPool.intern(piecewise);
+
+    return true;
+}
+
+}
@@ -0,0 +1,60 @@
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+#include "utils/xmllite.h"
+
+namespace mathml {
+
+// Symbolic differentiation of content MathML expressions.
+//
+// A derivative is itself a content MathML expression, with nullptr standing
+// for zero so that zero terms can be dropped as they are found. The nodes of
+// the derivatives are interned in the given pool, so that identical subterms
+// of the derivatives, including across derivatives, are the very same nodes.
+class Differentiator {
+public:
+    explicit Differentiator(utils::XmlNodePool& pool);
+
+    // Differentiate the given expression, given the derivatives of the
+    // variables it uses, e.g. 1 for the variable of differentiation. Variables
+    // without a derivative are constant. Return false, with an error message,
+    // if the expression cannot be differentiated.
+    bool differentiate(const utils::XmlNodePtr& expression,
+                       const std::unordered_map<std::string, utils::XmlNodePtr>& derivatives,
+                       utils::XmlNodePtr& derivative, std::string& error);
+
+    // The interned version of the given expression, so that its subterms get
+    // shared with those of derivatives.
+    utils::XmlNodePtr intern(const utils::XmlNodePtr& expression);
+
+    // New (interned) expressions.
+    utils::XmlNodePtr number(double value);
+    utils::XmlNodePtr identifier(const std::string& name);
+
+private:
+    utils::XmlNodePool& mPool;
+    const std::unordered_map<std::string, utils::XmlNodePtr>* mDerivatives = nullptr;
+    std::unordered_map<const utils::XmlNode*, utils::XmlNodePtr> mCache;
+    std::unordered_map<const utils::XmlNode*, utils::XmlNodePtr> mInterned;
+    std::string mError;
+
+    utils::XmlNodePtr element(const std::string& name);
+    utils::XmlNodePtr apply(const std::string& op, const std::vector<utils::XmlNodePtr>& args);
+    utils::XmlNodePtr plus(const utils::XmlNodePtr& a, const utils::XmlNodePtr& b);
+    utils::XmlNodePtr minus(const utils::XmlNodePtr& a, const utils::XmlNodePtr& b);
+    utils::XmlNodePtr negate(const utils::XmlNodePtr& a);
+    utils::XmlNodePtr times(const utils::XmlNodePtr& a, const utils::XmlNodePtr& b);
+    utils::XmlNodePtr divide(const utils::XmlNodePtr& a, const utils::XmlNodePtr& b);
+    utils::XmlNodePtr square(const utils::XmlNodePtr& a);
+    utils::XmlNodePtr select(const utils::XmlNodePtr& condition, const utils::XmlNodePtr& a, const utils::XmlNodePtr& b);
+
+    bool derive(const utils::XmlNodePtr& node, utils::XmlNodePtr& res);
+    bool deriveApply(const utils::XmlNodePtr& node, utils::XmlNodePtr& res);
+    bool derivePiecewise(const utils::XmlNodePtr& node, utils::XmlNodePtr& res);
+    bool deriveFunction(const std::string& op, const utils::XmlNodePtr& u, const utils::XmlNodePtr& du, utils::XmlNodePtr& res);
+};
+
+}
@@ -0,0 +1,44 @@
+
+#include "dom.h"
+
+namespace mathml {
+
+std::vector<const utils::XmlNode*> elements(const utils::XmlNode& node) {
+    std::vector<const utils::XmlNode*> res;
+
+    for (const auto& child : node.children()) {
+        if (child->type() == utils::XmlNodeType::Element) {
+            res.push_back(child.get());
+        }
+    }
+
+    return res;
+}
+
+std::vector<utils::XmlNodePtr> childElements(const utils::XmlNodePtr& node) {
+    std::vector<utils::XmlNodePtr> res;
+
+    for (const auto& child : node->children()) {
+        if (child->type() == utils::XmlNodeType::Element) {
+            res.push_back(child);
+        }
+    }
+
+    return res;
+}
+
+std::string text(const utils::XmlNode& node) {
+    std::string res;
+
+    for (const auto& child : node.children()) {
+        if (child->type() == utils::XmlNodeType::Text) {
+            res += child->name();
+        } else if (child->name() == "sep") {
+            res += 'e';
+        }
+    }
+
+    return res;
+}
+
+}
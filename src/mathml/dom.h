@@ -0,0 +1,21 @@
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "utils/xmllite.h"
+
+namespace mathml {
+
+// The element children of the given node.
+std::vector<const utils::XmlNode*> elements(const utils::XmlNode& node);
+
+// The element children of the given node, as shared pointers.
+std::vector<utils::XmlNodePtr> childElements(const utils::XmlNodePtr& node);
+
+// The text of the given ci or cn element, with the mantissa and exponent of a
+// number in e-notation joined back together, e.g. "1.2e-3".
+std::string text(const utils::XmlNode& node);
+
+}
@@ -0,0 +1,114 @@
+
+#include "events.h"
+
+#include <string>
+#include <vector>
+
+namespace mathml {
+
+namespace {
+
+struct EventEmitter {
+    tomathml::EventHandler& handler;
+    std::vector<tomathml::Attribute> attributes;
+    std::vector<std::string> qualifiedNames;
+
+    void emit(const utils::XmlNode& node);
+    void emitElement(const utils::XmlNode& node);
+};
+
+void EventEmitter::emit(const utils::XmlNode& node) {
+    switch (node.type()) {
+        case utils::XmlNodeType::Root:
+            for (const auto& child : node.children()) {
+                emit(*child);
+            }
+            break;
+        case utils::XmlNodeType::Element:
+            emitElement(node);
+            break;
+        case utils::XmlNodeType::Text:
+            handler.text(node.name());
+            break;
+        case utils::XmlNodeType::Comment:
+            handler.comment(node.name());
+            break;
+        case utils::XmlNodeType::Declaration:
+            break;
+    }
+}
+
+void EventEmitter::emitElement(const utils::XmlNode& node) {
+    std::string tagName = node.namespacePrefix().empty() ? node.name() : node.namespacePrefix() + ":" + node.name();
+
+    // Qualify the names of our attributes, reusing our buffers from one element
+    // to the next.
+
+    const auto& nodeAttributes = node.attributes();
+
+    if (qualifiedNames.size() < nodeAttributes.size()) {
+        qualifiedNames.resize(nodeAttributes.size());
+    }
+
+    attributes.clear();
+    for (std::size_t i = 0; i < nodeAttributes.size(); ++i) {
+        const auto& attr = nodeAttributes[i];
+        if (attr.namespacePrefix().empty()) {
+            attributes.push_back({ attr.name(), attr.value() });
+        } else {
+            qualifiedNames[i] = attr.namespacePrefix() + ":" + attr.name();
+            attributes.push_back({ qualifiedNames[i], attr.value() });
+        }
+    }
+
+    handler.startElement(tagName, attributes);
+    for (const auto& child : node.children()) {
+        emit(*child);
+    }
+    handler.endElement(tagName);
+}
+
+}
+
+void emitEvents(const utils::XmlNodePtr& node, tomathml::EventHandler& handler) {
+    EventEmitter emitter { handler, {}, {} };
+
+    emitter.emit(*node);
+}
+
+DomBuilder::DomBuilder()
+    : mDocument(utils::createNode(utils::XmlNodeType::Root, "")) {
+    mDocument->addChild(utils::createNode(utils::XmlNodeType::Declaration, "xml version=\"1.0\" encoding=\"UTF-8\""));
+    mElements.push_back(mDocument);
+}
+
+void DomBuilder::startElement(std::string_view name, std::span<const tomathml::Attribute> attributes) {
+    auto element = utils::createNode(utils::XmlNodeType::Element, std::string(name));
+
+    for (const auto& attribute : attributes) {
+        element->addAttribute(std::string(attribute.name), std::string(attribute.value));
+    }
+
+    mElements.back()->addChild(element);
+    mElements.push_back(element);
+}
+
+void DomBuilder::endElement(std::string_view) {
+    if (mElements.size() > 1) {
+        mElements.pop_back();
+    }
+}
+
+void DomBuilder::text(std::string_view text) {
+    mElements.back()->addChild(utils::createNode(utils::XmlNodeType::Text, std::string(text)));
+}
+
+void DomBuilder::comment(std::string_view comment) {
+    mElements.back()->addChild(utils::createNode(utils::XmlNodeType::Comment, std::string(comment)));
+}
+
+utils::XmlNodePtr DomBuilder::document() const {
+    return mDocument;
+}
+
+}
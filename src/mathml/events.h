@@ -0,0 +1,33 @@
+
+#pragma once
+
+#include <vector>
+
+#include "tomathml_events.h"
+#include "utils/xmllite.h"
+
+namespace mathml {
+
+// Handler building a DOM document, with an XML declaration, from the events it
+// is given.
+class DomBuilder: public tomathml::EventHandler {
+public:
+    DomBuilder();
+
+    void startElement(std::string_view name, std::span<const tomathml::Attribute> attributes) override;
+    void endElement(std::string_view name) override;
+    void text(std::string_view text) override;
+    void comment(std::string_view comment) override;
+
+    utils::XmlNodePtr document() const;
+
+private:
+    utils::XmlNodePtr mDocument;
+    std::vector<utils::XmlNodePtr> mElements;
+};
+
+// Report the given DOM node and its descendants to the given handler. The root
+// node itself and declarations are not reported.
+void emitEvents(const utils::XmlNodePtr& node, tomathml::EventHandler& handler);
+
+}
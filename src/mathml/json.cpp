@@ -0,0 +1,213 @@
+
+#include "json.h"
+
+#include "dom.h"
+
+namespace mathml {
+
+namespace {
+
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string& output)
+        : mOutput(output) {
+    }
+
+    void writeStatement(const utils::XmlNode& node);
+
+private:
+    std::string& mOutput;
+
+    void writeString(const std::string& string);
+    void writeExpression(const utils::XmlNode& node);
+    void writeNumber(const utils::XmlNode& node);
+    void writeApply(const utils::XmlNode& node);
+    void writePiecewise(const utils::XmlNode& node);
+    void writeMember(const std::string& name, const utils::XmlNode& node);
+    void writeQualifier(const utils::XmlNode& node);
+};
+
+bool isQualifier(const utils::XmlNode& node) {
+    return (node.name() == "bvar") || (node.name() == "degree") || (node.name() == "logbase");
+}
+
+void JsonWriter::writeString(const std::string& string) {
+    static const char HexDigits[] = "0123456789abcdef";
+
+    mOutput += '"';
+    for (char c : string) {
+        switch (c) {
+            case '"':
+                mOutput += "\\\"";
+                break;
+            case '\\':
+                mOutput += "\\\\";
+                break;
+            case '\n':
+                mOutput += "\\n";
+                break;
+            case '\r':
+                mOutput += "\\r";
+                break;
+            case '\t':
+                mOutput += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    mOutput += "\\u00";
+                    mOutput += HexDigits[(c >> 4) & 0xf];
+                    mOutput += HexDigits[c & 0xf];
+                } else {
+                    mOutput += c;
+                }
+        }
+    }
+    mOutput += '"';
+}
+
+void JsonWriter::writeStatement(const utils::XmlNode& node) {
+    if (node.type() == utils::XmlNodeType::Comment) {
+        mOutput += "{\"comment\":";
+        writeString(node.name());
+        mOutput += "}\n";
+    } else if (node.type() == utils::XmlNodeType::Element) {
+        writeExpression(node);
+        mOutput += '\n';
+    }
+}
+
+void JsonWriter::writeExpression(const utils::XmlNode& node) {
+    const auto& name = node.name();
+
+    if (name == "ci") {
+        mOutput += "{\"ci\":";
+        writeString(text(node));
+        mOutput += '}';
+    } else if (name == "cn") {
+        writeNumber(node);
+    } else if (name == "apply") {
+        writeApply(node);
+    } else if (name == "piecewise") {
+        writePiecewise(node);
+    } else {
+        mOutput += "{\"const\":";
+        writeString(name);
+        mOutput += '}';
+    }
+}
+
+void JsonWriter::writeNumber(const utils::XmlNode& node) {
+    const std::string* units = nullptr;
+
+    for (const auto& attribute : node.attributes()) {
+        if (attribute.name() == "units") {
+            units = &attribute.value();
+        }
+    }
+
+    mOutput += "{\"cn\":";
+    writeString(text(node));
+    if (units != nullptr) {
+        mOutput += ",\"units\":";
+        writeString(*units);
+    }
+    mOutput += '}';
+}
+
+void JsonWriter::writeApply(const utils::XmlNode& node) {
+    auto children = elements(node);
+
+    if (children.empty()) {
+        return;
+    }
+
+    mOutput += "{\"op\":";
+    writeString(children.front()->name());
+
+    // Qualifiers (i.e. bvar, degree and logbase) come right after the operator.
+
+    std::size_t i = 1;
+
+    for (; (i < children.size()) && isQualifier(*children[i]); ++i) {
+        if (children[i]->name() == "bvar") {
+            for (auto bvarChild : elements(*children[i])) {
+                if (bvarChild->name() == "ci") {
+                    writeMember("bvar", *bvarChild);
+                } else {
+                    writeQualifier(*bvarChild);
+                }
+            }
+        } else {
+            writeQualifier(*children[i]);
+        }
+    }
+
+    mOutput += ",\"args\":[";
+    for (std::size_t j = i; j < children.size(); ++j) {
+        if (j != i) {
+            mOutput += ',';
+        }
+
+        writeExpression(*children[j]);
+    }
+    mOutput += "]}";
+}
+
+void JsonWriter::writeMember(const std::string& name, const utils::XmlNode& node) {
+    mOutput += ',';
+    writeString(name);
+    mOutput += ':';
+    writeExpression(node);
+}
+
+void JsonWriter::writeQualifier(const utils::XmlNode& node) {
+    auto children = elements(node);
+
+    if (!children.empty()) {
+        writeMember(node.name(), *children.front());
+    }
+}
+
+void JsonWriter::writePiecewise(const utils::XmlNode& node) {
+    bool first = true;
+
+    mOutput += "{\"piecewise\":[";
+    for (auto child : elements(node)) {
+        auto values = elements(*child);
+
+        if (child->name() == "piece") {
+            mOutput += first ? "{\"value\":" : ",{\"value\":";
+            writeExpression(*values[0]);
+            mOutput += ",\"condition\":";
+            writeExpression(*values[1]);
+            mOutput += '}';
+
+            first = false;
+        }
+    }
+    mOutput += ']';
+
+    for (auto child : elements(node)) {
+        if (child->name() == "otherwise") {
+            mOutput += ",\"otherwise\":";
+            writeExpression(*elements(*child).front());
+        }
+    }
+    mOutput += '}';
+}
+
+}
+
+void writeJsonLines(const utils::XmlNodePtr& document, std::string& output) {
+    JsonWriter writer(output);
+
+    for (const auto& child : document->children()) {
+        if ((child->type() == utils::XmlNodeType::Element) && (child->name() == "math")) {
+            for (const auto& statement : child->children()) {
+                writer.writeStatement(*statement);
+            }
+        }
+    }
+}
+
+}
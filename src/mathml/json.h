@@ -0,0 +1,26 @@
+
+#pragma once
+
+#include <string>
+
+#include "utils/xmllite.h"
+
+namespace mathml {
+
+// JSON Lines serialisation of a content MathML document, with one line per
+// top-level equation (or comment) of its math element. Expressions are:
+//
+//     {"ci":"x"}
+//     {"cn":"1.2e-3","units":"volt"}                 (units only in CellML mode)
+//     {"const":"pi"}
+//     {"op":"plus","args":[...]}
+//     {"op":"diff","bvar":{"ci":"t"},"degree":{"cn":"2",...},"args":[{"ci":"x"}]}
+//     {"op":"log","logbase":{...},"args":[...]}
+//     {"op":"root","degree":{...},"args":[...]}
+//     {"piecewise":[{"value":{...},"condition":{...}},...],"otherwise":{...}}
+//
+// and a comment is {"comment":"..."}. Numbers are kept as strings, so that
+// their text is reproduced exactly.
+void writeJsonLines(const utils::XmlNodePtr& document, std::string& output);
+
+}
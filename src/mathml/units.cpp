@@ -0,0 +1,544 @@
+#include "units.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+
+#include "dom.h"
+
+namespace mathml {
+
+namespace {
+
+struct NamedUnits {
+    const char* name;
+    std::array<int, 7> exponents;
+    double scale;
+};
+
+// The SI units of CellML, in terms of the SI base units, i.e. metre, kilogram,
+// second, ampere, kelvin, mole and candela, in that order. Celsius is treated
+// as kelvin, i.e. its offset is ignored.
+
+const NamedUnits SiUnits[] = {
+    { "ampere", { 0, 0, 0, 1, 0, 0, 0 }, 1.0 },
+    { "becquerel", { 0, 0, -1, 0, 0, 0, 0 }, 1.0 },
+    { "candela", { 0, 0, 0, 0, 0, 0, 1 }, 1.0 },
+    { "celsius", { 0, 0, 0, 0, 1, 0, 0 }, 1.0 },
+    { "coulomb", { 0, 0, 1, 1, 0, 0, 0 }, 1.0 },
+    { "dimensionless", { 0, 0, 0, 0, 0, 0, 0 }, 1.0 },
+    { "farad", { -2, -1, 4, 2, 0, 0, 0 }, 1.0 },
+    { "gram", { 0, 1, 0, 0, 0, 0, 0 }, 1e-3 },
+    { "gray", { 2, 0, -2, 0, 0, 0, 0 }, 1.0 },
+    { "henry", { 2, 1, -2, -2, 0, 0, 0 }, 1.0 },
+    { "hertz", { 0, 0, -1, 0, 0, 0, 0 }, 1.0 },
+    { "joule", { 2, 1, -2, 0, 0, 0, 0 }, 1.0 },
+    { "katal", { 0, 0, -1, 0, 0, 1, 0 }, 1.0 },
+    { "kelvin", { 0, 0, 0, 0, 1, 0, 0 }, 1.0 },
+    { "kilogram", { 0, 1, 0, 0, 0, 0, 0 }, 1.0 },
+    { "liter", { 3, 0, 0, 0, 0, 0, 0 }, 1e-3 },
+    { "litre", { 3, 0, 0, 0, 0, 0, 0 }, 1e-3 },
+    { "lumen", { 0, 0, 0, 0, 0, 0, 1 }, 1.0 },
+    { "lux", { -2, 0, 0, 0, 0, 0, 1 }, 1.0 },
+    { "meter", { 1, 0, 0, 0, 0, 0, 0 }, 1.0 },
+    { "metre", { 1, 0, 0, 0, 0, 0, 0 }, 1.0 },
+    { "mole", { 0, 0, 0, 0, 0, 1, 0 }, 1.0 },
+    { "newton", { 1, 1, -2, 0, 0, 0, 0 }, 1.0 },
+    { "ohm", { 2, 1, -3, -2, 0, 0, 0 }, 1.0 },
+    { "pascal", { -1, 1, -2, 0, 0, 0, 0 }, 1.0 },
+    { "radian", { 0, 0, 0, 0, 0, 0, 0 }, 1.0 },
+    { "second", { 0, 0, 1, 0, 0, 0, 0 }, 1.0 },
+    { "siemens", { -2, -1, 3, 2, 0, 0, 0 }, 1.0 },
+    { "sievert", { 2, 0, -2, 0, 0, 0, 0 }, 1.0 },
+    { "steradian", { 0, 0, 0, 0, 0, 0, 0 }, 1.0 },
+    { "tesla", { 0, 1, -2, -1, 0, 0, 0 }, 1.0 },
+    { "volt", { 2, 1, -3, -1, 0, 0, 0 }, 1.0 },
+    { "watt", { 2, 1, -3, 0, 0, 0, 0 }, 1.0 },
+    { "weber", { 2, 1, -2, -1, 0, 0, 0 }, 1.0 },
+};
+
+const std::pair<const char*, double> SiPrefixes[] = {
+    { "yotta", 1e24 }, { "zetta", 1e21 }, { "exa", 1e18 }, { "peta", 1e15 }, { "tera", 1e12 },
+    { "giga", 1e9 }, { "mega", 1e6 }, { "kilo", 1e3 }, { "hecto", 1e2 }, { "deka", 1e1 },
+    { "deci", 1e-1 }, { "centi", 1e-2 }, { "milli", 1e-3 }, { "micro", 1e-6 }, { "nano", 1e-9 },
+    { "pico", 1e-12 }, { "femto", 1e-15 }, { "atto", 1e-18 }, { "zepto", 1e-21 }, { "yocto", 1e-24 },
+};
+
+const char* const BaseUnitSymbols[] = { "m", "kg", "s", "A", "K", "mol", "cd" };
+
+const NamedUnits* siUnits(const std::string& name) {
+    for (const auto& units : SiUnits) {
+        if (name == units.name) {
+            return &units;
+        }
+    }
+
+    return nullptr;
+}
+
+bool isQualifier(const utils::XmlNode& node) {
+    return (node.name() == "bvar") || (node.name() == "degree") || (node.name() == "logbase");
+}
+
+const utils::XmlNode* qualifier(const std::vector<const utils::XmlNode*>& children, const std::string& name) {
+    for (auto child : children) {
+        if (child->name() == name) {
+            auto qualifierChildren = elements(*child);
+
+            return qualifierChildren.empty() ? nullptr : qualifierChildren[0];
+        }
+    }
+
+    return nullptr;
+}
+
+// The variable of integration of the derivative with the given children, and
+// the degree of the derivative, if any.
+const utils::XmlNode* variableOfIntegration(const std::vector<const utils::XmlNode*>& children, const utils::XmlNode*& degree) {
+    degree = nullptr;
+
+    for (auto child : children) {
+        if (child->name() == "bvar") {
+            auto bvarChildren = elements(*child);
+
+            degree = qualifier(bvarChildren, "degree");
+
+            return bvarChildren.empty() ? nullptr : bvarChildren[0];
+        }
+    }
+
+    return nullptr;
+}
+
+// The value of the given constant, i.e. a number or the negation of one.
+bool constantValue(const utils::XmlNode& node, double& value) {
+    if (node.name() == "cn") {
+        value = std::strtod(text(node).c_str(), nullptr);
+
+        return true;
+    }
+
+    auto children = elements(node);
+
+    if ((node.name() == "apply") && (children.size() == 2) && (children[0]->name() == "minus")
+        && constantValue(*children[1], value)) {
+        value = -value;
+
+        return true;
+    }
+
+    return false;
+}
+
+std::string toString(double value) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+
+    return std::string(buffer, result.ptr);
+}
+
+}
+
+std::size_t UnitsChecker::Hash::operator()(const Units& units) const {
+    std::size_t res = std::hash<double>()(units.scale);
+
+    for (auto exponent : units.exponents) {
+        res = res * 31 + static_cast<std::size_t>(exponent + 128);
+    }
+
+    return res;
+}
+
+UnitsChecker::UnitsChecker() {
+    intern(Units());
+}
+
+void UnitsChecker::clear() {
+    mVariables.clear();
+}
+
+int UnitsChecker::intern(const Units& units) {
+    auto [iter, inserted] = mIds.emplace(units, static_cast<int>(mUnits.size()));
+
+    if (inserted) {
+        mUnits.push_back(units);
+    }
+
+    return iter->second;
+}
+
+int UnitsChecker::namedUnits(const std::string& name) {
+    auto iter = mNamedUnits.find(name);
+
+    if (iter != mNamedUnits.end()) {
+        return iter->second;
+    }
+
+    // Look for an SI unit, possibly with an SI prefix.
+
+    auto units = siUnits(name);
+    double scale = 1.0;
+
+    if (units == nullptr) {
+        for (const auto& [prefix, prefixScale] : SiPrefixes) {
+            if (name.starts_with(prefix)) {
+                units = siUnits(name.substr(std::char_traits<char>::length(prefix)));
+                scale = prefixScale;
+
+                break;
+            }
+        }
+    }
+
+    int res = Unknown;
+
+    if (units != nullptr) {
+        res = intern(Units { units->exponents, scale * units->scale });
+
+        mNames.emplace(res, name);
+    }
+
+    mNamedUnits.emplace(name, res);
+
+    return res;
+}
+
+std::string UnitsChecker::describe(int id) const {
+    auto iter = mNames.find(id);
+
+    if (iter != mNames.end()) {
+        return iter->second;
+    }
+
+    const auto& units = mUnits[id];
+    std::string res;
+
+    for (std::size_t i = 0; i < BaseUnitCount; ++i) {
+        if (units.exponents[i] != 0) {
+            if (!res.empty()) {
+                res += '.';
+            }
+
+            res += BaseUnitSymbols[i];
+
+            if (units.exponents[i] != 1) {
+                res += '^';
+                res += std::to_string(units.exponents[i]);
+            }
+        }
+    }
+
+    if (res.empty()) {
+        res = "dimensionless";
+    }
+
+    if (units.scale != 1.0) {
+        res = toString(units.scale) + " " + res;
+    }
+
+    return res;
+}
+
+bool UnitsChecker::sameDimension(int id, int other) const {
+    return mUnits[id].exponents == mUnits[other].exponents;
+}
+
+int UnitsChecker::multiply(int id, int other, int sign) {
+    if ((id == Unknown) || (other == Unknown)) {
+        return Unknown;
+    }
+
+    auto res = mUnits[id];
+    const auto& otherUnits = mUnits[other];
+
+    for (std::size_t i = 0; i < BaseUnitCount; ++i) {
+        res.exponents[i] += sign * otherUnits.exponents[i];
+    }
+
+    res.scale = (sign > 0) ? res.scale * otherUnits.scale : res.scale / otherUnits.scale;
+
+    return intern(res);
+}
+
+int UnitsChecker::raise(const std::string& op, int id, double exponent) {
+    if (id == Unknown) {
+        return Unknown;
+    }
+
+    auto res = mUnits[id];
+
+    for (auto& baseExponent : res.exponents) {
+        auto value = baseExponent * exponent;
+
+        if (std::abs(value - std::round(value)) > 1e-9) {
+            mMessages->push_back("The units of '" + op + "' do not have integer exponents (" + describe(id) + " to the power of " + toString(exponent) + ").");
+
+            return Unknown;
+        }
+
+        baseExponent = static_cast<int>(std::round(value));
+    }
+
+    res.scale = std::pow(res.scale, exponent);
+
+    return intern(res);
+}
+
+int UnitsChecker::power(const std::string& op, int id, const utils::XmlNode* exponent, double defaultExponent, bool inverse) {
+    double value = defaultExponent;
+
+    if ((exponent != nullptr) && !constantValue(*exponent, value)) {
+        if ((id != Unknown) && !sameDimension(id, Dimensionless)) {
+            mMessages->push_back("The exponent of '" + op + "' must be a constant since its base has units (" + describe(id) + ").");
+
+            return Unknown;
+        }
+
+        return id;
+    }
+
+    return raise(op, id, inverse ? 1.0 / value : value);
+}
+
+void UnitsChecker::infer(const utils::XmlNode& node, int id) {
+    if ((id != Unknown) && (node.name() == "ci")) {
+        mVariables.emplace(text(node), id);
+    }
+}
+
+bool UnitsChecker::consistent(const std::string& what, int id, int other) {
+    if ((id == Unknown) || (other == Unknown) || (id == other)) {
+        return true;
+    }
+
+    if (!sameDimension(id, other)) {
+        mMessages->push_back("The units of " + what + " are not consistent (" + describe(id) + " and " + describe(other) + ").");
+
+        return false;
+    }
+
+    if (std::abs(mUnits[id].scale / mUnits[other].scale - 1.0) > 1e-9) {
+        mMessages->push_back("The units of " + what + " have different scales (" + describe(id) + " and " + describe(other) + ").");
+
+        return false;
+    }
+
+    return true;
+}
+
+int UnitsChecker::same(const std::string& what, const std::vector<const utils::XmlNode*>& operands) {
+    int res = Unknown;
+    std::vector<int> ids;
+
+    for (auto operand : operands) {
+        ids.push_back(units(*operand));
+    }
+
+    for (auto id : ids) {
+        if (res == Unknown) {
+            res = id;
+        } else if (!consistent(what, res, id)) {
+            break;
+        }
+    }
+
+    // The variables whose units we don't know yet have the units of the other
+    // operands.
+
+    for (std::size_t i = 0; i < operands.size(); ++i) {
+        if (ids[i] == Unknown) {
+            infer(*operands[i], res);
+        }
+    }
+
+    return res;
+}
+
+void UnitsChecker::dimensionless(const std::string& what, const std::vector<const utils::XmlNode*>& operands) {
+    for (auto operand : operands) {
+        auto id = units(*operand);
+
+        if (id == Unknown) {
+            infer(*operand, Dimensionless);
+        } else if (!sameDimension(id, Dimensionless)) {
+            mMessages->push_back("The units of " + what + " must be dimensionless (" + describe(id) + ").");
+        }
+    }
+}
+
+int UnitsChecker::units(const utils::XmlNode& node) {
+    const auto& name = node.name();
+
+    if (name == "ci") {
+        auto iter = mVariables.find(text(node));
+
+        return (iter != mVariables.end()) ? iter->second : Unknown;
+    }
+
+    if (name == "cn") {
+        for (const auto& attribute : node.attributes()) {
+            if (attribute.name() == "units") {
+                return namedUnits(attribute.value());
+            }
+        }
+
+        return Unknown;
+    }
+
+    if (name == "apply") {
+        return applyUnits(node);
+    }
+
+    if (name == "piecewise") {
+        return piecewiseUnits(node);
+    }
+
+    if ((name == "pi") || (name == "exponentiale") || (name == "true") || (name == "false")) {
+        return Dimensionless;
+    }
+
+    // Infinity and NaN go with any units.
+
+    return Unknown;
+}
+
+int UnitsChecker::applyUnits(const utils::XmlNode& node) {
+    auto children = elements(node);
+
+    if (children.empty()) {
+        return Unknown;
+    }
+
+    auto op = children[0]->name();
+    std::vector<const utils::XmlNode*> operands;
+
+    for (std::size_t i = 1; i < children.size(); ++i) {
+        if (!isQualifier(*children[i])) {
+            operands.push_back(children[i]);
+        }
+    }
+
+    if ((op == "plus") || (op == "minus") || (op == "min") || (op == "max") || (op == "rem")
+        || (op == "abs") || (op == "floor") || (op == "ceiling") || (op == "gcd") || (op == "lcm")) {
+        return same("the operands of '" + op + "'", operands);
+    }
+
+    if ((op == "eq") || (op == "neq") || (op == "lt") || (op == "leq") || (op == "gt") || (op == "geq")) {
+        same("the operands of '" + op + "'", operands);
+
+        return Dimensionless;
+    }
+
+    if ((op == "times") || (op == "divide")) {
+        int res = Dimensionless;
+
+        for (std::size_t i = 0; i < operands.size(); ++i) {
+            res = multiply(res, units(*operands[i]), ((op == "divide") && (i != 0)) ? -1 : 1);
+        }
+
+        return res;
+    }
+
+    if ((op == "power") && (operands.size() == 2)) {
+        auto base = units(*operands[0]);
+
+        dimensionless("the exponent of 'power'", { operands[1] });
+
+        return power(op, base, operands[1], 1.0, false);
+    }
+
+    if ((op == "root") && (operands.size() == 1)) {
+        auto base = units(*operands[0]);
+        auto degree = qualifier(children, "degree");
+
+        if (degree != nullptr) {
+            dimensionless("the degree of 'root'", { degree });
+        }
+
+        return power(op, base, degree, 2.0, true);
+    }
+
+    if ((op == "diff") && (operands.size() == 1)) {
+        const utils::XmlNode* degree;
+        auto variable = variableOfIntegration(children, degree);
+
+        if (variable == nullptr) {
+            return Unknown;
+        }
+
+        return multiply(units(*operands[0]), power(op, units(*variable), degree, 1.0, false), -1);
+    }
+
+    if (op == "log") {
+        auto base = qualifier(children, "logbase");
+
+        if (base != nullptr) {
+            dimensionless("the base of 'log'", { base });
+        }
+    }
+
+    // Logical operators and mathematical functions only take dimensionless
+    // operands.
+
+    dimensionless("the operands of '" + op + "'", operands);
+
+    return Dimensionless;
+}
+
+int UnitsChecker::piecewiseUnits(const utils::XmlNode& node) {
+    std::vector<const utils::XmlNode*> values;
+
+    for (auto child : elements(node)) {
+        auto pieceChildren = elements(*child);
+
+        if (pieceChildren.empty()) {
+            continue;
+        }
+
+        values.push_back(pieceChildren[0]);
+
+        if (pieceChildren.size() > 1) {
+            dimensionless("the condition of 'piecewise'", { pieceChildren[1] });
+        }
+    }
+
+    return same("the values of 'piecewise'", values);
+}
+
+void UnitsChecker::check(const utils::XmlNode& equation, std::vector<std::string>& messages) {
+    auto children = elements(equation);
+
+    if ((children.size() != 3) || (children[0]->name() != "eq")) {
+        return;
+    }
+
+    mMessages = &messages;
+
+    auto lhsChildren = elements(*children[1]);
+
+    if ((children[1]->name() == "apply") && (lhsChildren.size() >= 3) && (lhsChildren[0]->name() == "diff")) {
+        // The units of the state of an ODE that we don't know yet are those
+        // of its rate times those of its variable of integration.
+
+        auto rate = units(*children[2]);
+        auto derivative = units(*children[1]);
+
+        if (derivative != Unknown) {
+            consistent("both sides of the equation", derivative, rate);
+        } else {
+            const utils::XmlNode* degree;
+            auto variable = variableOfIntegration(lhsChildren, degree);
+
+            if (variable != nullptr) {
+                infer(*lhsChildren.back(), multiply(rate, power("diff", units(*variable), degree, 1.0, false), 1));
+            }
+        }
+    } else {
+        same("both sides of the equation", { children[1], children[2] });
+    }
+
+    mMessages = nullptr;
+}
+
+}
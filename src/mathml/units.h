@@ -0,0 +1,78 @@
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/xmllite.h"
+
+namespace mathml {
+
+// Dimensional analysis of content MathML equations whose numbers have CellML
+// units.
+//
+// Units are a dense vector of exponents of the SI base units, plus a scale
+// (e.g. 1e-3 for millivolt), and are interned so that they can be compared by
+// index. The known units are the SI units of CellML (e.g. volt), possibly with
+// an SI prefix (e.g. millivolt). Other units are unknown and are not checked.
+//
+// Equations are checked one at a time, in order, with the units of a variable
+// inferred from the first equation that determines them, so that checking a
+// model takes linear time.
+class UnitsChecker {
+public:
+    UnitsChecker();
+
+    // Check the units of the given equation, adding a message for each
+    // inconsistency.
+    void check(const utils::XmlNode& equation, std::vector<std::string>& messages);
+
+    // Forget the units of our variables.
+    void clear();
+
+private:
+    static constexpr std::size_t BaseUnitCount = 7;
+    static constexpr int Unknown = -1;
+    static constexpr int Dimensionless = 0;
+
+    struct Units {
+        std::array<int, BaseUnitCount> exponents {};
+        double scale = 1.0;
+
+        bool operator==(const Units& other) const = default;
+    };
+
+    struct Hash {
+        std::size_t operator()(const Units& units) const;
+    };
+
+    std::vector<Units> mUnits;
+    std::unordered_map<Units, int, Hash> mIds;
+    std::unordered_map<std::string, int> mNamedUnits;
+    std::unordered_map<int, std::string> mNames;
+    std::unordered_map<std::string, int> mVariables;
+    std::vector<std::string>* mMessages = nullptr;
+
+    int intern(const Units& units);
+    int namedUnits(const std::string& name);
+    std::string describe(int id) const;
+    bool sameDimension(int id, int other) const;
+
+    int multiply(int id, int other, int sign);
+    int raise(const std::string& op, int id, double exponent);
+    int power(const std::string& op, int id, const utils::XmlNode* exponent, double defaultExponent, bool inverse);
+
+    void infer(const utils::XmlNode& node, int id);
+    bool consistent(const std::string& what, int id, int other);
+    int same(const std::string& what, const std::vector<const utils::XmlNode*>& operands);
+    void dimensionless(const std::string& what, const std::vector<const utils::XmlNode*>& operands);
+
+    int units(const utils::XmlNode& node);
+    int applyUnits(const utils::XmlNode& node);
+    int piecewiseUnits(const utils::XmlNode& node);
+};
+
+}
@@ -1,33 +1,331 @@
 #include "tomathml.h"
 
-#include <iostream>
-#include <sstream>
+#include <algorithm>
+#include <string_view>
+#include <utility>
 
-#include "cellmltext/parser.h"
+#include "tomathml_binary.h"
+#include "tomathml_converter.h"
+#include "tomathml_evaluator.h"
+#include "tomathml_events.h"
+#include "tomathml_result.h"
+#include "tomathml_structure.h"
+#include "tomathml_symbols.h"
+
+#include "mathml/events.h"
+#include "utils/writer.h"
 
 namespace tomathml {
 
-void printMessages(const CellMLText::Parser &parser, std::ostream& os)
+namespace {
+
+Structure structure(const std::string &text, bool cellml)
+{
+    Options options;
+
+    options.cellml = cellml;
+
+    Structure res;
+
+    Converter(options).analyseStructure(text, res);
+
+    return res;
+}
+
+std::vector<Symbol> symbols(const std::string &text, bool cellml)
+{
+    Options options;
+
+    options.cellml = cellml;
+
+    std::vector<Symbol> res;
+
+    Converter(options).symbols(text, res);
+
+    return res;
+}
+
+std::string roleName(Symbol::Role role)
+{
+    switch (role) {
+    case Symbol::Role::State:
+        return "state";
+    case Symbol::Role::Algebraic:
+        return "algebraic";
+    case Symbol::Role::VariableOfIntegration:
+        return "variableOfIntegration";
+    default:
+        return "rightHandSide";
+    }
+}
+
+std::vector<std::vector<std::size_t>> rows(const SparseMatrix &matrix)
+{
+    std::vector<std::vector<std::size_t>> res;
+
+    for (std::size_t i = 0; i < matrix.rowCount; ++i) {
+        res.emplace_back(matrix.columnIndices.begin() + matrix.rowOffsets[i], matrix.columnIndices.begin() + matrix.rowOffsets[i + 1]);
+    }
+
+    return res;
+}
+
+}
+
+std::string process(const std::string &text, bool cellml, bool hoistNamespaces, bool eliminateCommonSubexpressions)
+{
+    Options options;
+
+    options.cellml = cellml;
+    options.hoistNamespaces = hoistNamespaces;
+    options.eliminateCommonSubexpressions = eliminateCommonSubexpressions;
+
+    return Converter(options).convert(text);
+}
+
+std::vector<std::string> processWithDiagnostics(const std::string &text, bool cellml, bool hoistNamespaces)
+{
+    Options options;
+
+    options.cellml = cellml;
+    options.hoistNamespaces = hoistNamespaces;
+
+    auto result = processToResult(text, options);
+    std::vector<std::string> res;
+
+    res.reserve(1 + result.diagnostics.size());
+    res.push_back(std::move(result.output));
+
+    for (const auto &diagnostic : result.diagnostics) {
+        std::string line;
+
+        if (diagnostic.line > 0) {
+            line.append("[").append(std::to_string(diagnostic.line));
+            line.append(", ").append(std::to_string(diagnostic.column)).append("]");
+        } else {
+            line = diagnostic.source;
+        }
+
+        res.push_back(line.append(": ").append(diagnostic.message));
+    }
+
+    return res;
+}
+
+std::vector<std::string> processBatch(const std::vector<std::string> &texts, bool cellml, unsigned int threadCount)
+{
+    Options options;
+
+    options.cellml = cellml;
+    options.batchThreads = threadCount;
+
+    std::vector<std::string_view> views(texts.begin(), texts.end());
+
+    return processBatch(views, options);
+}
+
+std::vector<unsigned char> processToBinary(const std::string &text, bool cellml, bool hoistNamespaces)
+{
+    Options options;
+
+    options.cellml = cellml;
+    options.hoistNamespaces = hoistNamespaces;
+
+    std::vector<unsigned char> binary;
+    Converter(options).convertToBinary(text, binary);
+
+    return binary;
+}
+
+std::string processToJson(const std::string &text, bool cellml)
 {
-    os << "Messages from parser (" << parser.messages().size() << ")" << std::endl;
-    for (const auto& msg: parser.messages()) {
-        os << "[" << msg.line() << ", " << msg.column() << "]: " << msg.message() << std::endl;
+    Options options;
+
+    options.cellml = cellml;
+
+    Converter converter(options);
+    std::string json;
+
+    if (!converter.convertToJson(text, json)) {
+        return converter.messages();
     }
+
+    return json;
+}
+
+std::string checkUnits(const std::string &text)
+{
+    Options options;
+
+    options.checkUnits = true;
+
+    Converter converter(options);
+    EventHandler handler;
+
+    converter.convert(text, handler);
+
+    return converter.messages();
 }
 
-std::string process(const std::string &text, bool cellml)
+std::string processToC(const std::string &text, bool cellml, bool jacobian)
 {
-    auto parser = CellMLText::Parser();
+    Options options;
+
+    options.cellml = cellml;
+    options.jacobian = jacobian;
 
-    std::stringstream outstream;
-    if (parser.execute(text, true, cellml)) {
-        auto doc = parser.domDocument();
-        doc->print(outstream);
-    } else {
-        printMessages(parser, outstream);
+    Converter converter(options);
+    std::string code;
+
+    if (!converter.convertToC(text, code)) {
+        return converter.messages();
     }
 
-    return outstream.str();
+    return code;
+}
+
+std::string binaryToMathml(const std::vector<unsigned char> &binary)
+{
+    mathml::DomBuilder builder;
+
+    if (!readBinary(binary, builder)) {
+        return {};
+    }
+
+    std::string res;
+    utils::Writer writer(res);
+
+    builder.document()->print(writer);
+
+    return res;
+}
+
+std::vector<std::string> incidenceVariables(const std::string &text, bool cellml)
+{
+    return structure(text, cellml).variables;
+}
+
+std::vector<std::vector<std::size_t>> incidence(const std::string &text, bool cellml)
+{
+    return rows(structure(text, cellml).incidence);
+}
+
+std::vector<std::vector<std::size_t>> jacobianSparsity(const std::string &text, bool cellml)
+{
+    return rows(structure(text, cellml).jacobianSparsity);
+}
+
+std::vector<std::vector<std::size_t>> evaluationBlocks(const std::string &text, bool cellml)
+{
+    return structure(text, cellml).blocks;
+}
+
+std::vector<std::vector<std::size_t>> evaluationLevels(const std::string &text, bool cellml)
+{
+    auto blockLevels = structure(text, cellml).blockLevels;
+    std::vector<std::vector<std::size_t>> res;
+
+    for (std::size_t i = 0; i < blockLevels.size(); ++i) {
+        if (blockLevels[i] >= res.size()) {
+            res.resize(blockLevels[i] + 1);
+        }
+
+        res[blockLevels[i]].push_back(i);
+    }
+
+    return res;
+}
+
+std::string validate(const std::string &text, bool cellml)
+{
+    Options options;
+
+    options.cellml = cellml;
+
+    Converter converter(options);
+
+    return converter.validate(text) ? std::string() : converter.messages();
+}
+
+std::vector<std::size_t> statistics(const std::string &text, bool cellml)
+{
+    Options options;
+
+    options.cellml = cellml;
+
+    Summary summary;
+
+    if (!Converter(options).analyse(text, summary)) {
+        return {};
+    }
+
+    return { summary.odeCount, summary.algebraicEquationCount, summary.symbols.size() };
+}
+
+std::vector<std::string> symbolNames(const std::string &text, bool cellml)
+{
+    std::vector<std::string> res;
+
+    for (const auto &symbol : symbols(text, cellml)) {
+        res.push_back(symbol.name);
+    }
+
+    return res;
+}
+
+std::vector<std::vector<std::size_t>> symbolInfo(const std::string &text, bool cellml)
+{
+    std::vector<std::vector<std::size_t>> res;
+
+    for (const auto &symbol : symbols(text, cellml)) {
+        res.push_back({ symbol.count, static_cast<std::size_t>(symbol.line), static_cast<std::size_t>(symbol.column) });
+    }
+
+    return res;
+}
+
+std::vector<std::string> symbolRoles(const std::string &text, bool cellml)
+{
+    std::vector<std::string> res;
+
+    for (const auto &symbol : symbols(text, cellml)) {
+        res.push_back(roleName(symbol.role));
+    }
+
+    return res;
+}
+
+std::vector<std::vector<double>> evaluate(const std::string &text, const std::vector<std::string> &names, const std::vector<std::vector<double>> &values, bool cellml)
+{
+    Evaluator evaluator;
+
+    if (!evaluator.compile(text, cellml) || (names.size() != values.size())) {
+        return {};
+    }
+
+    std::size_t count = values.empty() ? 0 : values.front().size();
+    std::vector<const double *> inputs;
+
+    for (const auto &input : evaluator.inputs()) {
+        auto iter = std::find(names.begin(), names.end(), input);
+
+        if ((iter == names.end()) || (values[iter - names.begin()].size() != count)) {
+            return {};
+        }
+
+        inputs.push_back(values[iter - names.begin()].data());
+    }
+
+    std::vector<std::vector<double>> res(evaluator.outputs().size(), std::vector<double>(count));
+    std::vector<double *> outputs;
+
+    for (auto &output : res) {
+        outputs.push_back(output.data());
+    }
+
+    evaluator.evaluate(inputs, outputs, count);
+
+    return res;
 }
 
 }
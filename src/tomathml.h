@@ -1,7 +1,9 @@
 
 #pragma once
 
+#include <cstddef>
 #include <string>
+#include <vector>
 
 #include "tomathml_export.h"
 
@@ -12,13 +14,244 @@ namespace tomathml {
  *
  * Processes a test string from CellML text into MathML.
  * The optional cellml flag (default true) is used to turn on or off the CellML specific output.
+ * The optional hoistNamespaces flag (default false) declares namespaces, e.g. the CellML namespace, once on the math element
+ * instead of on every element that uses them.
+ * The optional eliminateCommonSubexpressions flag (default false) computes every operation of at least two operations that is
+ * used more than once in a new tmp_N equation, placed before its first use, and uses tmp_N instead.
  * If the processing of the input text fails, the output will be a print out of error messages.
  * The error messages will not be output in XML format.
  *
  * @param text A string of mathematical equations.
  * @param cellml Optional flag to indicate if output should be CellML aware [default: true].
+ * @param hoistNamespaces Optional flag to indicate if namespaces should be declared on the math element [default: false].
+ * @param eliminateCommonSubexpressions Optional flag to indicate if common subexpressions should be eliminated [default: false].
  * @return Content MathML string if successful, Error messages if unsuccessful.
  */
-std::string TOMATHML_API process(const std::string &text, bool cellml = true);
+std::string TOMATHML_API process(const std::string &text, bool cellml = true, bool hoistNamespaces = false, bool eliminateCommonSubexpressions = false);
+
+/**
+ * @brief Process a text string into content MathML, keeping it apart from its diagnostics.
+ *
+ * Unlike process(), the error messages never take the place of the content MathML, so whether the processing
+ * succeeded doesn't need to be guessed from the output.
+ * Each diagnostic is of the form "[line, column]: message", as in the error messages of process(), or "source: message"
+ * if it doesn't refer to the text.
+ *
+ * @param text A string of mathematical equations.
+ * @param cellml Optional flag to indicate if output should be CellML aware [default: true].
+ * @param hoistNamespaces Optional flag to indicate if namespaces should be declared on the math element [default: false].
+ * @return The content MathML, empty if unsuccessful, followed by the diagnostics, e.g. errors or warnings, if any.
+ */
+std::vector<std::string> TOMATHML_API processWithDiagnostics(const std::string &text, bool cellml = true, bool hoistNamespaces = false);
+
+/**
+ * @brief Process many text strings into content MathML, in parallel.
+ *
+ * The text strings are shared out between worker threads that steal work from each other, so that they all keep busy
+ * whatever the sizes of the text strings, and each worker reuses its own parser for all its text strings.
+ *
+ * @param texts The strings of mathematical equations.
+ * @param cellml Optional flag to indicate if output should be CellML aware [default: true].
+ * @param threadCount Optional number of worker threads, with 0 meaning one per hardware thread [default: 0].
+ * @return For each string, in order, what process() returns for it.
+ */
+std::vector<std::string> TOMATHML_API processBatch(const std::vector<std::string> &texts, bool cellml = true, unsigned int threadCount = 0);
+
+/**
+ * @brief Process a text string into the compact binary encoding of content MathML.
+ *
+ * The binary encoding holds the same content MathML as process() outputs, in a
+ * fraction of the size, and can be turned back into content MathML with binaryToMathml().
+ *
+ * @param text A string of mathematical equations.
+ * @param cellml Optional flag to indicate if output should be CellML aware [default: true].
+ * @param hoistNamespaces Optional flag to indicate if namespaces should be declared on the math element [default: false].
+ * @return Binary encoding of content MathML if successful, empty if unsuccessful.
+ */
+std::vector<unsigned char> TOMATHML_API processToBinary(const std::string &text, bool cellml = true, bool hoistNamespaces = false);
+
+/**
+ * @brief Decode the compact binary encoding of content MathML.
+ *
+ * @param binary A binary encoding as returned by processToBinary().
+ * @return Content MathML string if the encoding is valid, empty if it is invalid.
+ */
+std::string TOMATHML_API binaryToMathml(const std::vector<unsigned char> &binary);
+
+/**
+ * @brief Process a text string into a JSON Lines representation of its equations.
+ *
+ * Each equation is output as one JSON object on its own line, e.g. a = b + 2{kg}; gives:
+ * {"op":"eq","args":[{"ci":"a"},{"op":"plus","args":[{"ci":"b"},{"cn":"2","units":"kg"}]}]}
+ * If the processing of the input text fails, the output will be a print out of error messages, as for process().
+ *
+ * @param text A string of mathematical equations.
+ * @param cellml Optional flag to indicate if output should be CellML aware [default: true].
+ * @return JSON Lines string if successful, Error messages if unsuccessful.
+ */
+std::string TOMATHML_API processToJson(const std::string &text, bool cellml = true);
+
+/**
+ * @brief Check the units of a CellML aware text string of equations.
+ *
+ * The units of the numbers are propagated through the equations, with the units of a variable being those of the first
+ * equation that determines them, and every inconsistency, e.g. adding volts and seconds, is reported as a warning.
+ * The SI units of CellML, possibly with an SI prefix (e.g. millivolt), are checked while other units are ignored.
+ *
+ * @param text A string of mathematical equations.
+ * @return Messages, as for process(), if there are inconsistencies or if the processing fails, empty otherwise.
+ */
+std::string TOMATHML_API checkUnits(const std::string &text);
+
+/**
+ * @brief Process a text string into a C function computing the rates of its ODEs.
+ *
+ * The output is self-contained C code defining void rhs(const double *states, const double *params, double *rates),
+ * where the states are the variables of the ODEs and the parameters the variables that no equation computes.
+ * A comment in the code gives the index of each state and parameter.
+ * The optional jacobian flag (default false) also generates
+ * void jacobian(const double *states, const double *params, double *jacobian), computing the Jacobian of the rates
+ * with respect to the states from the symbolic derivatives of the equations, with jacobian[i*n+j] = d(rates[i])/d(states[j]).
+ * If the processing of the input text fails, the output will be a print out of error messages, as for process().
+ *
+ * @param text A string of mathematical equations.
+ * @param cellml Optional flag to indicate if the text is CellML aware [default: true].
+ * @param jacobian Optional flag to indicate if the Jacobian should be generated too [default: false].
+ * @return C code if successful, Error messages if unsuccessful.
+ */
+std::string TOMATHML_API processToC(const std::string &text, bool cellml = true, bool jacobian = false);
+
+/**
+ * @brief The variables of a text string of equations.
+ *
+ * The states, i.e. the variables of the ODEs, come first, in the order of their ODEs,
+ * followed by the other variables, in order of first use. These are the columns of incidence().
+ *
+ * @param text A string of mathematical equations.
+ * @param cellml Optional flag to indicate if the text is CellML aware [default: true].
+ * @return Variables if successful, empty if unsuccessful.
+ */
+std::vector<std::string> TOMATHML_API incidenceVariables(const std::string &text, bool cellml = true);
+
+/**
+ * @brief The incidence matrix of a text string of equations.
+ *
+ * For each equation, in order, the sorted indices in incidenceVariables() of the variables that the equation uses.
+ *
+ * @param text A string of mathematical equations.
+ * @param cellml Optional flag to indicate if the text is CellML aware [default: true].
+ * @return Rows of the incidence matrix if successful, empty if unsuccessful.
+ */
+std::vector<std::vector<std::size_t>> TOMATHML_API incidence(const std::string &text, bool cellml = true);
+
+/**
+ * @brief The sparsity pattern of the Jacobian of the ODEs of a text string of equations.
+ *
+ * For each ODE, in order, the sorted indices of the states that its rate depends on, directly or through algebraic variables.
+ * The states are numbered in the order of their ODEs, as in incidenceVariables().
+ *
+ * @param text A string of mathematical equations.
+ * @param cellml Optional flag to indicate if the text is CellML aware [default: true].
+ * @return Rows of the sparsity pattern if successful, empty if unsuccessful.
+ */
+std::vector<std::vector<std::size_t>> TOMATHML_API jacobianSparsity(const std::string &text, bool cellml = true);
+
+/**
+ * @brief The evaluation order of a text string of equations.
+ *
+ * The indices of the equations, sorted in blocks in a block-lower-triangular order, i.e. each block only depends on
+ * itself and on the blocks before it. A block with more than one equation is an algebraic loop.
+ *
+ * @param text A string of mathematical equations.
+ * @param cellml Optional flag to indicate if the text is CellML aware [default: true].
+ * @return Blocks of equations if successful, empty if unsuccessful.
+ */
+std::vector<std::vector<std::size_t>> TOMATHML_API evaluationBlocks(const std::string &text, bool cellml = true);
+
+/**
+ * @brief The levels of the evaluation order of a text string of equations.
+ *
+ * For each level, the indices in evaluationBlocks() of the blocks that only depend on blocks of lower levels,
+ * i.e. the blocks that can be evaluated in parallel once those of the lower levels have been evaluated.
+ *
+ * @param text A string of mathematical equations.
+ * @param cellml Optional flag to indicate if the text is CellML aware [default: true].
+ * @return Levels of blocks if successful, empty if unsuccessful.
+ */
+std::vector<std::vector<std::size_t>> TOMATHML_API evaluationLevels(const std::string &text, bool cellml = true);
+
+/**
+ * @brief Validate a text string of equations.
+ *
+ * The text is only scanned and parsed, without building nor serialising any MathML, which makes this much cheaper
+ * than process() when only the validity of the text matters.
+ *
+ * @param text A string of mathematical equations.
+ * @param cellml Optional flag to indicate if the text is CellML aware [default: true].
+ * @return Error messages, as for process(), if the text is invalid, empty if it is valid.
+ */
+std::string TOMATHML_API validate(const std::string &text, bool cellml = true);
+
+/**
+ * @brief Summary statistics of a text string of equations.
+ *
+ * As for validate(), no MathML gets built nor serialised.
+ *
+ * @param text A string of mathematical equations.
+ * @param cellml Optional flag to indicate if the text is CellML aware [default: true].
+ * @return The number of ODEs, of algebraic equations and of symbols if successful, empty if unsuccessful.
+ */
+std::vector<std::size_t> TOMATHML_API statistics(const std::string &text, bool cellml = true);
+
+/**
+ * @brief The names of the symbols, i.e. variables, of a text string of equations.
+ *
+ * @param text A string of mathematical equations.
+ * @param cellml Optional flag to indicate if the text is CellML aware [default: true].
+ * @return Names, in order of first occurrence, if successful, empty if unsuccessful.
+ */
+std::vector<std::string> TOMATHML_API symbolNames(const std::string &text, bool cellml = true);
+
+/**
+ * @brief Information about the symbols, i.e. variables, of a text string of equations.
+ *
+ * For each symbol, in the order of symbolNames(), its number of occurrences, and the line and column of its first
+ * occurrence.
+ *
+ * @param text A string of mathematical equations.
+ * @param cellml Optional flag to indicate if the text is CellML aware [default: true].
+ * @return Information about the symbols if successful, empty if unsuccessful.
+ */
+std::vector<std::vector<std::size_t>> TOMATHML_API symbolInfo(const std::string &text, bool cellml = true);
+
+/**
+ * @brief The roles of the symbols, i.e. variables, of a text string of equations.
+ *
+ * For each symbol, in the order of symbolNames(), its role: "state" for the variable of an ODE, "algebraic" for the
+ * left-hand side of an algebraic equation, "variableOfIntegration" for a variable of integration, and "rightHandSide"
+ * for a symbol only used on right-hand sides. A symbol with several roles has the first of them in that list.
+ *
+ * @param text A string of mathematical equations.
+ * @param cellml Optional flag to indicate if the text is CellML aware [default: true].
+ * @return Roles of the symbols if successful, empty if unsuccessful.
+ */
+std::vector<std::string> TOMATHML_API symbolRoles(const std::string &text, bool cellml = true);
+
+/**
+ * @brief Evaluate the right-hand sides of a text string of equations over many parameter sets.
+ *
+ * The equations are compiled once and evaluated for each parameter set, with values[i][j] the value
+ * of the variable names[i] for the jth parameter set. Every variable that no equation computes must be given.
+ * The equations are evaluated in an evaluation order, so they can use variables computed by equations that come
+ * after them, but their algebraic equations must not form a cycle.
+ * The result holds one list of values per equation, in the order of the equations.
+ *
+ * @param text A string of mathematical equations.
+ * @param names The names of the variables given values.
+ * @param values The values of the variables, one list per name, all of the same length.
+ * @param cellml Optional flag to indicate if the text is CellML aware [default: true].
+ * @return Values of the equations if successful, empty if unsuccessful.
+ */
+std::vector<std::vector<double>> TOMATHML_API evaluate(const std::string &text, const std::vector<std::string> &names, const std::vector<std::vector<double>> &values, bool cellml = true);
 
 }
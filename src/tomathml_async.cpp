@@ -0,0 +1,244 @@
+#include "tomathml_async.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <thread>
+#include <utility>
+
+#include "utils/threadpool.h"
+
+namespace tomathml {
+
+struct AsyncConversion
+{
+    Converter converter;
+    std::string text;
+    Executor executor;
+    std::stop_token stopToken;
+    ConvertResult result;
+    std::exception_ptr exception;
+    std::function<void()> completion;
+
+    AsyncConversion(std::string text, const Options &options, Executor executor, std::stop_token stopToken)
+        : converter(options)
+        , text(std::move(text))
+        , executor(std::move(executor))
+        , stopToken(std::move(stopToken))
+    {
+    }
+
+    bool startConversion()
+    {
+        return converter.startConversion(text, result);
+    }
+
+    bool continueConversion(std::size_t statementCount, bool &done)
+    {
+        return converter.continueConversion(statementCount, done);
+    }
+
+    void startSerialization()
+    {
+        converter.startSerialization(result);
+    }
+
+    bool continueSerialization(std::size_t equationCount)
+    {
+        return converter.continueSerialization(equationCount, result);
+    }
+
+    void finishConversion(bool success, bool cancelled)
+    {
+        converter.finishConversion(success, cancelled, result);
+    }
+};
+
+namespace {
+
+// Coroutine that runs until it is done, destroying itself at the end.
+
+struct Job
+{
+    struct promise_type
+    {
+        Job get_return_object() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void() noexcept
+        {
+        }
+
+        void unhandled_exception() noexcept
+        {
+            std::terminate();
+        }
+    };
+};
+
+// Awaiter that suspends the current coroutine and lets the given executor
+// resume it.
+
+struct Reschedule
+{
+    const Executor &executor;
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle) const
+    {
+        executor([handle] {
+            handle.resume();
+        });
+    }
+
+    void await_resume() const noexcept
+    {
+    }
+};
+
+Job run(std::shared_ptr<AsyncConversion> conversion)
+{
+    using Clock = std::chrono::steady_clock;
+
+    co_await Reschedule { conversion->executor };
+
+    try {
+        auto statementsPerSlice = std::max(conversion->converter.options().statementsPerSlice, 1U);
+        auto success = true;
+        auto cancelled = false;
+        auto cached = !conversion->startConversion();
+        auto done = cached;
+        auto parseTime = 0.0;
+
+        while (!done) {
+            if (conversion->stopToken.stop_requested()) {
+                cancelled = true;
+
+                break;
+            }
+
+            auto start = Clock::now();
+
+            success = conversion->continueConversion(statementsPerSlice, done);
+            parseTime += std::chrono::duration<double>(Clock::now() - start).count();
+
+            if (!done) {
+                co_await Reschedule { conversion->executor };
+            }
+        }
+
+        // Serialise our document statementsPerSlice equations at a time too,
+        // starting in a slice of its own.
+
+        if (!cached && success && !cancelled) {
+            co_await Reschedule { conversion->executor };
+
+            conversion->startSerialization();
+
+            while (true) {
+                if (conversion->stopToken.stop_requested()) {
+                    cancelled = true;
+
+                    break;
+                }
+
+                if (conversion->continueSerialization(statementsPerSlice)) {
+                    break;
+                }
+
+                co_await Reschedule { conversion->executor };
+            }
+        }
+
+        if (!cached) {
+            conversion->finishConversion(success, cancelled);
+            conversion->result.statistics.parseTime = parseTime;
+        }
+    } catch (...) {
+        conversion->exception = std::current_exception();
+    }
+
+    auto completion = std::move(conversion->completion);
+
+    completion();
+}
+
+}
+
+Executor defaultExecutor()
+{
+    static utils::ThreadPool pool(std::max(std::thread::hardware_concurrency(), 1U));
+
+    return [](std::function<void()> task) {
+        pool.submit(std::move(task));
+    };
+}
+
+ConvertOperation::ConvertOperation(std::shared_ptr<AsyncConversion> conversion)
+    : mConversion(std::move(conversion))
+{
+}
+
+void ConvertOperation::await_suspend(std::coroutine_handle<> awaiting)
+{
+    mConversion->completion = [awaiting] {
+        awaiting.resume();
+    };
+
+    run(mConversion);
+}
+
+ConvertResult ConvertOperation::await_resume()
+{
+    if (mConversion->exception != nullptr) {
+        std::rethrow_exception(mConversion->exception);
+    }
+
+    return std::move(mConversion->result);
+}
+
+std::future<ConvertResult> ConvertOperation::future()
+{
+    auto promise = std::make_shared<std::promise<ConvertResult>>();
+    auto res = promise->get_future();
+    auto conversion = mConversion.get();
+
+    mConversion->completion = [promise, conversion] {
+        if (conversion->exception != nullptr) {
+            promise->set_exception(conversion->exception);
+        } else {
+            promise->set_value(std::move(conversion->result));
+        }
+    };
+
+    run(mConversion);
+
+    return res;
+}
+
+ConvertOperation convertAsync(std::string text, const Options &options, Executor executor, std::stop_token stopToken)
+{
+    if (!executor) {
+        executor = defaultExecutor();
+    }
+
+    return ConvertOperation(std::make_shared<AsyncConversion>(std::move(text), options, std::move(executor), std::move(stopToken)));
+}
+
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <coroutine>
+#include <functional>
+#include <future>
+#include <memory>
+#include <stop_token>
+#include <string>
+
+#include "tomathml_converter.h"
+#include "tomathml_export.h"
+#include "tomathml_result.h"
+
+namespace tomathml {
+
+struct AsyncConversion;
+
+/**
+ * @brief Executor of tasks, e.g. the scheduler of an event loop.
+ *
+ * An executor is given tasks to run at some later point, on whichever thread
+ * it sees fit. It should not run them before returning.
+ */
+using Executor = std::function<void(std::function<void()> task)>;
+
+/**
+ * @brief The default executor, i.e. a shared pool of one thread per hardware
+ * thread.
+ */
+Executor TOMATHML_API defaultExecutor();
+
+/**
+ * @brief Asynchronous conversion of a text string into content MathML.
+ *
+ * The conversion starts when it is awaited, or when future() is called, and
+ * runs on its executor statementsPerSlice statements at a time, yielding its
+ * thread back to the executor in between, so that a long text string doesn't
+ * hold up the other tasks of the executor. Its content MathML is then
+ * serialised statementsPerSlice top-level equations at a time, after a slice
+ * that eliminates common subexpressions, if requested, which is not split
+ * further. It checks its stop token between slices, failing with a "The
+ * conversion was cancelled." diagnostic if a stop was requested.
+ *
+ * An awaiting coroutine is resumed on the executor, with the result of the
+ * conversion.
+ */
+class TOMATHML_API ConvertOperation
+{
+public:
+    explicit ConvertOperation(std::shared_ptr<AsyncConversion> conversion);
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> awaiting);
+    ConvertResult await_resume();
+
+    /**
+     * @brief Start the conversion, for callers that are not coroutines.
+     *
+     * @return The future result of the conversion.
+     */
+    std::future<ConvertResult> future();
+
+private:
+    std::shared_ptr<AsyncConversion> mConversion;
+};
+
+/**
+ * @brief Convert a text string into content MathML, asynchronously.
+ *
+ * @param text A string of mathematical equations.
+ * @param options The options of the conversion.
+ * @param executor The executor to run the conversion on [default: defaultExecutor()].
+ * @param stopToken The token through which to cancel the conversion [default: none].
+ * @return The conversion, to be awaited, or turned into a future.
+ */
+ConvertOperation TOMATHML_API convertAsync(std::string text, const Options &options = Options(),
+                                           Executor executor = {}, std::stop_token stopToken = {});
+
+}
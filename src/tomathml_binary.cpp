@@ -0,0 +1,12 @@
+#include "tomathml_binary.h"
+
+#include "mathml/binary.h"
+
+namespace tomathml {
+
+bool readBinary(std::span<const unsigned char> binary, EventHandler &handler)
+{
+    return mathml::readBinary(binary.data(), binary.size(), handler);
+}
+
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <span>
+
+#include "tomathml_export.h"
+
+namespace tomathml {
+
+class EventHandler;
+
+/**
+ * @brief Decode content MathML from its compact binary encoding.
+ *
+ * The encoding, as produced by Converter::convertToBinary(), is reported to the
+ * given handler as the same events that Converter::convert() would report.
+ *
+ * @param binary The binary encoding of content MathML.
+ * @param handler The handler to report the content MathML to.
+ * @return True if the encoding is valid, false otherwise, in which case part of
+ * the content MathML may have been reported.
+ */
+bool TOMATHML_API readBinary(std::span<const unsigned char> binary, EventHandler &handler);
+
+}
@@ -0,0 +1,261 @@
+#include "tomathml_c.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <utility>
+
+#include "tomathml_converter.h"
+#include "tomathml_result.h"
+
+struct tomathml_converter
+{
+    tomathml::Converter converter;
+};
+
+struct tomathml_result
+{
+    tomathml::ConvertResult result;
+    bool hasOutput = false;
+};
+
+namespace {
+
+// Run the given function, turning any exception into a status, since no
+// exception may cross the C API.
+
+template<typename Function>
+tomathml_status guarded(Function &&function) noexcept
+{
+    try {
+        return function();
+    } catch (const std::bad_alloc &) {
+        return TOMATHML_OUT_OF_MEMORY;
+    } catch (...) {
+        return TOMATHML_INTERNAL_ERROR;
+    }
+}
+
+// Return a new result with the diagnostics of the given result, and its
+// content MathML if wanted.
+
+tomathml_result *newResult(tomathml::ConvertResult &result, bool withOutput)
+{
+    auto res = new tomathml_result();
+
+    if (withOutput) {
+        res->result = std::move(result);
+        res->hasOutput = res->result.success;
+    } else {
+        res->result.success = result.success;
+        res->result.diagnostics = std::move(result.diagnostics);
+        res->result.statistics = result.statistics;
+    }
+
+    return res;
+}
+
+}
+
+extern "C" {
+
+tomathml_converter *tomathml_converter_new(void)
+{
+    try {
+        return new tomathml_converter();
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void tomathml_converter_free(tomathml_converter *converter)
+{
+    delete converter;
+}
+
+tomathml_status tomathml_converter_set_option(tomathml_converter *converter, tomathml_option option, unsigned int value)
+{
+    if (converter == nullptr) {
+        return TOMATHML_INVALID_ARGUMENT;
+    }
+
+    return guarded([&] {
+        auto options = converter->converter.options();
+
+        switch (option) {
+        case TOMATHML_OPTION_CELLML:
+            options.cellml = value != 0;
+
+            break;
+        case TOMATHML_OPTION_HOIST_NAMESPACES:
+            options.hoistNamespaces = value != 0;
+
+            break;
+        case TOMATHML_OPTION_ELIMINATE_COMMON_SUBEXPRESSIONS:
+            options.eliminateCommonSubexpressions = value != 0;
+
+            break;
+        case TOMATHML_OPTION_CHECK_UNITS:
+            options.checkUnits = value != 0;
+
+            break;
+        case TOMATHML_OPTION_SERIALIZATION_THREADS:
+            options.serializationThreads = value;
+
+            break;
+        default:
+            return TOMATHML_INVALID_ARGUMENT;
+        }
+
+        converter->converter.setOptions(options);
+
+        return TOMATHML_OK;
+    });
+}
+
+tomathml_status tomathml_converter_convert(tomathml_converter *converter, const char *text, size_t text_length,
+                                           tomathml_result **result)
+{
+    if ((converter == nullptr) || ((text == nullptr) && (text_length != 0)) || (result == nullptr)) {
+        return TOMATHML_INVALID_ARGUMENT;
+    }
+
+    *result = nullptr;
+
+    return guarded([&] {
+        tomathml::ConvertResult convertResult;
+        auto success = converter->converter.convert(std::string_view(text, text_length), convertResult);
+
+        *result = newResult(convertResult, true);
+
+        return success ? TOMATHML_OK : TOMATHML_INVALID_TEXT;
+    });
+}
+
+tomathml_status tomathml_converter_convert_to_buffer(tomathml_converter *converter, const char *text, size_t text_length,
+                                                     char *buffer, size_t buffer_size, size_t *output_length,
+                                                     tomathml_result **result)
+{
+    if ((converter == nullptr) || ((text == nullptr) && (text_length != 0))
+        || ((buffer == nullptr) && (buffer_size != 0)) || (output_length == nullptr)) {
+        return TOMATHML_INVALID_ARGUMENT;
+    }
+
+    *output_length = 0;
+
+    if (result != nullptr) {
+        *result = nullptr;
+    }
+
+    return guarded([&] {
+        // Serialise straight into the buffer, and only count the rest of the
+        // content MathML once the buffer is full.
+
+        std::size_t length = 0;
+        auto success = converter->converter.convert(std::string_view(text, text_length), [buffer, buffer_size, &length](const char *data, std::size_t size) {
+            if (length < buffer_size) {
+                std::memcpy(buffer + length, data, std::min(size, buffer_size - length));
+            }
+
+            length += size;
+        });
+
+        if (result != nullptr) {
+            tomathml::ConvertResult convertResult;
+
+            convertResult.success = success;
+            convertResult.diagnostics = converter->converter.diagnostics();
+
+            *result = newResult(convertResult, false);
+        }
+
+        if (!success) {
+            return TOMATHML_INVALID_TEXT;
+        }
+
+        *output_length = length;
+
+        return (length > buffer_size) ? TOMATHML_BUFFER_TOO_SMALL : TOMATHML_OK;
+    });
+}
+
+tomathml_status tomathml_converter_convert_to_callback(tomathml_converter *converter, const char *text, size_t text_length,
+                                                       tomathml_write_callback callback, void *user_data,
+                                                       tomathml_result **result)
+{
+    if ((converter == nullptr) || ((text == nullptr) && (text_length != 0)) || (callback == nullptr)) {
+        return TOMATHML_INVALID_ARGUMENT;
+    }
+
+    if (result != nullptr) {
+        *result = nullptr;
+    }
+
+    return guarded([&] {
+        auto success = converter->converter.convert(std::string_view(text, text_length), [callback, user_data](const char *data, std::size_t size) {
+            callback(data, size, user_data);
+        });
+
+        if (result != nullptr) {
+            tomathml::ConvertResult convertResult;
+
+            convertResult.success = success;
+            convertResult.diagnostics = converter->converter.diagnostics();
+
+            *result = newResult(convertResult, false);
+        }
+
+        return success ? TOMATHML_OK : TOMATHML_INVALID_TEXT;
+    });
+}
+
+const char *tomathml_result_output(const tomathml_result *result, size_t *length)
+{
+    if ((result == nullptr) || !result->hasOutput) {
+        if (length != nullptr) {
+            *length = 0;
+        }
+
+        return nullptr;
+    }
+
+    if (length != nullptr) {
+        *length = result->result.output.size();
+    }
+
+    return result->result.output.c_str();
+}
+
+size_t tomathml_result_diagnostic_count(const tomathml_result *result)
+{
+    return (result != nullptr) ? result->result.diagnostics.size() : 0;
+}
+
+tomathml_status tomathml_result_diagnostic(const tomathml_result *result, size_t index, tomathml_diagnostic *diagnostic)
+{
+    if ((result == nullptr) || (index >= result->result.diagnostics.size()) || (diagnostic == nullptr)) {
+        return TOMATHML_INVALID_ARGUMENT;
+    }
+
+    const auto &resultDiagnostic = result->result.diagnostics[index];
+
+    diagnostic->severity = (resultDiagnostic.severity == tomathml::Diagnostic::Severity::Error) ?
+                               TOMATHML_SEVERITY_ERROR :
+                               TOMATHML_SEVERITY_WARNING;
+    diagnostic->line = resultDiagnostic.line;
+    diagnostic->column = resultDiagnostic.column;
+    diagnostic->source = resultDiagnostic.source.c_str();
+    diagnostic->source_length = resultDiagnostic.source.size();
+    diagnostic->message = resultDiagnostic.message.c_str();
+    diagnostic->message_length = resultDiagnostic.message.size();
+
+    return TOMATHML_OK;
+}
+
+void tomathml_result_free(tomathml_result *result)
+{
+    delete result;
+}
+
+}
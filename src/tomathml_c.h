@@ -0,0 +1,122 @@
+#pragma once
+
+/*
+ * C API of the library, for foreign function interfaces.
+ *
+ * Strings are passed with explicit lengths and need not be null-terminated.
+ * No exception ever crosses this API: every failure is reported through a
+ * status. The objects returned by the API must be freed with their _free()
+ * function.
+ */
+
+#include <stddef.h>
+
+#include "tomathml_export.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct tomathml_converter tomathml_converter;
+typedef struct tomathml_result tomathml_result;
+
+typedef enum tomathml_status
+{
+    TOMATHML_OK = 0, /* Success. */
+    TOMATHML_INVALID_TEXT = 1, /* The text could not be converted, see the diagnostics of the result. */
+    TOMATHML_BUFFER_TOO_SMALL = 2, /* The output is larger than the given buffer. */
+    TOMATHML_INVALID_ARGUMENT = 3, /* A null pointer, an unknown option or an out of range index was given. */
+    TOMATHML_OUT_OF_MEMORY = 4, /* Memory could not be allocated. */
+    TOMATHML_INTERNAL_ERROR = 5 /* Something unexpected went wrong. */
+} tomathml_status;
+
+typedef enum tomathml_option
+{
+    TOMATHML_OPTION_CELLML = 0, /* 0 or 1 [default: 1]. */
+    TOMATHML_OPTION_HOIST_NAMESPACES = 1, /* 0 or 1 [default: 0]. */
+    TOMATHML_OPTION_ELIMINATE_COMMON_SUBEXPRESSIONS = 2, /* 0 or 1 [default: 0]. */
+    TOMATHML_OPTION_CHECK_UNITS = 3, /* 0 or 1 [default: 0]. */
+    TOMATHML_OPTION_SERIALIZATION_THREADS = 4 /* 0 for one per hardware thread [default: 1]. */
+} tomathml_option;
+
+typedef enum tomathml_severity
+{
+    TOMATHML_SEVERITY_ERROR = 0,
+    TOMATHML_SEVERITY_WARNING = 1
+} tomathml_severity;
+
+/*
+ * A diagnostic of a result. Its strings belong to the result, and are valid
+ * until the result is freed.
+ */
+typedef struct tomathml_diagnostic
+{
+    tomathml_severity severity;
+    int line; /* 0 if the diagnostic doesn't refer to the text. */
+    int column;
+    const char *source;
+    size_t source_length;
+    const char *message;
+    size_t message_length;
+} tomathml_diagnostic;
+
+/*
+ * Callback receiving the content MathML in consecutive chunks.
+ */
+typedef void (*tomathml_write_callback)(const char *data, size_t length, void *user_data);
+
+/*
+ * Create a converter, with the default options, or return null if memory
+ * could not be allocated. A converter must not be used from more than one
+ * thread at a time.
+ */
+TOMATHML_API tomathml_converter *tomathml_converter_new(void);
+
+TOMATHML_API void tomathml_converter_free(tomathml_converter *converter);
+
+TOMATHML_API tomathml_status tomathml_converter_set_option(tomathml_converter *converter, tomathml_option option, unsigned int value);
+
+/*
+ * Convert a text into content MathML, kept by the returned result, along
+ * with the diagnostics. Unless memory could not be allocated, a result is
+ * returned even if the conversion fails.
+ */
+TOMATHML_API tomathml_status tomathml_converter_convert(tomathml_converter *converter, const char *text, size_t text_length,
+                                                        tomathml_result **result);
+
+/*
+ * Convert a text into content MathML, written into the given buffer, without
+ * null termination. The length of the content MathML is returned through
+ * output_length, even if the buffer is too small, in which case the buffer
+ * only holds the start of the content MathML. The result, for the
+ * diagnostics, is optional.
+ */
+TOMATHML_API tomathml_status tomathml_converter_convert_to_buffer(tomathml_converter *converter, const char *text, size_t text_length,
+                                                                  char *buffer, size_t buffer_size, size_t *output_length,
+                                                                  tomathml_result **result);
+
+/*
+ * Convert a text into content MathML, handed over in chunks to the given
+ * callback. The callback is not called if the conversion fails. The result,
+ * for the diagnostics, is optional.
+ */
+TOMATHML_API tomathml_status tomathml_converter_convert_to_callback(tomathml_converter *converter, const char *text, size_t text_length,
+                                                                    tomathml_write_callback callback, void *user_data,
+                                                                    tomathml_result **result);
+
+/*
+ * The content MathML of a result, and its length, or null if the conversion
+ * failed or wrote its content MathML elsewhere. The content MathML is
+ * null-terminated and valid until the result is freed.
+ */
+TOMATHML_API const char *tomathml_result_output(const tomathml_result *result, size_t *length);
+
+TOMATHML_API size_t tomathml_result_diagnostic_count(const tomathml_result *result);
+
+TOMATHML_API tomathml_status tomathml_result_diagnostic(const tomathml_result *result, size_t index, tomathml_diagnostic *diagnostic);
+
+TOMATHML_API void tomathml_result_free(tomathml_result *result);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,217 @@
+#include "tomathml_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tomathml {
+
+namespace {
+
+// Approximate number of bytes used by an entry on top of its content MathML.
+
+constexpr std::size_t ENTRY_OVERHEAD = 128;
+
+struct Key
+{
+    std::uint64_t low;
+    std::uint64_t high;
+
+    bool operator==(const Key &other) const = default;
+};
+
+struct KeyHash
+{
+    std::size_t operator()(const Key &key) const
+    {
+        return static_cast<std::size_t>(key.low);
+    }
+};
+
+struct Entry
+{
+    Key key;
+    std::shared_ptr<const std::string> output;
+};
+
+// A shard of the cache, i.e. a list of entries from the most to the least
+// recently used, indexed by their key.
+
+struct Shard
+{
+    std::mutex mutex;
+    std::list<Entry> entries;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+    std::size_t size = 0;
+};
+
+std::size_t entrySize(const Entry &entry)
+{
+    return entry.output->size() + ENTRY_OVERHEAD;
+}
+
+}
+
+struct ConversionCache::Impl
+{
+    std::size_t capacity;
+    std::vector<Shard> shards;
+    std::atomic<std::size_t> size = 0;
+    std::atomic<std::uint64_t> hits = 0;
+    std::atomic<std::uint64_t> misses = 0;
+
+    Impl(std::size_t capacity, unsigned int shardCount)
+        : capacity(capacity)
+        , shards(shardCount)
+    {
+    }
+
+    std::size_t shardIndex(const Key &key) const
+    {
+        // The low bits of the key pick the bucket within a shard, so use its
+        // high bits to pick the shard.
+
+        return key.high % shards.size();
+    }
+
+    // Evict the least recently used entries of the given shard, keeping at
+    // least the given number of them, until the cache is within its capacity.
+
+    void evict(Shard &shard, std::size_t keep)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        while ((size.load(std::memory_order_relaxed) > capacity) && (shard.entries.size() > keep)) {
+            auto &last = shard.entries.back();
+            auto lastSize = entrySize(last);
+
+            shard.size -= lastSize;
+            size.fetch_sub(lastSize, std::memory_order_relaxed);
+            shard.index.erase(last.key);
+            shard.entries.pop_back();
+        }
+    }
+};
+
+ConversionCache::ConversionCache(std::size_t capacity, unsigned int shardCount)
+    : mImpl(std::make_unique<Impl>(capacity, std::max(shardCount, 1U)))
+{
+}
+
+ConversionCache::~ConversionCache() = default;
+
+std::size_t ConversionCache::capacity() const
+{
+    return mImpl->capacity;
+}
+
+std::size_t ConversionCache::size() const
+{
+    return mImpl->size.load(std::memory_order_relaxed);
+}
+
+std::size_t ConversionCache::entryCount() const
+{
+    std::size_t res = 0;
+
+    for (auto &shard : mImpl->shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        res += shard.entries.size();
+    }
+
+    return res;
+}
+
+std::uint64_t ConversionCache::hits() const
+{
+    return mImpl->hits.load(std::memory_order_relaxed);
+}
+
+std::uint64_t ConversionCache::misses() const
+{
+    return mImpl->misses.load(std::memory_order_relaxed);
+}
+
+void ConversionCache::clear()
+{
+    for (auto &shard : mImpl->shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        mImpl->size.fetch_sub(shard.size, std::memory_order_relaxed);
+
+        shard.entries.clear();
+        shard.index.clear();
+        shard.size = 0;
+    }
+
+    mImpl->hits = 0;
+    mImpl->misses = 0;
+}
+
+std::shared_ptr<const std::string> ConversionCache::find(std::uint64_t low, std::uint64_t high)
+{
+    Key key { low, high };
+    auto &shard = mImpl->shards[mImpl->shardIndex(key)];
+
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto iter = shard.index.find(key);
+
+        if (iter != shard.index.end()) {
+            shard.entries.splice(shard.entries.begin(), shard.entries, iter->second);
+
+            mImpl->hits.fetch_add(1, std::memory_order_relaxed);
+
+            return iter->second->output;
+        }
+    }
+
+    mImpl->misses.fetch_add(1, std::memory_order_relaxed);
+
+    return nullptr;
+}
+
+void ConversionCache::insert(std::uint64_t low, std::uint64_t high, std::shared_ptr<const std::string> output)
+{
+    Entry entry { { low, high }, std::move(output) };
+    auto size = entrySize(entry);
+
+    if (size > mImpl->capacity) {
+        return;
+    }
+
+    auto shardIndex = mImpl->shardIndex(entry.key);
+
+    {
+        auto &shard = mImpl->shards[shardIndex];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        // Another thread may have converted the same text string in the
+        // meantime.
+
+        if (shard.index.contains(entry.key)) {
+            return;
+        }
+
+        shard.entries.push_front(std::move(entry));
+        shard.index.emplace(shard.entries.front().key, shard.entries.begin());
+        shard.size += size;
+
+        mImpl->size.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    // The shards share the capacity of the cache, so that an entry can take up
+    // to all of it. Evict entries from our shard first, and then from the
+    // other ones, locking only one shard at a time.
+
+    for (std::size_t i = 0; (i < mImpl->shards.size()) && (mImpl->size.load(std::memory_order_relaxed) > mImpl->capacity); ++i) {
+        mImpl->evict(mImpl->shards[(shardIndex + i) % mImpl->shards.size()], (i == 0) ? 1 : 0);
+    }
+}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "tomathml_export.h"
+
+namespace tomathml {
+
+class Converter;
+
+/**
+ * @brief Cache of the content MathML of text strings.
+ *
+ * The content MathML is keyed by a 128-bit hash of the text string and of the
+ * options it depends on, so that converting the same text string again only
+ * costs a hash and a lookup. Only conversions that succeed without any
+ * messages are cached.
+ *
+ * The cache is bounded by the number of bytes of content MathML it holds,
+ * evicting the least recently used entries first. It is split into shards,
+ * each with its own lock, so that it can be shared by many converters used
+ * from many threads at a time. The shards share the capacity of the cache, so
+ * any content MathML that fits within it can be cached.
+ *
+ * @sa Options::cache
+ */
+class TOMATHML_API ConversionCache
+{
+public:
+    /**
+     * @brief Create a cache.
+     *
+     * @param capacity The maximum number of bytes held by the cache, which is
+     *                 also the maximum size of an entry.
+     * @param shardCount The number of shards of the cache [default: 16].
+     */
+    explicit ConversionCache(std::size_t capacity, unsigned int shardCount = 16);
+    ~ConversionCache();
+
+    ConversionCache(const ConversionCache &) = delete;
+    ConversionCache &operator=(const ConversionCache &) = delete;
+
+    /**
+     * @brief The maximum number of bytes held by the cache.
+     */
+    std::size_t capacity() const;
+
+    /**
+     * @brief The number of bytes held by the cache.
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief The number of entries of the cache.
+     */
+    std::size_t entryCount() const;
+
+    /**
+     * @brief The number of lookups that found, or didn't find, an entry.
+     */
+    std::uint64_t hits() const;
+    std::uint64_t misses() const;
+
+    /**
+     * @brief Remove all the entries of the cache, and reset its counters.
+     */
+    void clear();
+
+private:
+    friend class Converter;
+
+    struct Impl;
+    std::unique_ptr<Impl> mImpl;
+
+    std::shared_ptr<const std::string> find(std::uint64_t low, std::uint64_t high);
+    void insert(std::uint64_t low, std::uint64_t high, std::shared_ptr<const std::string> output);
+};
+
+}
@@ -0,0 +1,695 @@
+#include "tomathml_converter.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#    include <io.h>
+#else
+#    include <unistd.h>
+#endif
+
+#include "analysis/incidence.h"
+#include "cellmltext/parser.h"
+#include "codegen/c.h"
+#include "mathml/binary.h"
+#include "mathml/cse.h"
+#include "mathml/events.h"
+#include "mathml/json.h"
+#include "tomathml_cache.h"
+#include "tomathml_result.h"
+#include "tomathml_symbols.h"
+#include "utils/hash.h"
+#include "utils/threadpool.h"
+#include "utils/writer.h"
+
+namespace tomathml {
+
+struct Converter::Impl
+{
+    Options options;
+    CellMLText::Parser parser;
+    std::unique_ptr<utils::ThreadPool> pool;
+    std::unique_ptr<utils::ThreadPool> batchPool;
+    std::vector<std::unique_ptr<Converter>> batchConverters;
+    std::string error;
+    std::string errorSource;
+    utils::Hash128 cacheKey;
+    bool cached = false;
+    std::size_t serializedEquationCount = 0;
+
+    void prepare(bool buildDom);
+    void transform();
+    bool parse(std::string_view text, bool buildDom = true);
+    std::shared_ptr<const std::string> findCached(std::string_view text);
+    void printDocument(utils::Writer &writer);
+    void print(utils::Writer &writer);
+    bool write(std::string_view text, utils::Writer &writer);
+    bool writeTo(std::string_view text, const std::function<bool(const char *, std::size_t)> &sink);
+    void addDiagnostics(std::vector<Diagnostic> &diagnostics) const;
+    utils::ThreadPool *serializationPool();
+};
+
+void Converter::Impl::prepare(bool buildDom)
+{
+    error.clear();
+    cached = false;
+
+    parser.setBuildDom(buildDom);
+    parser.setHoistNamespaces(options.hoistNamespaces);
+    parser.setShareSubexpressions(options.shareSubexpressions || options.eliminateCommonSubexpressions);
+    parser.setCheckUnits(options.checkUnits);
+    parser.setMemoryResource(options.memoryResource);
+}
+
+void Converter::Impl::transform()
+{
+    if (options.eliminateCommonSubexpressions) {
+        mathml::eliminateCommonSubexpressions(parser.domDocument(), options.minimumSubexpressionCost);
+    }
+}
+
+bool Converter::Impl::parse(std::string_view text, bool buildDom)
+{
+    prepare(buildDom);
+
+    if (!parser.execute(text, true, options.cellml)) {
+        return false;
+    }
+
+    transform();
+
+    return true;
+}
+
+std::shared_ptr<const std::string> Converter::Impl::findCached(std::string_view text)
+{
+    if (options.cache == nullptr) {
+        return nullptr;
+    }
+
+    // The key covers the options that change the content MathML or its
+    // messages, since only conversions without messages get cached.
+
+    std::uint64_t seed = (options.cellml ? 1U : 0U)
+                         | (options.hoistNamespaces ? 2U : 0U)
+                         | (options.checkUnits ? 4U : 0U);
+
+    if (options.eliminateCommonSubexpressions) {
+        seed |= 8U | (std::uint64_t(options.minimumSubexpressionCost) << 32);
+    }
+
+    cacheKey = utils::hash128(text, seed);
+
+    auto res = options.cache->find(cacheKey.low, cacheKey.high);
+
+    if (res != nullptr) {
+        error.clear();
+        cached = true;
+    }
+
+    return res;
+}
+
+void Converter::Impl::printDocument(utils::Writer &writer)
+{
+    auto doc = parser.domDocument();
+    auto pool = serializationPool();
+
+    if (pool != nullptr) {
+        doc->print(writer, *pool);
+    } else {
+        doc->print(writer);
+    }
+}
+
+void Converter::Impl::print(utils::Writer &writer)
+{
+    // Print our document, caching its content MathML if we have a cache and
+    // there are no messages, for which findCached() must have been called.
+
+    if ((options.cache == nullptr) || !parser.messages().empty()) {
+        printDocument(writer);
+
+        return;
+    }
+
+    auto output = std::make_shared<std::string>();
+
+    {
+        utils::Writer outputWriter(*output);
+
+        printDocument(outputWriter);
+    }
+
+    writer.write(*output);
+
+    options.cache->insert(cacheKey.low, cacheKey.high, std::move(output));
+}
+
+bool Converter::Impl::write(std::string_view text, utils::Writer &writer)
+{
+    auto output = findCached(text);
+
+    if (output != nullptr) {
+        writer.write(*output);
+
+        return true;
+    }
+
+    if (!parse(text)) {
+        return false;
+    }
+
+    print(writer);
+
+    return true;
+}
+
+bool Converter::Impl::writeTo(std::string_view text, const std::function<bool(const char *, std::size_t)> &sink)
+{
+    // Stop handing the output over to the sink as soon as it fails, but still
+    // let the conversion finish.
+
+    bool failed = false;
+
+    {
+        utils::Writer writer([&sink, &failed](const char *data, std::size_t size) {
+            failed = failed || !sink(data, size);
+        });
+
+        if (!write(text, writer)) {
+            return false;
+        }
+    }
+
+    if (failed) {
+        error = "The output could not be written.";
+        errorSource = "writer";
+        cached = false;
+
+        return false;
+    }
+
+    return true;
+}
+
+void Converter::Impl::addDiagnostics(std::vector<Diagnostic> &diagnostics) const
+{
+    if (cached) {
+        return;
+    }
+
+    if (!error.empty()) {
+        diagnostics.push_back({ Diagnostic::Severity::Error, errorSource, 0, 0, error });
+
+        return;
+    }
+
+    for (const auto &message : parser.messages()) {
+        diagnostics.push_back({ (message.type() == CellMLText::ParserMessage::Type::Error) ?
+                                    Diagnostic::Severity::Error :
+                                    Diagnostic::Severity::Warning,
+                                "parser", message.line(), message.column(), message.message() });
+    }
+}
+
+utils::ThreadPool *Converter::Impl::serializationPool()
+{
+    unsigned int threadCount = options.serializationThreads;
+
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+    }
+
+    if (threadCount < 2) {
+        return nullptr;
+    }
+
+    if ((pool == nullptr) || (pool->threadCount() != threadCount)) {
+        pool = std::make_unique<utils::ThreadPool>(threadCount);
+    }
+
+    return pool.get();
+}
+
+Converter::Converter(const Options &options)
+    : mImpl(std::make_unique<Impl>())
+{
+    mImpl->options = options;
+}
+
+Converter::~Converter() = default;
+
+const Options &Converter::options() const
+{
+    return mImpl->options;
+}
+
+void Converter::setOptions(const Options &options)
+{
+    mImpl->options = options;
+}
+
+std::string Converter::convert(std::string_view text)
+{
+    std::string res;
+
+    if (!convert(text, res)) {
+        res = messages();
+    }
+
+    return res;
+}
+
+bool Converter::convert(std::string_view text, std::string &output)
+{
+    output.clear();
+
+    utils::Writer writer(output);
+
+    if (!mImpl->write(text, writer)) {
+        output.clear();
+
+        return false;
+    }
+
+    return true;
+}
+
+bool Converter::convert(std::string_view text, std::pmr::string &output)
+{
+    output.clear();
+
+    bool res;
+
+    {
+        utils::Writer writer([&output](const char *data, std::size_t size) {
+            output.append(data, size);
+        });
+
+        res = mImpl->write(text, writer);
+    }
+
+    if (!res) {
+        output.clear();
+    }
+
+    return res;
+}
+
+bool Converter::convert(std::string_view text, ConvertResult &result)
+{
+    using Clock = std::chrono::steady_clock;
+
+    result.output.clear();
+    result.diagnostics.clear();
+    result.statistics = {};
+    result.statistics.inputSize = text.size();
+
+    auto start = Clock::now();
+    auto output = mImpl->findCached(text);
+
+    if (output != nullptr) {
+        result.success = true;
+        result.output = *output;
+        result.statistics.outputSize = output->size();
+        result.statistics.serializationTime = std::chrono::duration<double>(Clock::now() - start).count();
+
+        return true;
+    }
+
+    result.success = mImpl->parse(text);
+
+    auto parsed = Clock::now();
+
+    result.statistics.parseTime = std::chrono::duration<double>(parsed - start).count();
+
+    if (result.success) {
+        {
+            utils::Writer writer(result.output);
+
+            mImpl->print(writer);
+        }
+
+        result.statistics.outputSize = result.output.size();
+        result.statistics.serializationTime = std::chrono::duration<double>(Clock::now() - parsed).count();
+    }
+
+    mImpl->addDiagnostics(result.diagnostics);
+
+    return result.success;
+}
+
+bool Converter::startConversion(std::string_view text, ConvertResult &result)
+{
+    // Start a conversion, unless our cache already has its content MathML
+
+    result.output.clear();
+    result.diagnostics.clear();
+    result.statistics = {};
+    result.statistics.inputSize = text.size();
+
+    auto output = mImpl->findCached(text);
+
+    if (output != nullptr) {
+        result.success = true;
+        result.output = *output;
+        result.statistics.outputSize = output->size();
+
+        return false;
+    }
+
+    mImpl->prepare(true);
+    mImpl->parser.start(text, mImpl->options.cellml);
+
+    return true;
+}
+
+bool Converter::continueConversion(std::size_t statementCount, bool &done)
+{
+    auto res = mImpl->parser.parseStatements(statementCount);
+
+    done = !res || mImpl->parser.atEnd();
+
+    return res;
+}
+
+void Converter::startSerialization(ConvertResult &result)
+{
+    // Transform our document, and serialise it up to the start tag of its math
+    // element, whose equations continueSerialization() then serialises
+
+    using Clock = std::chrono::steady_clock;
+
+    auto start = Clock::now();
+
+    mImpl->transform();
+
+    const auto &children = mImpl->parser.domDocument()->children();
+    const auto &math = children.back();
+
+    {
+        utils::Writer writer(result.output);
+
+        for (std::size_t i = 0; i + 1 < children.size(); ++i) {
+            children[i]->print(writer);
+        }
+
+        if (math->children().empty()) {
+            math->print(writer, 0);
+        } else {
+            math->printStartTag(writer, 0);
+            writer.write(">\n");
+        }
+    }
+
+    mImpl->serializedEquationCount = 0;
+
+    result.statistics.serializationTime += std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+bool Converter::continueSerialization(std::size_t equationCount, ConvertResult &result)
+{
+    // Serialise the next few equations of our math element, and return whether
+    // they were the last ones
+
+    using Clock = std::chrono::steady_clock;
+
+    auto start = Clock::now();
+    const auto &math = mImpl->parser.domDocument()->children().back();
+    auto first = mImpl->serializedEquationCount;
+    auto last = std::min(first + equationCount, math->children().size());
+
+    {
+        utils::Writer writer(result.output);
+
+        math->printChildren(writer, first, last, 2, mImpl->serializationPool());
+    }
+
+    mImpl->serializedEquationCount = last;
+
+    result.statistics.serializationTime += std::chrono::duration<double>(Clock::now() - start).count();
+
+    return last == math->children().size();
+}
+
+void Converter::finishConversion(bool success, bool cancelled, ConvertResult &result)
+{
+    result.success = success && !cancelled;
+
+    if (cancelled) {
+        mImpl->error = "The conversion was cancelled.";
+        mImpl->errorSource = "converter";
+
+        result.output.clear();
+    } else if (success) {
+        const auto &math = mImpl->parser.domDocument()->children().back();
+
+        if (!math->children().empty()) {
+            utils::Writer writer(result.output);
+
+            math->printEndTag(writer, 0);
+        }
+
+        result.statistics.outputSize = result.output.size();
+
+        // Cache our content MathML if we have a cache and there are no
+        // messages, like print() does
+
+        if ((mImpl->options.cache != nullptr) && mImpl->parser.messages().empty()) {
+            mImpl->options.cache->insert(mImpl->cacheKey.low, mImpl->cacheKey.high, std::make_shared<const std::string>(result.output));
+        }
+    }
+
+    mImpl->addDiagnostics(result.diagnostics);
+}
+
+bool Converter::convert(std::string_view text, std::ostream &stream)
+{
+    return mImpl->writeTo(text, [&stream](const char *data, std::size_t size) {
+        return static_cast<bool>(stream.write(data, static_cast<std::streamsize>(size)));
+    });
+}
+
+bool Converter::convert(std::string_view text, std::FILE *file)
+{
+    return mImpl->writeTo(text, [file](const char *data, std::size_t size) {
+        return std::fwrite(data, 1, size, file) == size;
+    });
+}
+
+bool Converter::convertToFileDescriptor(std::string_view text, int fd)
+{
+    return mImpl->writeTo(text, [fd](const char *data, std::size_t size) {
+        while (size > 0) {
+#ifdef _WIN32
+            auto written = _write(fd, data, static_cast<unsigned int>(size));
+#else
+            auto written = ::write(fd, data, size);
+#endif
+
+            if (written < 0) {
+#ifndef _WIN32
+                if (errno == EINTR) {
+                    continue;
+                }
+#endif
+
+                return false;
+            }
+
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+
+        return true;
+    });
+}
+
+bool Converter::convert(std::string_view text, const OutputCallback &callback)
+{
+    return mImpl->writeTo(text, [&callback](const char *data, std::size_t size) {
+        callback(data, size);
+
+        return true;
+    });
+}
+
+std::vector<std::string> Converter::convertBatch(std::span<const std::string_view> texts)
+{
+    auto &impl = *mImpl;
+    unsigned int threadCount = impl.options.batchThreads;
+
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+    }
+
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+
+    if ((impl.batchPool == nullptr) || (impl.batchPool->threadCount() != threadCount)) {
+        impl.batchPool = std::make_unique<utils::ThreadPool>(threadCount);
+    }
+
+    // Each worker serialises its own documents, so it doesn't need threads of
+    // its own.
+
+    auto options = impl.options;
+
+    options.serializationThreads = 1;
+
+    impl.batchConverters.resize(threadCount);
+
+    for (auto &converter : impl.batchConverters) {
+        if (converter == nullptr) {
+            converter = std::make_unique<Converter>(options);
+        } else {
+            converter->setOptions(options);
+        }
+    }
+
+    std::vector<std::string> res(texts.size());
+
+    utils::parallelFor(*impl.batchPool, texts.size(), [&](unsigned int worker, std::size_t index) {
+        res[index] = impl.batchConverters[worker]->convert(texts[index]);
+    });
+
+    return res;
+}
+
+bool Converter::convert(std::string_view text, EventHandler &handler)
+{
+    if (!mImpl->parse(text)) {
+        return false;
+    }
+
+    mathml::emitEvents(mImpl->parser.domDocument(), handler);
+
+    return true;
+}
+
+bool Converter::convertToBinary(std::string_view text, std::vector<unsigned char> &binary)
+{
+    if (!mImpl->parse(text)) {
+        return false;
+    }
+
+    mathml::BinaryWriter writer(binary);
+
+    mathml::emitEvents(mImpl->parser.domDocument(), writer);
+    writer.finish();
+
+    return true;
+}
+
+bool Converter::convertToJson(std::string_view text, std::string &json)
+{
+    if (!mImpl->parse(text)) {
+        return false;
+    }
+
+    mathml::writeJsonLines(mImpl->parser.domDocument(), json);
+
+    return true;
+}
+
+bool Converter::convertToC(std::string_view text, std::string &code)
+{
+    if (!mImpl->parse(text)) {
+        return false;
+    }
+
+    mImpl->errorSource = "code generator";
+
+    return codegen::generateC(mImpl->parser.domDocument(), mImpl->options.jacobian, code, mImpl->error);
+}
+
+bool Converter::analyseStructure(std::string_view text, Structure &structure)
+{
+    if (!mImpl->parse(text)) {
+        return false;
+    }
+
+    mImpl->errorSource = "analysis";
+
+    return analysis::structure(mImpl->parser.domDocument(), structure, mImpl->error);
+}
+
+bool Converter::symbols(std::string_view text, std::vector<Symbol> &symbols)
+{
+    if (!mImpl->parse(text, false)) {
+        return false;
+    }
+
+    symbols = mImpl->parser.symbols();
+
+    return true;
+}
+
+bool Converter::validate(std::string_view text)
+{
+    return mImpl->parse(text, false);
+}
+
+bool Converter::analyse(std::string_view text, Summary &summary)
+{
+    auto res = mImpl->parse(text, false);
+    const auto &parser = mImpl->parser;
+
+    summary.odeCount = parser.odeCount();
+    summary.algebraicEquationCount = parser.algebraicEquationCount();
+    summary.symbols = parser.symbols();
+
+    return res;
+}
+
+std::vector<Diagnostic> Converter::diagnostics() const
+{
+    std::vector<Diagnostic> res;
+
+    mImpl->addDiagnostics(res);
+
+    return res;
+}
+
+std::string Converter::messages() const
+{
+    if (mImpl->cached) {
+        return {};
+    }
+
+    if (!mImpl->error.empty()) {
+        return "Messages from " + mImpl->errorSource + " (1)\n" + mImpl->error + "\n";
+    }
+
+    if (mImpl->parser.messages().empty()) {
+        return {};
+    }
+
+    std::stringstream outstream;
+    CellMLText::printMessages(mImpl->parser, outstream);
+
+    return outstream.str();
+}
+
+ConvertResult processToResult(const std::string &text, const Options &options)
+{
+    ConvertResult res;
+
+    Converter(options).convert(text, res);
+
+    return res;
+}
+
+std::vector<std::string> processBatch(std::span<const std::string_view> texts, const Options &options)
+{
+    return Converter(options).convertBatch(texts);
+}
+
+}
@@ -0,0 +1,416 @@
+#pragma once
+
+#include <cstdio>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tomathml_export.h"
+
+namespace tomathml {
+
+class ConversionCache;
+class EventHandler;
+struct ConvertResult;
+struct Diagnostic;
+struct Structure;
+struct Summary;
+struct Symbol;
+
+/**
+ * @brief Options controlling the conversion of text into content MathML.
+ */
+struct Options
+{
+    /**
+     * Generate CellML aware output, i.e. numbers must have units [default: true].
+     */
+    bool cellml = true;
+
+    /**
+     * Declare namespaces once on the math element rather than on every element
+     * that uses them [default: false].
+     */
+    bool hoistNamespaces = false;
+
+    /**
+     * Share identical subexpressions in memory while parsing, which reduces
+     * the memory used by repetitive models without changing the output
+     * [default: false].
+     */
+    bool shareSubexpressions = false;
+
+    /**
+     * Compute every operation that is used more than once, and whose cost
+     * (its number of operations) is at least minimumSubexpressionCost, once by
+     * a new tmp_N = ... equation placed before its first use, and use tmp_N
+     * instead. This implies shareSubexpressions [default: false].
+     */
+    bool eliminateCommonSubexpressions = false;
+
+    /**
+     * Minimum cost of the operations eliminated by
+     * eliminateCommonSubexpressions [default: 2].
+     */
+    unsigned int minimumSubexpressionCost = 2;
+
+    /**
+     * Check the units of the equations, in CellML mode, reporting each
+     * inconsistency as a warning in messages(), without failing the
+     * conversion. The units of a variable are those of the first equation
+     * that determines them [default: false].
+     */
+    bool checkUnits = false;
+
+    /**
+     * Number of threads used to serialise the equations of a document, with 0
+     * meaning one per hardware thread. The output is the same whatever the
+     * number of threads [default: 1].
+     */
+    unsigned int serializationThreads = 1;
+
+    /**
+     * Also generate a jacobian() function, computing the Jacobian of the rates
+     * with respect to the states, when converting into C code [default: false].
+     */
+    bool jacobian = false;
+
+    /**
+     * Number of worker threads used by convertBatch(), with 0 meaning one per
+     * hardware thread [default: 0].
+     */
+    unsigned int batchThreads = 0;
+
+    /**
+     * Cache of the content MathML returned by convert(), which can be shared
+     * by many converters, including those of convertBatch(), and threads
+     * [default: none].
+     */
+    std::shared_ptr<ConversionCache> cache;
+
+    /**
+     * Number of statements that convertAsync() parses, or top-level
+     * equations that it serialises, before yielding its thread back to its
+     * executor [default: 256].
+     */
+    unsigned int statementsPerSlice = 256;
+
+    /**
+     * Memory resource from which the document of a conversion is allocated,
+     * e.g. a std::pmr::monotonic_buffer_resource whose memory is released all
+     * at once at the end of a request, with null meaning
+     * std::pmr::get_default_resource(). It must outlive the converters that
+     * use it, and be thread safe if convertBatch() or convertAsync() use it
+     * [default: null].
+     */
+    std::pmr::memory_resource *memoryResource = nullptr;
+};
+
+/**
+ * @brief Callback receiving the content MathML in consecutive chunks.
+ */
+using OutputCallback = std::function<void(const char *data, std::size_t size)>;
+
+/**
+ * @brief Converter of text into content MathML.
+ *
+ * A converter keeps its parser between calls, so it is cheaper to reuse one
+ * converter for many conversions than to call process() repeatedly.
+ * A converter must not be used from more than one thread at a time.
+ */
+class TOMATHML_API Converter
+{
+public:
+    explicit Converter(const Options &options = Options());
+    ~Converter();
+
+    Converter(const Converter &) = delete;
+    Converter &operator=(const Converter &) = delete;
+
+    const Options &options() const;
+    void setOptions(const Options &options);
+
+    /**
+     * @brief Convert a text string into content MathML.
+     *
+     * @param text A string of mathematical equations.
+     * @return Content MathML string if successful, Error messages if unsuccessful.
+     */
+    std::string convert(std::string_view text);
+
+    /**
+     * @brief Convert a text string into content MathML, written into a string.
+     *
+     * The string is cleared first and then written into directly, so that
+     * reusing the same string for many conversions reuses its capacity.
+     * The string is left empty if the conversion fails.
+     *
+     * @param text A string of mathematical equations.
+     * @param output The string to write the content MathML into.
+     * @return True if successful, false otherwise.
+     */
+    bool convert(std::string_view text, std::string &output);
+
+    /**
+     * @brief Convert a text string into content MathML, written into a polymorphic string.
+     *
+     * As for convert() with a string, but the content MathML is allocated
+     * from the memory resource of the string, e.g. that of the request that
+     * the conversion is for.
+     *
+     * @param text A string of mathematical equations.
+     * @param output The string to write the content MathML into.
+     * @return True if successful, false otherwise.
+     */
+    bool convert(std::string_view text, std::pmr::string &output);
+
+    /**
+     * @brief Convert a text string into content MathML, with its diagnostics and statistics.
+     *
+     * The output and diagnostics of the result are cleared first and then
+     * written into directly, so that reusing the same result for many
+     * conversions reuses their capacity.
+     *
+     * @param text A string of mathematical equations.
+     * @param result The result of the conversion.
+     * @return True if successful, false otherwise, as result.success.
+     */
+    bool convert(std::string_view text, ConvertResult &result);
+
+    /**
+     * @brief Convert a text string into content MathML, written to a stream.
+     *
+     * The content MathML is written in chunks as it is serialised, without
+     * ever being held in full. Nothing is written if the conversion fails.
+     *
+     * @param text A string of mathematical equations.
+     * @param stream The stream to write the content MathML to.
+     * @return True if successful, false otherwise, including if the stream fails.
+     */
+    bool convert(std::string_view text, std::ostream &stream);
+
+    /**
+     * @brief Convert a text string into content MathML, written to a file.
+     *
+     * As for convert() with a stream, but for a C file.
+     *
+     * @param text A string of mathematical equations.
+     * @param file The file to write the content MathML to.
+     * @return True if successful, false otherwise, including if writing fails.
+     */
+    bool convert(std::string_view text, std::FILE *file);
+
+    /**
+     * @brief Convert a text string into content MathML, written to a file descriptor.
+     *
+     * As for convert() with a stream, but for a file descriptor, e.g. a pipe
+     * or a socket.
+     *
+     * @param text A string of mathematical equations.
+     * @param fd The file descriptor to write the content MathML to.
+     * @return True if successful, false otherwise, including if writing fails.
+     */
+    bool convertToFileDescriptor(std::string_view text, int fd);
+
+    /**
+     * @brief Convert a text string into content MathML, handed over in chunks.
+     *
+     * The callback is called with consecutive chunks of the content MathML
+     * as it is serialised. It is not called if the conversion fails.
+     *
+     * @param text A string of mathematical equations.
+     * @param callback The callback to hand the content MathML over to.
+     * @return True if successful, false otherwise.
+     */
+    bool convert(std::string_view text, const OutputCallback &callback);
+
+    /**
+     * @brief Convert many text strings into content MathML, in parallel.
+     *
+     * The text strings are shared out between batchThreads worker threads,
+     * which steal work from each other, so that they keep busy whatever the
+     * sizes of the text strings. Each worker has its own converter, with the
+     * same options, which it reuses for all its text strings and across calls.
+     *
+     * @param texts The strings of mathematical equations.
+     * @return For each string, in order, what convert() returns for it.
+     */
+    std::vector<std::string> convertBatch(std::span<const std::string_view> texts);
+
+    /**
+     * @brief Convert a text string into content MathML reported as events.
+     *
+     * The content MathML is reported to the given handler straight from the
+     * parsed document, without producing any text.
+     * Nothing is reported if the conversion fails.
+     *
+     * @param text A string of mathematical equations.
+     * @param handler The handler to report the content MathML to.
+     * @return True if successful, false otherwise.
+     */
+    bool convert(std::string_view text, EventHandler &handler);
+
+    /**
+     * @brief Convert a text string into the compact binary encoding of content MathML.
+     *
+     * The encoding is appended to the given buffer and can be decoded with
+     * readBinary(). It is typically a fraction of the size of the text output.
+     * Nothing is appended if the conversion fails.
+     *
+     * @param text A string of mathematical equations.
+     * @param binary The buffer to append the encoding to.
+     * @return True if successful, false otherwise.
+     */
+    bool convertToBinary(std::string_view text, std::vector<unsigned char> &binary);
+
+    /**
+     * @brief Convert a text string into a JSON Lines representation of its equations.
+     *
+     * Each equation (or comment) is appended to the given string as one JSON
+     * object on its own line. Expressions are {"ci": name}, {"cn": text, "units": units},
+     * {"const": name}, {"op": operator, "args": [...]} (with "bvar", "degree"
+     * or "logbase" members where relevant), or {"piecewise": [{"value": ...,
+     * "condition": ...}, ...], "otherwise": ...}. Comments are {"comment": text}.
+     * Nothing is appended if the conversion fails.
+     *
+     * @param text A string of mathematical equations.
+     * @param json The string to append the JSON Lines to.
+     * @return True if successful, false otherwise.
+     */
+    bool convertToJson(std::string_view text, std::string &json);
+
+    /**
+     * @brief Convert a text string into a C function computing the rates of its ODEs.
+     *
+     * The generated code is self-contained, only needing <math.h>, and defines:
+     *
+     *     void rhs(const double *states, const double *params, double *rates);
+     *
+     * The states, and their rates, are the variables of the ODEs, in the order
+     * of the ODEs. The parameters are the variables that no equation computes,
+     * including the variable of integration if it is used, in order of first
+     * use. A comment in the code lists both. The algebraic equations are
+     * computed first, in an order that respects their dependencies.
+     *
+     * If the jacobian option is set, the code also defines:
+     *
+     *     void jacobian(const double *states, const double *params, double *jacobian);
+     *
+     * with jacobian[i*n+j] the derivative of the ith rate with respect to the
+     * jth state, n being the number of states, computed from the symbolic
+     * derivatives of the equations.
+     * Nothing is appended if the conversion fails.
+     *
+     * @param text A string of mathematical equations.
+     * @param code The string to append the C code to.
+     * @return True if successful, false otherwise.
+     */
+    bool convertToC(std::string_view text, std::string &code);
+
+    /**
+     * @brief Determine the structure of a text string of equations.
+     *
+     * The structure, i.e. the incidence matrix of the equations, the sparsity
+     * pattern of the Jacobian of their ODEs and their evaluation order, is
+     * determined straight from the parsed equations, in linear time.
+     *
+     * @param text A string of mathematical equations.
+     * @param structure The structure of the equations.
+     * @return True if successful, false otherwise.
+     */
+    bool analyseStructure(std::string_view text, Structure &structure);
+
+    /**
+     * @brief The symbols of a text string of equations.
+     *
+     * The symbols are interned as the text is parsed, so listing them needs
+     * no MathML to be built nor serialised.
+     *
+     * @param text A string of mathematical equations.
+     * @param symbols The symbols, in order of first occurrence.
+     * @return True if successful, false otherwise.
+     */
+    bool symbols(std::string_view text, std::vector<Symbol> &symbols);
+
+    /**
+     * @brief Check that a text string of equations is valid.
+     *
+     * The text is only scanned and parsed: no MathML gets built nor
+     * serialised. The diagnostics, if any, are available from messages().
+     *
+     * @param text A string of mathematical equations.
+     * @return True if the text is valid, false otherwise.
+     */
+    bool validate(std::string_view text);
+
+    /**
+     * @brief Check that a text string of equations is valid and summarise it.
+     *
+     * As for validate(), no MathML gets built nor serialised. The summary
+     * covers the equations up to the first error, if any.
+     *
+     * @param text A string of mathematical equations.
+     * @param summary The summary of the equations.
+     * @return True if the text is valid, false otherwise.
+     */
+    bool analyse(std::string_view text, Summary &summary);
+
+    /**
+     * @brief The diagnostics from the last conversion, if any.
+     *
+     * @return The diagnostics, in the order they were reported.
+     */
+    std::vector<Diagnostic> diagnostics() const;
+
+    /**
+     * @brief The messages from the last conversion, if any.
+     *
+     * @return The messages in the same form as process() returns them, or an
+     * empty string if there are no messages.
+     */
+    std::string messages() const;
+
+private:
+    friend struct AsyncConversion;
+
+    struct Impl;
+    std::unique_ptr<Impl> mImpl;
+
+    // Convert a text string a few statements at a time, and serialise it a
+    // few equations at a time, which is what convertAsync() does.
+
+    bool startConversion(std::string_view text, ConvertResult &result);
+    bool continueConversion(std::size_t statementCount, bool &done);
+    void startSerialization(ConvertResult &result);
+    bool continueSerialization(std::size_t equationCount, ConvertResult &result);
+    void finishConversion(bool success, bool cancelled, ConvertResult &result);
+};
+
+/**
+ * @brief Convert a text string into content MathML, with its diagnostics and statistics.
+ *
+ * @param text A string of mathematical equations.
+ * @param options The options of the conversion.
+ * @return The result of the conversion.
+ *
+ * @sa Converter::convert()
+ */
+ConvertResult TOMATHML_API processToResult(const std::string &text, const Options &options = Options());
+
+/**
+ * @brief Convert many text strings into content MathML, in parallel.
+ *
+ * @param texts The strings of mathematical equations.
+ * @param options The options of the conversions.
+ * @return For each string, in order, what process() returns for it.
+ *
+ * @sa Converter::convertBatch()
+ */
+std::vector<std::string> TOMATHML_API processBatch(std::span<const std::string_view> texts, const Options &options = Options());
+
+}
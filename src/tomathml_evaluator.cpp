@@ -0,0 +1,87 @@
+#include "tomathml_evaluator.h"
+
+#include <sstream>
+
+#include "cellmltext/parser.h"
+#include "eval/bytecode.h"
+
+namespace tomathml {
+
+struct Evaluator::Impl
+{
+    CellMLText::Parser parser;
+    eval::Program program;
+    bool compiled = false;
+    std::string messages;
+};
+
+Evaluator::Evaluator()
+    : mImpl(std::make_unique<Impl>())
+{
+}
+
+Evaluator::~Evaluator() = default;
+
+bool Evaluator::compile(const std::string &text, bool cellml)
+{
+    auto &parser = mImpl->parser;
+
+    mImpl->program = eval::Program();
+    mImpl->compiled = false;
+    mImpl->messages.clear();
+
+    // Share identical subexpressions, so that they get compiled only once.
+
+    parser.setShareSubexpressions(true);
+
+    if (!parser.execute(text, true, cellml)) {
+        std::stringstream outstream;
+        CellMLText::printMessages(parser, outstream);
+        mImpl->messages = outstream.str();
+
+        return false;
+    }
+
+    std::string error;
+
+    if (!eval::compile(parser.domDocument(), mImpl->program, error)) {
+        mImpl->program = eval::Program();
+        mImpl->messages = "Messages from compiler (1)\n" + error + "\n";
+
+        return false;
+    }
+
+    mImpl->compiled = true;
+
+    return true;
+}
+
+const std::vector<std::string> &Evaluator::inputs() const
+{
+    return mImpl->program.inputs;
+}
+
+const std::vector<std::string> &Evaluator::outputs() const
+{
+    return mImpl->program.outputs;
+}
+
+bool Evaluator::evaluate(std::span<const double *const> inputs, std::span<double *const> outputs, std::size_t count) const
+{
+    const auto &program = mImpl->program;
+
+    if (!mImpl->compiled || (inputs.size() != program.inputs.size()) || (outputs.size() != program.outputs.size())) {
+        return false;
+    }
+
+    eval::run(program, inputs.data(), outputs.data(), count);
+
+    return true;
+}
+
+std::string Evaluator::messages() const
+{
+    return mImpl->messages;
+}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "tomathml_export.h"
+
+namespace tomathml {
+
+/**
+ * @brief Evaluator of the right-hand sides of equations over many parameter sets.
+ *
+ * The equations are compiled once into a compact register bytecode, which is
+ * then run over blocks of parameter sets at a time, using the SIMD registers
+ * of the CPU where available.
+ *
+ * The output of an equation is named after its left-hand side, i.e. "x" for an
+ * algebraic equation and "ode(x, t)" for an ODE. The inputs are the variables
+ * that no equation computes. A variable computed by an algebraic equation can
+ * be used by any other equation, wherever it is in the text, as long as the
+ * algebraic equations do not form a cycle.
+ *
+ * An evaluator can be used from several threads at a time once compiled.
+ */
+class TOMATHML_API Evaluator
+{
+public:
+    Evaluator();
+    ~Evaluator();
+
+    Evaluator(const Evaluator &) = delete;
+    Evaluator &operator=(const Evaluator &) = delete;
+
+    /**
+     * @brief Compile a text string of equations.
+     *
+     * @param text A string of mathematical equations.
+     * @param cellml Flag to indicate if the text is CellML aware, i.e. numbers must have units [default: true].
+     * @return True if successful, false otherwise.
+     */
+    bool compile(const std::string &text, bool cellml = true);
+
+    /**
+     * @brief The names of the inputs of the compiled equations, in order of first use.
+     */
+    const std::vector<std::string> &inputs() const;
+
+    /**
+     * @brief The names of the outputs of the compiled equations, in the order of the equations.
+     */
+    const std::vector<std::string> &outputs() const;
+
+    /**
+     * @brief Evaluate the compiled equations over count parameter sets.
+     *
+     * The values are in structure-of-arrays form: inputs[i][j] is the value of
+     * the ith input for the jth parameter set, and outputs[i][j] receives the
+     * value of the ith output for the jth parameter set.
+     *
+     * @param inputs One array of count values per input.
+     * @param outputs One array of count values per output.
+     * @param count The number of parameter sets.
+     * @return True if successful, false if nothing is compiled or the number of inputs or outputs is wrong.
+     */
+    bool evaluate(std::span<const double *const> inputs, std::span<double *const> outputs, std::size_t count) const;
+
+    /**
+     * @brief The messages from the last compilation, if any.
+     *
+     * @return The messages, or an empty string if there are no messages.
+     */
+    std::string messages() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> mImpl;
+};
+
+}
@@ -0,0 +1,23 @@
+#include "tomathml_events.h"
+
+namespace tomathml {
+
+EventHandler::~EventHandler() = default;
+
+void EventHandler::startElement(std::string_view, std::span<const Attribute>)
+{
+}
+
+void EventHandler::endElement(std::string_view)
+{
+}
+
+void EventHandler::text(std::string_view)
+{
+}
+
+void EventHandler::comment(std::string_view)
+{
+}
+
+}
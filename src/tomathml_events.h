@@ -0,0 +1,40 @@
+#pragma once
+
+#include <span>
+#include <string_view>
+
+#include "tomathml_export.h"
+
+namespace tomathml {
+
+/**
+ * @brief An attribute of an element reported to an EventHandler.
+ *
+ * The name is qualified, e.g. "cellml:units" or "xmlns:cellml".
+ * The views are only valid for the duration of the event.
+ */
+struct Attribute
+{
+    std::string_view name;
+    std::string_view value;
+};
+
+/**
+ * @brief Receiver of the content MathML of a conversion, as a stream of events.
+ *
+ * Events are reported in document order, starting with the math element.
+ * Text is reported without the indentation used by the text output.
+ * All the handlers do nothing by default.
+ */
+class TOMATHML_API EventHandler
+{
+public:
+    virtual ~EventHandler();
+
+    virtual void startElement(std::string_view name, std::span<const Attribute> attributes);
+    virtual void endElement(std::string_view name);
+    virtual void text(std::string_view text);
+    virtual void comment(std::string_view comment);
+};
+
+}
@@ -0,0 +1,369 @@
+#include "tomathml_incremental.h"
+
+#include <algorithm>
+#include <string_view>
+#include <vector>
+
+#include "cellmltext/parser.h"
+#include "cellmltext/scanner.h"
+#include "utils/writer.h"
+#include "utils/xmllite.h"
+
+namespace tomathml {
+
+namespace {
+
+const std::string_view FOOTER = "</math>\n";
+
+// A statement of the text string, i.e. everything from the end of the
+// previous statement up to and including its semicolon, be it whitespace,
+// comments or the equation itself. The last statement runs up to the end of
+// the text string, and is typically empty.
+
+struct Statement
+{
+    std::size_t start;
+    std::size_t outputStart;
+    std::size_t outputSize;
+    bool hoisted;
+};
+
+}
+
+struct IncrementalConverter::Impl
+{
+    Options options;
+    CellMLText::Parser parser;
+    Converter converter;
+
+    // The text string and the statements of the last successful update, and
+    // our output, i.e. a header (the XML declaration and math start tag), the
+    // content MathML of the statements and a footer (the math end tag).
+
+    std::string text;
+    std::vector<Statement> statements;
+    std::string output;
+    std::size_t headerSize = 0;
+    std::size_t hoistedCount = 0;
+    std::string headers[2];
+    bool valid = false;
+
+    // Our output if no statement has any content MathML, in which case the
+    // math element has no children.
+
+    std::string emptyOutput;
+
+    std::size_t reconvertedCount = 0;
+    std::string messages;
+
+    void reset();
+    bool convertStatement(std::string_view statement, std::string &body, bool &hoisted);
+    bool convert(const std::string &newText);
+    bool update(const std::string &newText);
+};
+
+void IncrementalConverter::Impl::reset()
+{
+    text.clear();
+    statements.clear();
+    output.clear();
+    headerSize = 0;
+    hoistedCount = 0;
+    headers[0].clear();
+    headers[1].clear();
+    valid = false;
+    emptyOutput.clear();
+}
+
+bool IncrementalConverter::Impl::convertStatement(std::string_view statement, std::string &body, bool &hoisted)
+{
+    hoisted = false;
+
+    if (statement.find_first_not_of(" \t\r\n") == std::string_view::npos) {
+        return true;
+    }
+
+    ++reconvertedCount;
+
+    parser.setHoistNamespaces(options.hoistNamespaces);
+    parser.setShareSubexpressions(options.shareSubexpressions);
+    parser.setMemoryResource(options.memoryResource);
+
+    if (!parser.execute(std::string(statement), true, options.cellml) || !parser.messages().empty()) {
+        return false;
+    }
+
+    const auto &children = parser.domDocument()->children();
+    const auto &math = children.back();
+
+    hoisted = math->attributes().size() > 1;
+
+    auto &header = headers[hoisted ? 1 : 0];
+
+    if (header.empty()) {
+        utils::Writer writer(header);
+
+        children.front()->print(writer);
+        math->printStartTag(writer, 0);
+        writer.write(">\n");
+    }
+
+    utils::Writer writer(body);
+
+    for (const auto &child : math->children()) {
+        child->print(writer, 2);
+    }
+
+    return true;
+}
+
+bool IncrementalConverter::Impl::convert(const std::string &newText)
+{
+    // Convert the whole text string at once, dropping our statements.
+
+    auto converterOptions = options;
+
+    converterOptions.serializationThreads = 1;
+    converter.setOptions(converterOptions);
+
+    std::string newOutput;
+
+    if (!converter.convert(newText, newOutput)) {
+        messages = converter.messages();
+
+        return false;
+    }
+
+    reset();
+
+    messages = converter.messages();
+    emptyOutput = std::move(newOutput);
+
+    return true;
+}
+
+bool IncrementalConverter::Impl::update(const std::string &newText)
+{
+    reconvertedCount = 0;
+    messages.clear();
+
+    if (options.eliminateCommonSubexpressions || options.checkUnits) {
+        return convert(newText);
+    }
+
+    // Keep the statements that end before the first difference between the
+    // previous and new text strings, except for the last statement since its
+    // end is not that of a statement in the new text string.
+
+    std::size_t statementCount = valid ? statements.size() : 0;
+    std::size_t prefixSize = 0;
+    std::size_t suffixSize = 0;
+    std::size_t keep = 0;
+
+    if (valid) {
+        auto maxSize = std::min(text.size(), newText.size());
+
+        prefixSize = static_cast<std::size_t>(std::mismatch(text.begin(), text.begin() + maxSize, newText.begin()).first - text.begin());
+        maxSize -= prefixSize;
+        suffixSize = static_cast<std::size_t>(std::mismatch(text.rbegin(), text.rbegin() + maxSize, newText.rbegin()).first - text.rbegin());
+
+        while ((keep + 1 < statementCount) && (statements[keep + 1].start <= prefixSize)) {
+            ++keep;
+        }
+    }
+
+    // Scan the new text string from the end of the statements that we keep,
+    // until we reach the start of a statement that is within the common
+    // suffix of the two text strings, since the statements from there are
+    // unchanged (only shifted).
+
+    auto scanStart = (keep < statementCount) ? statements[keep].start : 0;
+    auto delta = static_cast<std::ptrdiff_t>(newText.size()) - static_cast<std::ptrdiff_t>(text.size());
+    auto candidate = keep;
+
+    while ((candidate < statementCount) && (statements[candidate].start < text.size() - suffixSize)) {
+        ++candidate;
+    }
+
+    std::vector<std::size_t> starts = { scanStart };
+    auto reuseFrom = statementCount;
+
+    if (scanStart < newText.size()) {
+        CellMLText::Scanner scanner;
+        int selDepth = 0;
+
+        scanner.setText(newText.substr(scanStart));
+
+        while (scanner.token() != CellMLText::Scanner::Token::Eof) {
+            auto token = scanner.token();
+
+            if (token == CellMLText::Scanner::Token::Sel) {
+                ++selDepth;
+            } else if ((token == CellMLText::Scanner::Token::EndSel) && (selDepth > 0)) {
+                --selDepth;
+            } else if ((token == CellMLText::Scanner::Token::SemiColon) && (selDepth == 0)) {
+                auto end = scanStart + scanner.offset();
+
+                while ((candidate < statementCount)
+                       && (static_cast<std::ptrdiff_t>(statements[candidate].start) + delta < static_cast<std::ptrdiff_t>(end))) {
+                    ++candidate;
+                }
+
+                if ((candidate < statementCount)
+                    && (static_cast<std::ptrdiff_t>(statements[candidate].start) + delta == static_cast<std::ptrdiff_t>(end))) {
+                    reuseFrom = candidate;
+
+                    break;
+                }
+
+                starts.push_back(end);
+            }
+
+            scanner.getNextToken();
+        }
+    }
+
+    // Convert the new statements.
+
+    auto end = (reuseFrom < statementCount) ? statements[reuseFrom].start + delta : newText.size();
+    std::vector<Statement> newStatements;
+    std::string body;
+    std::size_t newHoistedCount = 0;
+
+    newStatements.reserve(starts.size());
+
+    for (std::size_t i = 0; i < starts.size(); ++i) {
+        auto statementEnd = (i + 1 < starts.size()) ? starts[i + 1] : end;
+        auto outputStart = body.size();
+        bool hoisted;
+
+        if (!convertStatement(std::string_view(newText).substr(starts[i], statementEnd - starts[i]), body, hoisted)) {
+            // Either the new text string is invalid or a statement has
+            // messages, whose line and column only a full conversion can get
+            // right.
+
+            return convert(newText);
+        }
+
+        newStatements.push_back({ starts[i], outputStart, body.size() - outputStart, hoisted });
+
+        newHoistedCount += hoisted ? 1 : 0;
+    }
+
+    // Splice the content MathML of the new statements into our output, in
+    // place of that of the statements that they replace.
+
+    if (!valid) {
+        output = FOOTER;
+        headerSize = 0;
+    }
+
+    auto replacedStart = (keep < statementCount) ? statements[keep].outputStart : headerSize;
+    auto replacedEnd = (reuseFrom < statementCount) ? statements[reuseFrom].outputStart : output.size() - FOOTER.size();
+    auto outputDelta = static_cast<std::ptrdiff_t>(body.size()) - static_cast<std::ptrdiff_t>(replacedEnd - replacedStart);
+
+    output.replace(replacedStart, replacedEnd - replacedStart, body);
+
+    for (std::size_t i = keep; i < reuseFrom; ++i) {
+        hoistedCount -= statements[i].hoisted ? 1 : 0;
+    }
+
+    for (std::size_t i = reuseFrom; i < statementCount; ++i) {
+        statements[i].start = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(statements[i].start) + delta);
+        statements[i].outputStart = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(statements[i].outputStart) + outputDelta);
+    }
+
+    for (auto &statement : newStatements) {
+        statement.outputStart += replacedStart;
+    }
+
+    statements.resize(statementCount);
+    statements.erase(statements.begin() + static_cast<std::ptrdiff_t>(keep), statements.begin() + static_cast<std::ptrdiff_t>(reuseFrom));
+    statements.insert(statements.begin() + static_cast<std::ptrdiff_t>(keep), newStatements.begin(), newStatements.end());
+
+    hoistedCount += newHoistedCount;
+    text = newText;
+    valid = true;
+
+    // Update our header, should the math element have gained or lost the
+    // namespaces hoisted by the statements.
+
+    if (output.size() == headerSize + FOOTER.size()) {
+        // No statement has any content MathML, so let a full conversion deal
+        // with the math element having no children.
+
+        std::string newOutput;
+
+        converter.setOptions(options);
+        converter.convert(newText, newOutput);
+
+        emptyOutput = std::move(newOutput);
+
+        return true;
+    }
+
+    emptyOutput.clear();
+
+    const auto &header = headers[(hoistedCount > 0) ? 1 : 0];
+
+    if ((header.size() != headerSize) || (output.compare(0, headerSize, header) != 0)) {
+        auto headerDelta = static_cast<std::ptrdiff_t>(header.size()) - static_cast<std::ptrdiff_t>(headerSize);
+
+        output.replace(0, headerSize, header);
+
+        headerSize = header.size();
+
+        for (auto &statement : statements) {
+            statement.outputStart = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(statement.outputStart) + headerDelta);
+        }
+    }
+
+    return true;
+}
+
+IncrementalConverter::IncrementalConverter(const Options &options)
+    : mImpl(std::make_unique<Impl>())
+{
+    mImpl->options = options;
+}
+
+IncrementalConverter::~IncrementalConverter() = default;
+
+const Options &IncrementalConverter::options() const
+{
+    return mImpl->options;
+}
+
+void IncrementalConverter::setOptions(const Options &options)
+{
+    mImpl->options = options;
+
+    mImpl->reset();
+}
+
+bool IncrementalConverter::update(const std::string &text)
+{
+    return mImpl->update(text);
+}
+
+const std::string &IncrementalConverter::output() const
+{
+    return (mImpl->valid && mImpl->emptyOutput.empty()) ? mImpl->output : mImpl->emptyOutput;
+}
+
+std::string IncrementalConverter::messages() const
+{
+    return mImpl->messages;
+}
+
+std::size_t IncrementalConverter::statementCount() const
+{
+    return mImpl->valid ? mImpl->statements.size() : 0;
+}
+
+std::size_t IncrementalConverter::reconvertedStatementCount() const
+{
+    return mImpl->reconvertedCount;
+}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "tomathml_converter.h"
+#include "tomathml_export.h"
+
+namespace tomathml {
+
+/**
+ * @brief Converter of a text string that changes over time, e.g. in an editor.
+ *
+ * The text string is split into its statements and the content MathML of
+ * each of them is kept, so that an update only reconverts the statements
+ * that changed, and splices their content MathML into the previous output.
+ * The statements that precede and follow an edit are found by comparing the
+ * new text string with the previous one, so that not even they get scanned
+ * again. The output is the same as that of Converter::convert().
+ *
+ * Common subexpression elimination and units checking span statements, so
+ * with either of them every update is a full conversion.
+ * An incremental converter must not be used from more than one thread at a
+ * time.
+ */
+class TOMATHML_API IncrementalConverter
+{
+public:
+    explicit IncrementalConverter(const Options &options = Options());
+    ~IncrementalConverter();
+
+    IncrementalConverter(const IncrementalConverter &) = delete;
+    IncrementalConverter &operator=(const IncrementalConverter &) = delete;
+
+    const Options &options() const;
+
+    /**
+     * @brief Set the options, which discards the statements kept so far.
+     */
+    void setOptions(const Options &options);
+
+    /**
+     * @brief Update the text string and convert it.
+     *
+     * If the conversion fails, the statements and output of the last
+     * successful update are kept, so that the next update can still reuse
+     * them.
+     *
+     * @param text The new string of mathematical equations.
+     * @return True if successful, false otherwise.
+     */
+    bool update(const std::string &text);
+
+    /**
+     * @brief The content MathML of the last successful update.
+     */
+    const std::string &output() const;
+
+    /**
+     * @brief The messages from the last update, in the same form as
+     * Converter::messages() returns them.
+     */
+    std::string messages() const;
+
+    /**
+     * @brief The number of statements of the text string of the last
+     * successful update.
+     */
+    std::size_t statementCount() const;
+
+    /**
+     * @brief The number of statements converted by the last update.
+     */
+    std::size_t reconvertedStatementCount() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> mImpl;
+};
+
+}
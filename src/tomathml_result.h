@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace tomathml {
+
+/**
+ * @brief A diagnostic, i.e. an error or a warning, from a conversion.
+ */
+struct Diagnostic
+{
+    enum class Severity
+    {
+        Error, /**< The conversion failed. */
+        Warning /**< The conversion succeeded, but something is suspicious. */
+    };
+
+    Severity severity = Severity::Error;
+
+    /**
+     * What reported the diagnostic, e.g. "parser".
+     */
+    std::string source;
+
+    /**
+     * The line and column the diagnostic refers to, or 0 if it doesn't refer
+     * to the text.
+     */
+    int line = 0;
+    int column = 0;
+
+    std::string message;
+};
+
+/**
+ * @brief Statistics of a conversion.
+ */
+struct ConvertStatistics
+{
+    /**
+     * The sizes, in bytes, of the text and of the content MathML.
+     */
+    std::size_t inputSize = 0;
+    std::size_t outputSize = 0;
+
+    /**
+     * The time, in seconds, spent parsing the text and serialising the
+     * content MathML.
+     */
+    double parseTime = 0.0;
+    double serializationTime = 0.0;
+};
+
+/**
+ * @brief The result of a conversion.
+ */
+struct ConvertResult
+{
+    bool success = false;
+
+    /**
+     * The content MathML, or an empty string if the conversion failed.
+     */
+    std::string output;
+
+    std::vector<Diagnostic> diagnostics;
+    ConvertStatistics statistics;
+
+    explicit operator bool() const
+    {
+        return success;
+    }
+};
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "tomathml_export.h"
+
+namespace tomathml {
+
+/**
+ * @brief A sparse boolean matrix in compressed sparse row (CSR) form.
+ *
+ * The column indices of row i are columnIndices[rowOffsets[i]] to
+ * columnIndices[rowOffsets[i + 1] - 1], in increasing order.
+ */
+struct SparseMatrix
+{
+    std::size_t rowCount = 0;
+    std::size_t columnCount = 0;
+    std::vector<std::size_t> rowOffsets;
+    std::vector<std::size_t> columnIndices;
+
+    /**
+     * @brief The row index of each entry, i.e. the rows of the coordinate (COO)
+     * form of the matrix, whose columns are columnIndices.
+     */
+    std::vector<std::size_t> rowIndices() const
+    {
+        std::vector<std::size_t> res;
+
+        res.reserve(columnIndices.size());
+        for (std::size_t i = 0; i < rowCount; ++i) {
+            res.insert(res.end(), rowOffsets[i + 1] - rowOffsets[i], i);
+        }
+
+        return res;
+    }
+};
+
+/**
+ * @brief The structure of a set of equations, i.e. which variables each equation uses.
+ */
+struct Structure
+{
+    /**
+     * The variables of the equations. The states, i.e. the variables of the
+     * ODEs, come first, in the order of their ODEs, followed by the other
+     * variables, in order of first use.
+     */
+    std::vector<std::string> variables;
+
+    /**
+     * The number of states, i.e. the states are variables[0] to variables[stateCount - 1].
+     */
+    std::size_t stateCount = 0;
+
+    /**
+     * The incidence matrix, with one row per equation, in the order of the
+     * equations, and one column per variable. An equation uses the variable
+     * of its left-hand side (but not the variable of integration of an ODE)
+     * and those of its right-hand side.
+     */
+    SparseMatrix incidence;
+
+    /**
+     * The sparsity pattern of the Jacobian of the rates with respect to the
+     * states, with one row per ODE, in the order of the ODEs, and one column
+     * per state. The rate of an ODE depends on a state if its right-hand side
+     * uses the state, directly or through algebraic variables.
+     */
+    SparseMatrix jacobianSparsity;
+
+    /**
+     * The equations, by index, sorted in blocks in a block-lower-triangular
+     * (BLT) evaluation order, i.e. each block only depends on itself and on the
+     * blocks before it. An equation depends on the equations that compute the
+     * algebraic variables its right-hand side uses. A block with more than one
+     * equation, or an equation that uses its own variable, is an algebraic loop
+     * whose equations must be solved together. The equations of a block are in
+     * increasing order.
+     */
+    std::vector<std::vector<std::size_t>> blocks;
+
+    /**
+     * The level of each block, i.e. 0 for a block that depends on no other
+     * block, and one more than the highest level of the blocks it depends on
+     * otherwise. The blocks of a level can be evaluated in parallel once those
+     * of the lower levels have been evaluated.
+     */
+    std::vector<std::size_t> blockLevels;
+};
+
+}
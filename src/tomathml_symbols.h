@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace tomathml {
+
+/**
+ * @brief A symbol, i.e. a variable, of a text string of equations.
+ */
+struct Symbol
+{
+    /**
+     * @brief The role of a symbol, from the strongest to the weakest.
+     *
+     * A symbol has the strongest of the roles of its occurrences.
+     */
+    enum class Role
+    {
+        State, /**< The variable of the left-hand side of an ODE. */
+        Algebraic, /**< The left-hand side of an algebraic equation. */
+        VariableOfIntegration, /**< The variable of integration of a derivative. */
+        RightHandSide /**< Only used on right-hand sides. */
+    };
+
+    std::string name;
+
+    /**
+     * The number of occurrences of the symbol.
+     */
+    std::size_t count = 0;
+
+    /**
+     * The line and column of the first occurrence of the symbol.
+     */
+    int line = 0;
+    int column = 0;
+
+    Role role = Role::RightHandSide;
+};
+
+/**
+ * @brief Summary statistics of a text string of equations.
+ */
+struct Summary
+{
+    std::size_t odeCount = 0;
+    std::size_t algebraicEquationCount = 0;
+
+    /**
+     * The symbols, in order of first occurrence.
+     */
+    std::vector<Symbol> symbols;
+};
+
+}
@@ -0,0 +1,104 @@
+#include "hash.h"
+
+#include <cstring>
+
+namespace utils {
+
+namespace {
+
+constexpr std::uint64_t C1 = 0x87c37b91114253d5ULL;
+constexpr std::uint64_t C2 = 0x4cf5ad432745937fULL;
+
+std::uint64_t rotl(std::uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+std::uint64_t fmix(std::uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+
+    return k;
+}
+
+std::uint64_t block(const char* data) {
+    // Blocks are read as little-endian, whatever the platform, so that hashes
+    // are the same everywhere.
+
+    std::uint64_t res = 0;
+
+    for (int i = 7; i >= 0; --i) {
+        res = (res << 8) | static_cast<unsigned char>(data[i]);
+    }
+
+    return res;
+}
+
+}
+
+Hash128 hash128(std::string_view data, std::uint64_t seed) {
+    std::uint64_t h1 = seed;
+    std::uint64_t h2 = seed;
+    std::size_t blockCount = data.size() / 16;
+    const char* blocks = data.data();
+
+    for (std::size_t i = 0; i < blockCount; ++i) {
+        std::uint64_t k1 = block(blocks + 16 * i);
+        std::uint64_t k2 = block(blocks + 16 * i + 8);
+
+        k1 *= C1;
+        k1 = rotl(k1, 31);
+        k1 *= C2;
+        h1 ^= k1;
+
+        h1 = rotl(h1, 27);
+        h1 += h2;
+        h1 = h1 * 5 + 0x52dce729;
+
+        k2 *= C2;
+        k2 = rotl(k2, 33);
+        k2 *= C1;
+        h2 ^= k2;
+
+        h2 = rotl(h2, 31);
+        h2 += h1;
+        h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    // Mix in the remaining bytes, if any.
+
+    char tail[16] = {};
+
+    std::memcpy(tail, blocks + 16 * blockCount, data.size() % 16);
+
+    std::uint64_t k1 = block(tail);
+    std::uint64_t k2 = block(tail + 8);
+
+    k2 *= C2;
+    k2 = rotl(k2, 33);
+    k2 *= C1;
+    h2 ^= k2;
+
+    k1 *= C1;
+    k1 = rotl(k1, 31);
+    k1 *= C2;
+    h1 ^= k1;
+
+    h1 ^= data.size();
+    h2 ^= data.size();
+
+    h1 += h2;
+    h2 += h1;
+
+    h1 = fmix(h1);
+    h2 = fmix(h2);
+
+    h1 += h2;
+    h2 += h1;
+
+    return {h1, h2};
+}
+
+}
@@ -0,0 +1,20 @@
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace utils {
+
+// 128-bit hash of some data, i.e. MurmurHash3 (x64, 128-bit variant), which is
+// fast and has no known collisions in practice for such keys.
+struct Hash128 {
+    std::uint64_t low = 0;
+    std::uint64_t high = 0;
+
+    bool operator==(const Hash128& other) const = default;
+};
+
+Hash128 hash128(std::string_view data, std::uint64_t seed = 0);
+
+}
@@ -0,0 +1,166 @@
+
+#include "threadpool.h"
+
+#include <atomic>
+#include <exception>
+
+namespace utils {
+
+ThreadPool::ThreadPool(unsigned int threadCount) {
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+
+    mThreads.reserve(threadCount);
+    for (unsigned int i = 0; i < threadCount; ++i) {
+        mThreads.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mTaskAvailable.notify_all();
+    for (auto& thread : mThreads) {
+        thread.join();
+    }
+}
+
+unsigned int ThreadPool::threadCount() const {
+    return static_cast<unsigned int>(mThreads.size());
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTasks.push(std::move(task));
+        ++mPendingTasks;
+    }
+    mTaskAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mTasksDone.wait(lock, [this] { return mPendingTasks == 0; });
+}
+
+void parallelFor(ThreadPool& pool, std::size_t count,
+                 const std::function<void(unsigned int, std::size_t)>& body) {
+    struct alignas(64) Range {
+        std::mutex mutex;
+        std::size_t begin = 0;
+        std::size_t end = 0;
+    };
+
+    auto workerCount = pool.threadCount();
+    std::vector<Range> ranges(workerCount);
+
+    for (unsigned int i = 0; i < workerCount; ++i) {
+        ranges[i].begin = count * i / workerCount;
+        ranges[i].end = count * (i + 1) / workerCount;
+    }
+
+    // Take the next index of our own range or, if it is empty, steal the back
+    // half of the first other range that is not.
+
+    auto next = [&](unsigned int worker, std::size_t& index) {
+        auto& own = ranges[worker];
+
+        {
+            std::lock_guard<std::mutex> lock(own.mutex);
+
+            if (own.begin < own.end) {
+                index = own.begin++;
+
+                return true;
+            }
+        }
+
+        for (unsigned int i = 1; i < workerCount; ++i) {
+            auto& victim = ranges[(worker + i) % workerCount];
+            std::size_t begin;
+            std::size_t end;
+
+            {
+                std::lock_guard<std::mutex> lock(victim.mutex);
+
+                if (victim.begin == victim.end) {
+                    continue;
+                }
+
+                end = victim.end;
+                begin = end - (victim.end - victim.begin + 1) / 2;
+                victim.end = begin;
+            }
+
+            std::lock_guard<std::mutex> lock(own.mutex);
+
+            own.begin = begin + 1;
+            own.end = end;
+            index = begin;
+
+            return true;
+        }
+
+        return false;
+    };
+
+    // An exception must not escape a task, since it would terminate us, so
+    // keep the first one and rethrow it once all the workers are done.
+
+    std::mutex exceptionMutex;
+    std::exception_ptr exception;
+    std::atomic<bool> failed = false;
+
+    for (unsigned int worker = 0; worker < workerCount; ++worker) {
+        pool.submit([&, worker] {
+            std::size_t index;
+
+            try {
+                while (!failed.load(std::memory_order_relaxed) && next(worker, index)) {
+                    body(worker, index);
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(exceptionMutex);
+
+                if (exception == nullptr) {
+                    exception = std::current_exception();
+                }
+
+                failed = true;
+            }
+        });
+    }
+
+    pool.wait();
+
+    if (exception != nullptr) {
+        std::rethrow_exception(exception);
+    }
+}
+
+void ThreadPool::work() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mTaskAvailable.wait(lock, [this] { return mStopping || !mTasks.empty(); });
+            if (mTasks.empty()) {
+                return;
+            }
+            task = std::move(mTasks.front());
+            mTasks.pop();
+        }
+
+        task();
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (--mPendingTasks == 0) {
+            mTasksDone.notify_all();
+        }
+    }
+}
+
+}
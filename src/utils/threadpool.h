@@ -0,0 +1,52 @@
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace utils {
+
+// Fixed size pool of worker threads running the tasks submitted to it.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned int threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned int threadCount() const;
+
+    void submit(std::function<void()> task);
+    void wait();
+
+private:
+    std::vector<std::thread> mThreads;
+    std::queue<std::function<void()>> mTasks;
+    std::mutex mMutex;
+    std::condition_variable mTaskAvailable;
+    std::condition_variable mTasksDone;
+    std::size_t mPendingTasks = 0;
+    bool mStopping = false;
+
+    void work();
+};
+
+// Run body(worker, index) for every index from 0 to count - 1 on the given
+// pool, with worker, from 0 to pool.threadCount() - 1, identifying the worker
+// that runs it, so that the body can use per-worker state. Each worker starts
+// with an equal share of the indices and, once done with it, steals half of
+// the remaining indices of another worker, so that all the workers keep busy
+// even if the indices take very different times. If the body throws, the
+// workers stop taking indices and the first exception is rethrown on the
+// calling thread once they are done. The pool must not be used for anything
+// else in the meantime.
+void parallelFor(ThreadPool& pool, std::size_t count,
+                 const std::function<void(unsigned int, std::size_t)>& body);
+
+}
@@ -0,0 +1,32 @@
+#include "writer.h"
+
+#include <limits>
+#include <utility>
+
+namespace utils {
+
+Writer::Writer(std::string& output)
+    : mOutput(&output), mBufferSize(std::numeric_limits<std::size_t>::max())
+{
+}
+
+Writer::Writer(Sink sink, std::size_t bufferSize)
+    : mOutput(&mBuffer), mSink(std::move(sink)), mBufferSize(bufferSize)
+{
+    mBuffer.reserve(bufferSize);
+}
+
+Writer::~Writer() {
+    flush();
+}
+
+void Writer::flush() {
+    if (!mSink || mBuffer.empty()) {
+        return;
+    }
+
+    mSink(mBuffer.data(), mBuffer.size());
+    mBuffer.clear();
+}
+
+}
@@ -0,0 +1,53 @@
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace utils {
+
+// Writer of text into either a string, which keeps its capacity from one use
+// to the next, or a sink, which gets the text in chunks of about bufferSize
+// characters so that the whole text never needs to be held in memory.
+class Writer {
+public:
+    using Sink = std::function<void(const char* data, std::size_t size)>;
+
+    explicit Writer(std::string& output);
+    explicit Writer(Sink sink, std::size_t bufferSize = 65536);
+    ~Writer();
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    void write(std::string_view text) {
+        mOutput->append(text);
+        if (mOutput->size() >= mBufferSize) {
+            flush();
+        }
+    }
+
+    void write(char c) {
+        mOutput->push_back(c);
+        if (mOutput->size() >= mBufferSize) {
+            flush();
+        }
+    }
+
+    void indent(int count) {
+        mOutput->append(static_cast<std::size_t>(count), ' ');
+    }
+
+    // Hand the buffered text, if any, over to our sink.
+    void flush();
+
+private:
+    std::string mBuffer;
+    std::string* mOutput;
+    Sink mSink;
+    std::size_t mBufferSize;
+};
+
+}
@@ -1,8 +1,14 @@
+#include <algorithm>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <utility>
 
 #include "xmllite.h"
 
+#include "threadpool.h"
+#include "writer.h"
+
 namespace utils {
 
 XmlAttribute::XmlAttribute(const std::string& name, const std::string& value,
@@ -11,6 +17,18 @@ XmlAttribute::XmlAttribute(const std::string& name, const std::string& value,
 {
 }
 
+const std::string& XmlAttribute::name() const {
+    return mName;
+}
+
+const std::string& XmlAttribute::value() const {
+    return mValue;
+}
+
+const std::string& XmlAttribute::namespacePrefix() const {
+    return mNamespacePrefix;
+}
+
 std::string XmlAttribute::toString() const
 {
     std::string fullName = mNamespacePrefix.empty() ? mName : mNamespacePrefix + ":" + mName;
@@ -19,8 +37,9 @@ std::string XmlAttribute::toString() const
 
 
 XmlNode::XmlNode(XmlNodeType type, const std::string& name,
-            const std::string& nsPrefix)
+            const std::string& nsPrefix, std::pmr::memory_resource* resource)
             : mType(type), mName(name), mNamespacePrefix(nsPrefix)
+            , mAttributes(resource), mChildren(resource)
 {
 }
 
@@ -38,48 +57,288 @@ void XmlNode::addChild(XmlNodePtr child) {
     mChildren.push_back(child);
 }
 
+void XmlNode::setChildren(std::vector<XmlNodePtr> children) {
+    mChildren.assign(std::make_move_iterator(children.begin()), std::make_move_iterator(children.end()));
+}
+
+XmlNodeType XmlNode::type() const {
+    return mType;
+}
+
+const std::string& XmlNode::name() const {
+    return mName;
+}
+
+const std::string& XmlNode::namespacePrefix() const {
+    return mNamespacePrefix;
+}
+
+const std::pmr::vector<XmlAttribute>& XmlNode::attributes() const {
+    return mAttributes;
+}
+
+const std::pmr::vector<XmlNodePtr>& XmlNode::children() const {
+    return mChildren;
+}
+
+void XmlNode::printTagName(Writer& writer) const {
+    if (!mNamespacePrefix.empty()) {
+        writer.write(mNamespacePrefix);
+        writer.write(':');
+    }
+    writer.write(mName);
+}
+
+void XmlNode::printStartTag(Writer& writer, int indent) const {
+    writer.indent(indent);
+    writer.write('<');
+    printTagName(writer);
+    for (const auto& attr : mAttributes) {
+        writer.write(' ');
+        if (!attr.namespacePrefix().empty()) {
+            writer.write(attr.namespacePrefix());
+            writer.write(':');
+        }
+        writer.write(attr.name());
+        writer.write("=\"");
+        writer.write(attr.value());
+        writer.write('"');
+    }
+}
+
+void XmlNode::printEndTag(Writer& writer, int indent) const {
+    writer.indent(indent);
+    writer.write("</");
+    printTagName(writer);
+    writer.write(">\n");
+}
+
 void XmlNode::print(std::ostream& os, int indent) const {
-    std::string indentStr(indent, ' ');
-    std::string tagName = mNamespacePrefix.empty() ? mName : mNamespacePrefix + ":" + mName;
+    Writer writer([&os](const char* data, std::size_t size) {
+        os.write(data, static_cast<std::streamsize>(size));
+    });
+
+    print(writer, indent);
+}
 
+void XmlNode::print(Writer& writer, int indent) const {
     switch (mType) {
         case XmlNodeType::Root:
             for (const auto& child : mChildren) {
-                child->print(os);
+                child->print(writer);
             }
             break;
         case XmlNodeType::Element:
-            os << indentStr << "<" << tagName;
-            for (const auto& attr : mAttributes) {
-                os << " " << attr.toString();
-            }
+            printStartTag(writer, indent);
             if (mChildren.empty()) {
-                os << " />\n";
+                writer.write(" />\n");
             } else {
-                os << ">\n";
+                writer.write(">\n");
                 for (const auto& child : mChildren) {
-                    child->print(os, indent + 2);
+                    child->print(writer, indent + 2);
                 }
-                os << indentStr << "</" << tagName << ">\n";
+                printEndTag(writer, indent);
             }
             break;
         case XmlNodeType::Text:
-            os << indentStr << mName << "\n";
+            writer.indent(indent);
+            writer.write(mName);
+            writer.write('\n');
             break;
         case XmlNodeType::Comment:
-            os << indentStr << "<!-- " << mName << " -->\n";
+            writer.indent(indent);
+            writer.write("<!-- ");
+            writer.write(mName);
+            writer.write(" -->\n");
             break;
         case XmlNodeType::Declaration:
-            os << indentStr << "<?" << mName << "?>\n";
+            writer.indent(indent);
+            writer.write("<?");
+            writer.write(mName);
+            writer.write("?>\n");
             break;
     }
 }
 
+void XmlNode::print(std::ostream& os, ThreadPool& pool, int indent) const {
+    Writer writer([&os](const char* data, std::size_t size) {
+        os.write(data, static_cast<std::streamsize>(size));
+    });
+
+    print(writer, pool, indent);
+}
+
+void XmlNode::print(Writer& writer, ThreadPool& pool, int indent) const {
+    if (mType == XmlNodeType::Root) {
+        for (const auto& child : mChildren) {
+            child->print(writer, pool);
+        }
+
+        return;
+    }
+
+    if ((mType != XmlNodeType::Element) || (mChildren.size() < 2) || (pool.threadCount() < 2)) {
+        print(writer, indent);
+
+        return;
+    }
+
+    printStartTag(writer, indent);
+    writer.write(">\n");
+    printChildren(writer, 0, mChildren.size(), indent + 2, &pool);
+    printEndTag(writer, indent);
+}
+
+void XmlNode::printChildren(Writer& writer, std::size_t first, std::size_t last, int indent,
+                            ThreadPool* pool) const {
+    std::size_t count = last - first;
+
+    if ((pool == nullptr) || (count < 2) || (pool->threadCount() < 2)) {
+        for (std::size_t i = first; i < last; ++i) {
+            mChildren[i]->print(writer, indent);
+        }
+
+        return;
+    }
+
+    // Serialise our children in chunks, a few per thread so that a chunk of
+    // large children doesn't hold everything up, and then output the chunks
+    // in order.
+
+    std::size_t chunkCount = std::min(count, std::size_t(4) * pool->threadCount());
+    std::size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+    std::vector<std::string> chunks((count + chunkSize - 1) / chunkSize);
+
+    parallelFor(*pool, chunks.size(), [this, &chunks, first, last, chunkSize, indent](unsigned int, std::size_t i) {
+        Writer chunkWriter(chunks[i]);
+        std::size_t end = std::min(last, first + (i + 1) * chunkSize);
+        for (std::size_t j = first + i * chunkSize; j < end; ++j) {
+            mChildren[j]->print(chunkWriter, indent);
+        }
+    });
+
+    for (const auto& chunk : chunks) {
+        writer.write(chunk);
+    }
+}
+
 
 // Helper
 XmlNodePtr createNode(XmlNodeType type, const std::string& name,
-                      const std::string& nsPrefix) {
-    return std::make_shared<XmlNode>(type, name, nsPrefix);
+                      const std::string& nsPrefix,
+                      std::pmr::memory_resource* resource) {
+    return std::allocate_shared<XmlNode>(std::pmr::polymorphic_allocator<XmlNode>(resource),
+                                         type, name, nsPrefix, resource);
+}
+
+
+namespace {
+
+void hashCombine(std::size_t& seed, std::size_t value) {
+    seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+}
+
+template<typename Attributes, typename Children>
+std::size_t hashNode(XmlNodeType type, const std::string& name, const std::string& nsPrefix,
+                     const Attributes& attributes, const Children& children) {
+    std::hash<std::string> stringHash;
+    std::size_t seed = static_cast<std::size_t>(type);
+
+    hashCombine(seed, stringHash(name));
+    hashCombine(seed, stringHash(nsPrefix));
+    for (const auto& attr : attributes) {
+        hashCombine(seed, stringHash(attr.name()));
+        hashCombine(seed, stringHash(attr.value()));
+    }
+    for (const auto& child : children) {
+        hashCombine(seed, std::hash<XmlNode*>()(child.get()));
+    }
+
+    return seed;
+}
+
+template<typename Attributes, typename Children>
+bool equalNode(const XmlNodePtr& node, XmlNodeType type, const std::string& name, const std::string& nsPrefix,
+               const Attributes& attributes, const Children& children) {
+    // Children are compared by identity since they have already been interned.
+
+    return (node->type() == type)
+        && (node->name() == name)
+        && (node->namespacePrefix() == nsPrefix)
+        && std::equal(node->attributes().begin(), node->attributes().end(), attributes.begin(), attributes.end())
+        && std::equal(node->children().begin(), node->children().end(), children.begin(), children.end());
+}
+
+}
+
+std::size_t XmlNodePool::Hash::operator()(const XmlNodePtr& node) const {
+    return hashNode(node->type(), node->name(), node->namespacePrefix(), node->attributes(), node->children());
+}
+
+std::size_t XmlNodePool::Hash::operator()(const Key& key) const {
+    return hashNode(key.type, key.name, key.nsPrefix, key.attributes, key.children);
+}
+
+bool XmlNodePool::Equal::operator()(const XmlNodePtr& node, const XmlNodePtr& other) const {
+    return equalNode(node, other->type(), other->name(), other->namespacePrefix(), other->attributes(), other->children());
+}
+
+bool XmlNodePool::Equal::operator()(const XmlNodePtr& node, const Key& key) const {
+    return equalNode(node, key.type, key.name, key.nsPrefix, key.attributes, key.children);
+}
+
+bool XmlNodePool::Equal::operator()(const Key& key, const XmlNodePtr& node) const {
+    return equalNode(node, key.type, key.name, key.nsPrefix, key.attributes, key.children);
+}
+
+XmlNodePool::XmlNodePool(std::pmr::memory_resource* resource)
+    : mNodes(resource) {
+}
+
+XmlNodePtr XmlNodePool::intern(const XmlNodePtr& node) {
+    return *mNodes.insert(node).first;
+}
+
+XmlNodePtr XmlNodePool::intern(XmlNodeType type, const std::string& name,
+                               const std::string& nsPrefix,
+                               std::span<const XmlAttribute> attributes,
+                               std::span<const XmlNodePtr> children) {
+    auto iter = mNodes.find(Key {type, name, nsPrefix, attributes, children});
+
+    if (iter != mNodes.end()) {
+        return *iter;
+    }
+
+    auto node = createNode(type, name, nsPrefix, resource());
+
+    for (const auto& attr : attributes) {
+        node->addAttribute(attr.name(), attr.value(), attr.namespacePrefix());
+    }
+    for (const auto& child : children) {
+        node->addChild(child);
+    }
+
+    return *mNodes.insert(node).first;
+}
+
+std::size_t XmlNodePool::size() const {
+    return mNodes.size();
+}
+
+void XmlNodePool::clear() {
+    mNodes.clear();
+}
+
+std::pmr::memory_resource* XmlNodePool::resource() const {
+    return mNodes.get_allocator().resource();
+}
+
+void XmlNodePool::reset(std::pmr::memory_resource* resource) {
+    // The allocator of a container cannot be changed, so replace our set with
+    // an empty one that uses the given memory resource.
+
+    std::destroy_at(&mNodes);
+    std::construct_at(&mNodes, 0, Hash(), Equal(), resource);
 }
 
 }
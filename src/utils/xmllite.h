@@ -1,11 +1,16 @@
 #pragma once
 
 #include <memory>
+#include <memory_resource>
+#include <span>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 namespace utils {
 
+class ThreadPool;
+class Writer;
 class XmlNode;
 using XmlNodePtr = std::shared_ptr<XmlNode>;
 
@@ -17,8 +22,11 @@ enum class XmlNodeType {
     Root
 };
 
+// Create a node, allocating it, and its attributes and children, from the
+// given memory resource, which must outlive it.
 XmlNodePtr createNode(XmlNodeType type, const std::string& name,
-                      const std::string& nsPrefix = "");
+                      const std::string& nsPrefix = "",
+                      std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
 
 class XmlAttribute {
@@ -26,8 +34,14 @@ public:
     XmlAttribute(const std::string& name, const std::string& value,
                  const std::string& nsPrefix = "");
 
+    const std::string& name() const;
+    const std::string& value() const;
+    const std::string& namespacePrefix() const;
+
     std::string toString() const;
 
+    bool operator==(const XmlAttribute& other) const = default;
+
 private:
     std::string mName;
     std::string mValue;
@@ -38,7 +52,8 @@ private:
 class XmlNode {
 public:
     XmlNode(XmlNodeType type, const std::string& name,
-            const std::string& nsPrefix = "");
+            const std::string& nsPrefix = "",
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
     void addAttribute(const std::string& name, const std::string& value,
                       const std::string& nsPrefix = "");
@@ -46,15 +61,96 @@ public:
     void declareNamespace(const std::string& prefix, const std::string& uri);
 
     void addChild(XmlNodePtr child);
+    void setChildren(std::vector<XmlNodePtr> children);
+
+    XmlNodeType type() const;
+    const std::string& name() const;
+    const std::string& namespacePrefix() const;
+    const std::pmr::vector<XmlAttribute>& attributes() const;
+    const std::pmr::vector<XmlNodePtr>& children() const;
 
     void print(std::ostream& os, int indent = 0) const;
+    void print(Writer& writer, int indent = 0) const;
+
+    // Print the children of the first element that has several of them (e.g.
+    // the equations of a math element) in chunks on the given thread pool.
+    // The output is identical to that of print().
+    void print(std::ostream& os, ThreadPool& pool, int indent = 0) const;
+    void print(Writer& writer, ThreadPool& pool, int indent = 0) const;
+
+    // Print the start tag of an element, without its closing '>' or '/>', or
+    // its end tag, so that its children can be printed separately.
+    void printStartTag(Writer& writer, int indent) const;
+    void printEndTag(Writer& writer, int indent) const;
+
+    // Print the children from first to last - 1, e.g. a few equations of a
+    // math element at a time, in chunks on the given thread pool, if any.
+    void printChildren(Writer& writer, std::size_t first, std::size_t last, int indent,
+                       ThreadPool* pool = nullptr) const;
 
 private:
     XmlNodeType mType;
     std::string mName;
     std::string mNamespacePrefix;
-    std::vector<XmlAttribute> mAttributes;
-    std::vector<XmlNodePtr> mChildren;
+    std::pmr::vector<XmlAttribute> mAttributes;
+    std::pmr::vector<XmlNodePtr> mChildren;
+
+    void printTagName(Writer& writer) const;
+};
+
+
+// Pool of structurally unique nodes, used to share identical subtrees.
+// Nodes are expected to be interned bottom-up, i.e. once all of their children
+// have been interned, so that two nodes are identical if they have the same
+// type, name, namespace prefix and attributes, and the very same children.
+// An interned node must not be modified anymore.
+class XmlNodePool {
+public:
+    explicit XmlNodePool(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    XmlNodePtr intern(const XmlNodePtr& node);
+
+    // Return the node with the given type, name, namespace prefix, attributes
+    // and (interned) children, only creating it if it is not in the pool yet,
+    // so that nothing gets allocated for a node that is already shared.
+    XmlNodePtr intern(XmlNodeType type, const std::string& name,
+                      const std::string& nsPrefix,
+                      std::span<const XmlAttribute> attributes,
+                      std::span<const XmlNodePtr> children);
+
+    std::size_t size() const;
+    void clear();
+
+    // Clear the pool, and allocate from the given memory resource from now on.
+    std::pmr::memory_resource* resource() const;
+    void reset(std::pmr::memory_resource* resource);
+
+private:
+    // The parts of a node that has yet to be created.
+    struct Key {
+        XmlNodeType type;
+        const std::string& name;
+        const std::string& nsPrefix;
+        std::span<const XmlAttribute> attributes;
+        std::span<const XmlNodePtr> children;
+    };
+
+    struct Hash {
+        using is_transparent = void;
+
+        std::size_t operator()(const XmlNodePtr& node) const;
+        std::size_t operator()(const Key& key) const;
+    };
+
+    struct Equal {
+        using is_transparent = void;
+
+        bool operator()(const XmlNodePtr& node, const XmlNodePtr& other) const;
+        bool operator()(const XmlNodePtr& node, const Key& key) const;
+        bool operator()(const Key& key, const XmlNodePtr& node) const;
+    };
+
+    std::pmr::unordered_set<XmlNodePtr, Hash, Equal> mNodes;
 };
 
 }
@@ -183,3 +183,118 @@ R"JK(<?xml version="1.0" encoding="UTF-8"?>
   </apply>
 </math>
 )JK";
+
+const char * expected_test_result_8 =
+R"JK(<?xml version="1.0" encoding="UTF-8"?>
+<math xmlns="http://www.w3.org/1998/Math/MathML" xmlns:cellml="http://www.cellml.org/cellml/2.0#">
+  <apply>
+    <eq />
+    <apply>
+      <diff />
+      <bvar>
+        <ci>
+          t
+        </ci>
+        <degree>
+          <cn cellml:units="dimensionless">
+            2
+          </cn>
+        </degree>
+      </bvar>
+      <ci>
+        x
+      </ci>
+    </apply>
+    <apply>
+      <minus />
+      <ci>
+        a
+      </ci>
+      <cn cellml:units="volt">
+        3
+      </cn>
+    </apply>
+  </apply>
+</math>
+)JK";
+
+const char * expected_test_result_9 =
+R"JK(<?xml version="1.0" encoding="UTF-8"?>
+<math xmlns="http://www.w3.org/1998/Math/MathML">
+  <apply>
+    <eq />
+    <ci>
+      a
+    </ci>
+    <piecewise>
+      <piece>
+        <ci>
+          c
+        </ci>
+        <apply>
+          <gt />
+          <ci>
+            b
+          </ci>
+          <cn>
+            1
+          </cn>
+        </apply>
+      </piece>
+      <otherwise>
+        <ci>
+          d
+        </ci>
+      </otherwise>
+    </piecewise>
+  </apply>
+</math>
+)JK";
+
+const std::string expected_test_result_10 = R"JK({"op":"eq","args":[{"op":"diff","bvar":{"ci":"t"},"degree":{"cn":"2","units":"dimensionless"},"args":[{"ci":"x"}]},{"op":"minus","args":[{"op":"log","logbase":{"cn":"2","units":"dimensionless"},"args":[{"ci":"a"}]},{"cn":"1.2e-3","units":"volt"}]}]}
+{"op":"eq","args":[{"ci":"b"},{"op":"root","degree":{"cn":"3","units":"dimensionless"},"args":[{"const":"pi"}]}]}
+)JK";
+
+const std::string expected_test_result_11 = R"JK({"op":"eq","args":[{"ci":"a"},{"piecewise":[{"value":{"ci":"c"},"condition":{"op":"gt","args":[{"ci":"b"},{"cn":"1"}]}}],"otherwise":{"ci":"d"}}]}
+)JK";
+
+const std::string expected_test_result_12 = R"JK(#include <math.h>
+
+/*
+ * states[0]: V
+ * states[1]: m
+ * params[0]: E
+ * params[1]: alpha
+ * params[2]: g
+ */
+void rhs(const double *states, const double *params, double *rates)
+{
+    const double V = states[0];
+    const double m = states[1];
+    const double E = params[0];
+    const double alpha = params[1];
+    const double g = params[2];
+    const double g_m = (g * pow(m, 3.0));
+    const double i = (g_m * (V - E));
+    rates[0] = (-i);
+    rates[1] = ((V > 0.0) ? (alpha * (1.0 - m)) : (-m));
+}
+)JK";
+
+const std::string expected_test_result_13 = R"JK(
+/*
+ * jacobian[i*2+j]: d(rates[i])/d(states[j])
+ */
+void jacobian(const double *states, const double *params, double *jacobian)
+{
+    const double x = states[0];
+    const double y = states[1];
+    const double k = (2.0 * x);
+    const double d_k_d_x = 2.0;
+    const double s0 = (-k);
+    jacobian[0] = (((-d_k_d_x) * (x * y)) + (s0 * y));
+    jacobian[1] = (s0 * x);
+    jacobian[2] = 0.0;
+    jacobian[3] = ((x > 1.0) ? (2.0 * y) : cos(y));
+}
+)JK";
@@ -34,3 +34,9 @@ TEST(SimpleEqn, AeqBplusNumberCellMLOff)
     std::string output = tomathml::process("a = b + 3;", false);
     EXPECT_EQ(expected_test_result_7, output);
 }
+
+TEST(SimpleEqn, AeqPiecewiseCellMLOff)
+{
+    std::string output = tomathml::process("a = sel case b > 1: c; otherwise: d; endsel;", false);
+    EXPECT_EQ(expected_test_result_9, output);
+}
@@ -0,0 +1,233 @@
+#include <gtest/gtest.h>
+
+#include <coroutine>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <stop_token>
+#include <string>
+
+#include "tomathml.h"
+#include "tomathml_async.h"
+#include "tomathml_cache.h"
+
+namespace {
+
+std::string model(int equationCount)
+{
+    std::string res;
+
+    for (int i = 0; i < equationCount; ++i) {
+        res += "ode(x" + std::to_string(i) + ", t) = -k*x" + std::to_string(i) + ";\n";
+    }
+
+    return res;
+}
+
+// Executor that queues its tasks until they are run, one at a time, as an
+// event loop would.
+
+struct EventLoop
+{
+    std::deque<std::function<void()>> tasks;
+    std::size_t taskCount = 0;
+
+    tomathml::Executor executor()
+    {
+        return [this](std::function<void()> task) {
+            tasks.push_back(std::move(task));
+        };
+    }
+
+    bool runOne()
+    {
+        if (tasks.empty()) {
+            return false;
+        }
+
+        auto task = std::move(tasks.front());
+
+        tasks.pop_front();
+        task();
+        ++taskCount;
+
+        return true;
+    }
+
+    void run()
+    {
+        while (runOne()) {
+        }
+    }
+};
+
+// Coroutine that starts straight away and runs until it is done.
+
+struct Task
+{
+    struct promise_type
+    {
+        Task get_return_object()
+        {
+            return {};
+        }
+
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void()
+        {
+        }
+
+        void unhandled_exception()
+        {
+            std::terminate();
+        }
+    };
+};
+
+Task convert(std::string text, tomathml::Options options, tomathml::Executor executor, tomathml::ConvertResult &result)
+{
+    result = co_await tomathml::convertAsync(std::move(text), options, std::move(executor));
+}
+
+}
+
+TEST(Async, Future)
+{
+    auto text = model(1000);
+    auto result = tomathml::convertAsync(text).future().get();
+
+    EXPECT_TRUE(result);
+    EXPECT_EQ(tomathml::process(text), result.output);
+
+    result = tomathml::convertAsync("a = ;").future().get();
+
+    EXPECT_FALSE(result);
+    ASSERT_EQ(1u, result.diagnostics.size());
+    EXPECT_EQ("parser", result.diagnostics.front().source);
+}
+
+TEST(Async, Coroutine)
+{
+    EventLoop loop;
+    tomathml::Options options;
+    tomathml::ConvertResult result;
+    auto text = model(1000);
+
+    options.statementsPerSlice = 100;
+
+    convert(text, options, loop.executor(), result);
+
+    EXPECT_FALSE(result);
+
+    loop.run();
+
+    EXPECT_TRUE(result);
+    EXPECT_EQ(tomathml::process(text), result.output);
+
+    // The conversion ran as one task per slice of statements, and then per
+    // slice of equations, yielding the loop in between.
+
+    EXPECT_EQ(20u, loop.taskCount);
+}
+
+TEST(Async, SlicedSerialization)
+{
+    auto text = model(1000) + "a = b+c;\nd = b+c;\n";
+    tomathml::Options options;
+
+    options.statementsPerSlice = 7;
+
+    for (auto eliminateCommonSubexpressions : { false, true }) {
+        for (auto serializationThreads : { 1U, 4U }) {
+            EventLoop loop;
+            tomathml::ConvertResult result;
+
+            options.eliminateCommonSubexpressions = eliminateCommonSubexpressions;
+            options.serializationThreads = serializationThreads;
+
+            convert(text, options, loop.executor(), result);
+            loop.run();
+
+            EXPECT_TRUE(result);
+            EXPECT_TRUE(tomathml::process(text, true, false, eliminateCommonSubexpressions) == result.output);
+        }
+    }
+
+    // A cached conversion gives the same content MathML as the one that
+    // populated the cache.
+
+    options.eliminateCommonSubexpressions = false;
+    options.cache = std::make_shared<tomathml::ConversionCache>(1 << 24);
+
+    for (int i = 0; i < 2; ++i) {
+        EventLoop loop;
+        tomathml::ConvertResult result;
+
+        convert(text, options, loop.executor(), result);
+        loop.run();
+
+        EXPECT_TRUE(result);
+        EXPECT_TRUE(tomathml::process(text) == result.output);
+    }
+
+    EXPECT_EQ(1u, options.cache->hits());
+}
+
+TEST(Async, Cancellation)
+{
+    EventLoop loop;
+    std::stop_source stopSource;
+    tomathml::Options options;
+
+    options.statementsPerSlice = 10;
+
+    auto future = tomathml::convertAsync(model(1000), options, loop.executor(), stopSource.get_token()).future();
+
+    loop.runOne();
+    loop.runOne();
+    stopSource.request_stop();
+    loop.run();
+
+    auto result = future.get();
+
+    EXPECT_FALSE(result);
+    EXPECT_TRUE(result.output.empty());
+    ASSERT_EQ(1u, result.diagnostics.size());
+    EXPECT_EQ("The conversion was cancelled.", result.diagnostics.front().message);
+    EXPECT_EQ(3u, loop.taskCount);
+}
+
+TEST(Async, CancellationDuringSerialization)
+{
+    EventLoop loop;
+    std::stop_source stopSource;
+    tomathml::Options options;
+
+    options.statementsPerSlice = 100;
+
+    auto future = tomathml::convertAsync(model(1000), options, loop.executor(), stopSource.get_token()).future();
+
+    for (int i = 0; i < 12; ++i) {
+        loop.runOne();
+    }
+
+    stopSource.request_stop();
+    loop.run();
+
+    auto result = future.get();
+
+    EXPECT_FALSE(result);
+    EXPECT_TRUE(result.output.empty());
+    ASSERT_EQ(1u, result.diagnostics.size());
+    EXPECT_EQ("The conversion was cancelled.", result.diagnostics.front().message);
+    EXPECT_EQ(13u, loop.taskCount);
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tomathml.h"
+#include "tomathml_converter.h"
+
+namespace {
+
+// Text strings of very different sizes, with an invalid one in the middle.
+std::vector<std::string> texts()
+{
+    std::vector<std::string> res;
+
+    for (int i = 0; i < 200; ++i) {
+        std::string text;
+        int equationCount = (i % 50 == 0) ? 500 : 1 + i % 3;
+
+        for (int j = 0; j < equationCount; ++j) {
+            text += "a" + std::to_string(j) + " = b*c + " + std::to_string(i) + "{volt};\n";
+        }
+
+        res.push_back(text);
+    }
+
+    res[100] = "a = ;";
+
+    return res;
+}
+
+}
+
+TEST(Batch, InputOrder)
+{
+    auto inputs = texts();
+    std::vector<std::string_view> views(inputs.begin(), inputs.end());
+
+    for (unsigned int threadCount : { 1u, 4u, 16u }) {
+        auto outputs = tomathml::processBatch(views, tomathml::Options { .batchThreads = threadCount });
+
+        ASSERT_EQ(inputs.size(), outputs.size());
+
+        for (std::size_t i = 0; i < inputs.size(); ++i) {
+            EXPECT_EQ(tomathml::process(inputs[i]), outputs[i]);
+        }
+    }
+}
+
+TEST(Batch, ReuseConverter)
+{
+    // A converter reuses its workers across calls, but with its current options.
+
+    std::vector<std::string_view> views = { "a = b + 3;", "ode(x, t) = -x;" };
+    tomathml::Converter converter(tomathml::Options { .batchThreads = 2 });
+
+    auto outputs = converter.convertBatch(views);
+
+    EXPECT_EQ(tomathml::process("a = b + 3;"), outputs[0]);
+
+    converter.setOptions(tomathml::Options { .cellml = false, .batchThreads = 2 });
+
+    outputs = converter.convertBatch(views);
+
+    EXPECT_EQ(tomathml::process("a = b + 3;", false), outputs[0]);
+    EXPECT_EQ(tomathml::process("ode(x, t) = -x;", false), outputs[1]);
+    EXPECT_TRUE(converter.convertBatch({}).empty());
+}
+
+TEST(Batch, PythonApi)
+{
+    auto inputs = texts();
+    auto outputs = tomathml::processBatch(inputs, true, 3);
+
+    ASSERT_EQ(inputs.size(), outputs.size());
+    EXPECT_EQ(tomathml::process(inputs[100]), outputs[100]);
+    EXPECT_EQ(tomathml::process(inputs[150]), outputs[150]);
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "tomathml.h"
+#include "tomathml_binary.h"
+#include "tomathml_converter.h"
+#include "tomathml_events.h"
+
+// Test utilities headers.
+#include "expectedresultstrings.h"
+
+namespace {
+
+const std::string model =
+    "alpha_m = 0.1{per_mV}*(V+25{mV})/(exp((V+25{mV})/10{mV})-1{dimensionless});\n"
+    "beta_m = 4{per_ms}*exp(V/18{mV});\n"
+    "ode(m, t) = alpha_m*(1{dimensionless}-m)-beta_m*m;\n"
+    "x = sel(case V > 0{mV}: exp(V/18{mV}), otherwise: -exp(V/18{mV}));\n"
+    "y = 1.50{dimensionless} + 1.2e-3{dimensionless} + 007{dimensionless};\n";
+
+}
+
+TEST(Binary, RoundTrip)
+{
+    EXPECT_EQ(expected_test_result_1, tomathml::binaryToMathml(tomathml::processToBinary("a = b;")));
+    EXPECT_EQ(expected_test_result_6, tomathml::binaryToMathml(tomathml::processToBinary("a = b - 5{kilogram};")));
+    EXPECT_EQ(expected_test_result_7, tomathml::binaryToMathml(tomathml::processToBinary("a = b + 3;", false, true)));
+    EXPECT_EQ(expected_test_result_8, tomathml::binaryToMathml(tomathml::processToBinary("ode(x, t, 2{dimensionless}) = a - 3{volt};", true, true)));
+}
+
+TEST(Binary, RoundTripModel)
+{
+    EXPECT_EQ(tomathml::process(model), tomathml::binaryToMathml(tomathml::processToBinary(model)));
+
+    const std::string text = "y = 1.50 + 1.2e-3*x - 007/exp(-z);";
+    EXPECT_EQ(tomathml::process(text, false), tomathml::binaryToMathml(tomathml::processToBinary(text, false)));
+}
+
+TEST(Binary, SmallerThanText)
+{
+    auto binary = tomathml::processToBinary(model);
+
+    EXPECT_LT(4 * binary.size(), tomathml::process(model).size());
+}
+
+TEST(Binary, SameEventsAsConvert)
+{
+    class Recorder: public tomathml::EventHandler
+    {
+    public:
+        std::vector<std::string> events;
+
+        void startElement(std::string_view name, std::span<const tomathml::Attribute> attributes) override
+        {
+            std::string event = "start " + std::string(name);
+            for (const auto &attribute : attributes) {
+                event += " " + std::string(attribute.name) + "=" + std::string(attribute.value);
+            }
+            events.push_back(event);
+        }
+
+        void endElement(std::string_view name) override
+        {
+            events.push_back("end " + std::string(name));
+        }
+
+        void text(std::string_view text) override
+        {
+            events.push_back("text " + std::string(text));
+        }
+    };
+
+    tomathml::Converter converter;
+    Recorder expected;
+    Recorder decoded;
+    std::vector<unsigned char> binary;
+
+    EXPECT_TRUE(converter.convert(model, expected));
+    EXPECT_TRUE(converter.convertToBinary(model, binary));
+    EXPECT_TRUE(tomathml::readBinary(binary, decoded));
+    EXPECT_EQ(expected.events, decoded.events);
+}
+
+TEST(Binary, Failure)
+{
+    tomathml::Converter converter;
+    std::vector<unsigned char> binary;
+
+    EXPECT_FALSE(converter.convertToBinary("a = ", binary));
+    EXPECT_TRUE(binary.empty());
+    EXPECT_TRUE(tomathml::processToBinary("a = ").empty());
+}
+
+TEST(Binary, InvalidEncoding)
+{
+    auto binary = tomathml::processToBinary("a = b - 5{kilogram};");
+
+    EXPECT_EQ("", tomathml::binaryToMathml({}));
+    EXPECT_EQ("", tomathml::binaryToMathml({'T', 'M', 'X', 1, 0}));
+    EXPECT_EQ("", tomathml::binaryToMathml(std::vector<unsigned char>(binary.begin(), binary.end() - 1)));
+    EXPECT_EQ("", tomathml::binaryToMathml(std::vector<unsigned char>(binary.begin(), binary.begin() + binary.size() / 2)));
+
+    binary.push_back(0);
+    EXPECT_EQ("", tomathml::binaryToMathml(binary));
+}
+
+TEST(Binary, InvalidVarint)
+{
+    // The reference to the name of the first element is a one-byte varint,
+    // right after the magic number, the version and the record type.
+
+    auto binary = tomathml::processToBinary("a = b;");
+    auto expected = tomathml::binaryToMathml(binary);
+
+    ASSERT_FALSE(expected.empty());
+    ASSERT_LT(binary[5], 0x80);
+
+    // The same value, but encoded over two bytes.
+
+    auto overlong = binary;
+
+    overlong[5] |= 0x80;
+    overlong.insert(overlong.begin() + 6, 0);
+
+    EXPECT_EQ("", tomathml::binaryToMathml(overlong));
+
+    // Values that do not fit in 64 bits.
+
+    std::vector<unsigned char> tooBig(binary.begin(), binary.begin() + 5);
+
+    tooBig.insert(tooBig.end(), 9, 0xff);
+    tooBig.push_back(0x02);
+    tooBig.insert(tooBig.end(), binary.begin() + 6, binary.end());
+
+    EXPECT_EQ("", tomathml::binaryToMathml(tooBig));
+
+    std::vector<unsigned char> tooLong(binary.begin(), binary.begin() + 5);
+
+    tooLong.insert(tooLong.end(), 10, 0x80);
+    tooLong.push_back(0x01);
+    tooLong.insert(tooLong.end(), binary.begin() + 6, binary.end());
+
+    EXPECT_EQ("", tomathml::binaryToMathml(tooLong));
+}
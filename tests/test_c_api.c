@@ -0,0 +1,244 @@
+/*
+ * Test of the C API, which must be usable from plain C.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tomathml_c.h"
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++failures; \
+        } \
+    } while (0)
+
+static const char VALID[] = "a = b+c;";
+static const char INVALID[] = "a = b+;";
+static const char VALID_PREFIX[] = "a = b+c;d = e+;";
+
+struct chunks
+{
+    char *data;
+    size_t length;
+    int count;
+};
+
+static void append(const char *data, size_t length, void *user_data)
+{
+    struct chunks *chunks = (struct chunks *)user_data;
+    char *newData = (char *)realloc(chunks->data, chunks->length + length + 1);
+
+    if (newData == NULL) {
+        return;
+    }
+
+    memcpy(newData + chunks->length, data, length);
+
+    chunks->data = newData;
+    chunks->length += length;
+    chunks->data[chunks->length] = '\0';
+    ++chunks->count;
+}
+
+static void testConvert(void)
+{
+    tomathml_converter *converter = tomathml_converter_new();
+    tomathml_result *result = NULL;
+    const char *output;
+    size_t length = 0;
+
+    CHECK(converter != NULL);
+
+    /* The text needs no null termination. */
+
+    CHECK(tomathml_converter_convert(converter, VALID, strlen(VALID), &result) == TOMATHML_OK);
+    CHECK(result != NULL);
+
+    output = tomathml_result_output(result, &length);
+
+    CHECK(output != NULL);
+    CHECK(length == strlen(output));
+    CHECK(strstr(output, "<eq />") != NULL);
+    CHECK(strstr(output, "<plus />") != NULL);
+    CHECK(tomathml_result_diagnostic_count(result) == 0);
+
+    tomathml_result_free(result);
+
+    tomathml_converter_free(converter);
+}
+
+static void testDiagnostics(void)
+{
+    tomathml_converter *converter = tomathml_converter_new();
+    tomathml_result *result = NULL;
+    tomathml_diagnostic diagnostic;
+    size_t length = 1;
+
+    CHECK(tomathml_converter_convert(converter, INVALID, strlen(INVALID), &result) == TOMATHML_INVALID_TEXT);
+    CHECK(result != NULL);
+    CHECK(tomathml_result_output(result, &length) == NULL);
+    CHECK(length == 0);
+    CHECK(tomathml_result_diagnostic_count(result) == 1);
+    CHECK(tomathml_result_diagnostic(result, 0, &diagnostic) == TOMATHML_OK);
+    CHECK(diagnostic.severity == TOMATHML_SEVERITY_ERROR);
+    CHECK(diagnostic.line == 1);
+    CHECK(diagnostic.column == 7);
+    CHECK((diagnostic.source_length == strlen("parser")) && (memcmp(diagnostic.source, "parser", diagnostic.source_length) == 0));
+    CHECK(diagnostic.message_length > 0);
+    CHECK(tomathml_result_diagnostic(result, 1, &diagnostic) == TOMATHML_INVALID_ARGUMENT);
+
+    tomathml_result_free(result);
+
+    tomathml_converter_free(converter);
+}
+
+static void testBuffer(void)
+{
+    tomathml_converter *converter = tomathml_converter_new();
+    tomathml_result *result = NULL;
+    char small[8] = "unused";
+    char *buffer;
+    size_t length = 0;
+    size_t bufferLength = 0;
+    const char *output;
+
+    tomathml_converter_convert(converter, VALID, strlen(VALID), &result);
+
+    output = tomathml_result_output(result, &length);
+
+    /* A buffer that is too small only gets the start of the output, but we
+       get the length of the output. */
+
+    CHECK(tomathml_converter_convert_to_buffer(converter, VALID, strlen(VALID), small, sizeof(small), &bufferLength, NULL) == TOMATHML_BUFFER_TOO_SMALL);
+    CHECK(bufferLength == length);
+    CHECK(memcmp(small, output, sizeof(small)) == 0);
+
+    buffer = (char *)malloc(bufferLength);
+
+    CHECK(tomathml_converter_convert_to_buffer(converter, VALID, strlen(VALID), buffer, bufferLength, &bufferLength, NULL) == TOMATHML_OK);
+    CHECK((bufferLength == length) && (memcmp(buffer, output, length) == 0));
+
+    /* The text needs no null termination, e.g. a prefix of a longer text. */
+
+    CHECK(tomathml_converter_convert_to_buffer(converter, VALID_PREFIX, strlen(VALID), buffer, bufferLength, &bufferLength, NULL) == TOMATHML_OK);
+    CHECK((bufferLength == length) && (memcmp(buffer, output, length) == 0));
+
+    free(buffer);
+
+    tomathml_result_free(result);
+
+    /* The diagnostics of a failed conversion. */
+
+    CHECK(tomathml_converter_convert_to_buffer(converter, INVALID, strlen(INVALID), small, sizeof(small), &bufferLength, &result) == TOMATHML_INVALID_TEXT);
+    CHECK(bufferLength == 0);
+    CHECK(tomathml_result_output(result, NULL) == NULL);
+    CHECK(tomathml_result_diagnostic_count(result) == 1);
+
+    tomathml_result_free(result);
+
+    tomathml_converter_free(converter);
+}
+
+static void testCallback(void)
+{
+    tomathml_converter *converter = tomathml_converter_new();
+    tomathml_result *result = NULL;
+    struct chunks chunks = { NULL, 0, 0 };
+    size_t length = 0;
+    const char *output;
+
+    tomathml_converter_convert(converter, VALID, strlen(VALID), &result);
+
+    output = tomathml_result_output(result, &length);
+
+    CHECK(tomathml_converter_convert_to_callback(converter, VALID, strlen(VALID), append, &chunks, NULL) == TOMATHML_OK);
+    CHECK(chunks.count > 0);
+    CHECK((chunks.length == length) && (memcmp(chunks.data, output, length) == 0));
+
+    tomathml_result_free(result);
+
+    /* The callback is not called if the conversion fails. */
+
+    chunks.count = 0;
+
+    CHECK(tomathml_converter_convert_to_callback(converter, INVALID, strlen(INVALID), append, &chunks, &result) == TOMATHML_INVALID_TEXT);
+    CHECK(chunks.count == 0);
+    CHECK(tomathml_result_diagnostic_count(result) == 1);
+
+    tomathml_result_free(result);
+
+    free(chunks.data);
+
+    tomathml_converter_free(converter);
+}
+
+static void testOptions(void)
+{
+    tomathml_converter *converter = tomathml_converter_new();
+    tomathml_result *result = NULL;
+    const char text[] = "a = 3{dimensionless};";
+
+    CHECK(tomathml_converter_set_option(converter, TOMATHML_OPTION_CELLML, 0) == TOMATHML_OK);
+    CHECK(tomathml_converter_convert(converter, text, strlen(text), &result) == TOMATHML_INVALID_TEXT);
+
+    tomathml_result_free(result);
+
+    CHECK(tomathml_converter_set_option(converter, TOMATHML_OPTION_CELLML, 1) == TOMATHML_OK);
+    CHECK(tomathml_converter_convert(converter, text, strlen(text), &result) == TOMATHML_OK);
+    CHECK(strstr(tomathml_result_output(result, NULL), "cellml:units=\"dimensionless\"") != NULL);
+
+    tomathml_result_free(result);
+
+    CHECK(tomathml_converter_set_option(converter, (tomathml_option)42, 1) == TOMATHML_INVALID_ARGUMENT);
+
+    tomathml_converter_free(converter);
+}
+
+static void testInvalidArguments(void)
+{
+    tomathml_converter *converter = tomathml_converter_new();
+    tomathml_result *result = NULL;
+    size_t length;
+
+    CHECK(tomathml_converter_set_option(NULL, TOMATHML_OPTION_CELLML, 1) == TOMATHML_INVALID_ARGUMENT);
+    CHECK(tomathml_converter_convert(NULL, VALID, strlen(VALID), &result) == TOMATHML_INVALID_ARGUMENT);
+    CHECK(tomathml_converter_convert(converter, NULL, 1, &result) == TOMATHML_INVALID_ARGUMENT);
+    CHECK(tomathml_converter_convert(converter, VALID, strlen(VALID), NULL) == TOMATHML_INVALID_ARGUMENT);
+    CHECK(tomathml_converter_convert_to_buffer(converter, VALID, strlen(VALID), NULL, 1, &length, NULL) == TOMATHML_INVALID_ARGUMENT);
+    CHECK(tomathml_converter_convert_to_callback(converter, VALID, strlen(VALID), NULL, NULL, NULL) == TOMATHML_INVALID_ARGUMENT);
+    CHECK(tomathml_result_output(NULL, &length) == NULL);
+    CHECK(tomathml_result_diagnostic_count(NULL) == 0);
+
+    /* Freeing null is fine. */
+
+    tomathml_result_free(NULL);
+    tomathml_converter_free(NULL);
+
+    tomathml_converter_free(converter);
+}
+
+int main(void)
+{
+    testConvert();
+    testDiagnostics();
+    testBuffer();
+    testCallback();
+    testOptions();
+    testInvalidArguments();
+
+    if (failures != 0) {
+        fprintf(stderr, "%d check(s) failed.\n", failures);
+
+        return EXIT_FAILURE;
+    }
+
+    printf("All checks passed.\n");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,210 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "tomathml.h"
+#include "tomathml_cache.h"
+#include "tomathml_converter.h"
+#include "tomathml_result.h"
+
+TEST(Cache, HitsAndMisses)
+{
+    tomathml::Options options;
+
+    options.cache = std::make_shared<tomathml::ConversionCache>(1 << 20);
+
+    tomathml::Converter converter(options);
+    std::string text = "a = b + 2{volt};";
+    auto expected = tomathml::process(text);
+
+    EXPECT_EQ(expected, converter.convert(text));
+    EXPECT_EQ(0u, options.cache->hits());
+    EXPECT_EQ(1u, options.cache->misses());
+    EXPECT_EQ(1u, options.cache->entryCount());
+    EXPECT_LT(expected.size(), options.cache->size());
+
+    EXPECT_EQ(expected, converter.convert(text));
+    EXPECT_TRUE(converter.messages().empty());
+    EXPECT_EQ(1u, options.cache->hits());
+
+    tomathml::ConvertResult result;
+
+    EXPECT_TRUE(converter.convert(text, result));
+    EXPECT_EQ(expected, result.output);
+    EXPECT_TRUE(result.diagnostics.empty());
+    EXPECT_EQ(2u, options.cache->hits());
+
+    options.cache->clear();
+
+    EXPECT_EQ(0u, options.cache->entryCount());
+    EXPECT_EQ(0u, options.cache->size());
+    EXPECT_EQ(0u, options.cache->hits());
+    EXPECT_EQ(0u, options.cache->misses());
+}
+
+TEST(Cache, Options)
+{
+    auto cache = std::make_shared<tomathml::ConversionCache>(1 << 20);
+    tomathml::Options options;
+
+    options.cache = cache;
+
+    std::string text = "a = b + 2{volt};";
+    tomathml::Converter converter(options);
+
+    converter.convert(text);
+
+    // Different options give different content MathML, so they must not hit.
+
+    options.hoistNamespaces = true;
+    converter.setOptions(options);
+
+    EXPECT_EQ(tomathml::process(text, true, true), converter.convert(text));
+    EXPECT_EQ(0u, cache->hits());
+    EXPECT_EQ(2u, cache->entryCount());
+}
+
+TEST(Cache, Failures)
+{
+    tomathml::Options options;
+
+    options.cache = std::make_shared<tomathml::ConversionCache>(1 << 20);
+
+    tomathml::Converter converter(options);
+
+    EXPECT_EQ(tomathml::process("a = ;"), converter.convert("a = ;"));
+    EXPECT_EQ(tomathml::process("a = ;"), converter.convert("a = ;"));
+    EXPECT_EQ(0u, options.cache->hits());
+    EXPECT_EQ(0u, options.cache->entryCount());
+
+    // Warnings are not cached either, so that they are reported every time.
+
+    options.checkUnits = true;
+    converter.setOptions(options);
+
+    tomathml::ConvertResult result;
+
+    EXPECT_TRUE(converter.convert("a = 1{volt} + 2{second};", result));
+    EXPECT_EQ(1u, result.diagnostics.size());
+    EXPECT_EQ(0u, options.cache->entryCount());
+}
+
+TEST(Cache, Eviction)
+{
+    auto output = tomathml::process("a0 = b;");
+    tomathml::Options options;
+
+    // Room for about four entries in a single shard.
+
+    options.cache = std::make_shared<tomathml::ConversionCache>(4 * (output.size() + 128) + 64, 1);
+
+    tomathml::Converter converter(options);
+
+    for (int i = 0; i < 10; ++i) {
+        converter.convert("a" + std::to_string(i) + " = b;");
+    }
+
+    EXPECT_EQ(4u, options.cache->entryCount());
+    EXPECT_LE(options.cache->size(), options.cache->capacity());
+
+    // The most recently used entries are kept.
+
+    converter.convert("a9 = b;");
+    converter.convert("a0 = b;");
+
+    EXPECT_EQ(1u, options.cache->hits());
+}
+
+TEST(Cache, LargeEntries)
+{
+    // The shards share the capacity of the cache, so content MathML that is
+    // much bigger than a sixteenth of it still gets cached.
+
+    std::string text;
+
+    for (int i = 0; i < 300; ++i) {
+        auto n = std::to_string(i);
+
+        text += "ode(x" + n + ", t) = -k" + n + "*x" + n + ";\n";
+    }
+
+    tomathml::Options options;
+
+    options.cache = std::make_shared<tomathml::ConversionCache>(1 << 20);
+
+    tomathml::Converter converter(options);
+    auto expected = tomathml::process(text);
+
+    EXPECT_GT(expected.size(), options.cache->capacity() / 16);
+
+    EXPECT_TRUE(expected == converter.convert(text));
+    EXPECT_TRUE(expected == converter.convert(text));
+    EXPECT_EQ(1u, options.cache->hits());
+
+    // Caching a few of them evicts the least recently used ones, whichever
+    // their shard.
+
+    for (int i = 0; i < 20; ++i) {
+        converter.convert(text + "a = " + std::to_string(i) + "{dimensionless};");
+
+        EXPECT_LE(options.cache->size(), options.cache->capacity());
+    }
+
+    EXPECT_LT(options.cache->entryCount(), 21u);
+    text += "a = 19{dimensionless};";
+
+    EXPECT_TRUE(tomathml::process(text) == converter.convert(text));
+    EXPECT_EQ(2u, options.cache->hits());
+}
+
+TEST(Cache, Concurrency)
+{
+    auto cache = std::make_shared<tomathml::ConversionCache>(1 << 16, 8);
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([cache, i] {
+            tomathml::Options options;
+
+            options.cache = cache;
+
+            tomathml::Converter converter(options);
+
+            for (int j = 0; j < 500; ++j) {
+                auto text = "a" + std::to_string((i * 7 + j) % 100) + " = b*c;";
+
+                ASSERT_EQ(tomathml::process(text), converter.convert(text));
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(4000u, cache->hits() + cache->misses());
+    EXPECT_GT(cache->hits(), 0u);
+    EXPECT_LE(cache->size(), cache->capacity());
+}
+
+TEST(Cache, Batch)
+{
+    tomathml::Options options;
+
+    options.cache = std::make_shared<tomathml::ConversionCache>(1 << 20);
+    options.batchThreads = 4;
+
+    std::vector<std::string_view> texts(100, "a = b;");
+    auto outputs = tomathml::processBatch(texts, options);
+
+    for (const auto &output : outputs) {
+        EXPECT_EQ(tomathml::process("a = b;"), output);
+    }
+
+    EXPECT_EQ(1u, options.cache->entryCount());
+    EXPECT_EQ(100u, options.cache->hits() + options.cache->misses());
+}
@@ -0,0 +1,261 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "tomathml.h"
+#include "tomathml_converter.h"
+#include "tomathml_evaluator.h"
+
+// Test utilities headers.
+#include "expectedresultstrings.h"
+
+namespace {
+
+#if defined(TOMATHML_TEST_C_COMPILER) && !defined(_WIN32)
+// A uniquely named temporary directory, removed along with its content once
+// done with, so that concurrent test runs cannot use the same directory.
+class TemporaryDirectory
+{
+public:
+    TemporaryDirectory()
+    {
+        auto pattern = (std::filesystem::temp_directory_path() / "tomathml_XXXXXX").string();
+
+        if (mkdtemp(pattern.data()) != nullptr) {
+            mPath = pattern;
+        }
+    }
+
+    ~TemporaryDirectory()
+    {
+        if (!mPath.empty()) {
+            std::filesystem::remove_all(mPath);
+        }
+    }
+
+    TemporaryDirectory(const TemporaryDirectory&) = delete;
+    TemporaryDirectory& operator=(const TemporaryDirectory&) = delete;
+
+    std::filesystem::path operator/(const std::string& name) const
+    {
+        return mPath / name;
+    }
+
+    bool valid() const
+    {
+        return !mPath.empty();
+    }
+
+private:
+    std::filesystem::path mPath;
+};
+
+// Whether the given code compiles.
+bool compiles(const std::string& code)
+{
+    TemporaryDirectory directory;
+
+    if (!directory.valid()) {
+        return false;
+    }
+
+    std::ofstream(directory / "code.c") << code;
+
+    auto command = std::string(TOMATHML_TEST_C_COMPILER) + " -c -o \"" + (directory / "code.o").string() + "\" \"" + (directory / "code.c").string() + "\"";
+
+    return std::system(command.c_str()) == 0;
+}
+#endif
+
+}
+
+TEST(CodeGeneration, Rhs)
+{
+    // The algebraic equations are out of order, on purpose.
+
+    std::string output = tomathml::processToC("ode(V, t) = -i;\n"
+                                              "i = g_m*(V-E);\n"
+                                              "ode(m, t) = sel(case V > 0: alpha*(1-m), otherwise: -m);\n"
+                                              "g_m = g*pow(m, 3);\n",
+                                              false);
+    EXPECT_EQ(expected_test_result_12, output);
+}
+
+TEST(CodeGeneration, ReservedNames)
+{
+    std::string output = tomathml::processToC("ode(double, t) = -rates;", false);
+    EXPECT_NE(std::string::npos, output.find("const double double_ = states[0];\n"));
+    EXPECT_NE(std::string::npos, output.find("const double rates_ = params[0];\n"));
+    EXPECT_NE(std::string::npos, output.find("rates[0] = (-rates_);\n"));
+
+    output = tomathml::processToC("ode(x, t) = -M_PI*HUGE_VAL*FP_NAN*math_errhandling*_Bool*__x*x;\n"
+                                  "bool = true+false+nullptr+constexpr+typeof+alignof+thread_local;\n",
+                                  false);
+    EXPECT_NE(std::string::npos, output.find("const double v_M_PI = params[0];\n"));
+    EXPECT_NE(std::string::npos, output.find("const double v__Bool = params[4];\n"));
+    EXPECT_NE(std::string::npos, output.find("const double bool_ = "));
+
+#if defined(TOMATHML_TEST_C_COMPILER) && !defined(_WIN32)
+    EXPECT_TRUE(compiles(output));
+#endif
+
+    output = tomathml::processToC("ode(x, t) = -jacobian*x;", false, true);
+    EXPECT_NE(std::string::npos, output.find("const double jacobian_ = params[0];\n"));
+
+#if defined(TOMATHML_TEST_C_COMPILER) && !defined(_WIN32)
+    EXPECT_TRUE(compiles(output));
+#endif
+}
+
+TEST(CodeGeneration, Jacobian)
+{
+    std::string output = tomathml::processToC("ode(x, t) = -k*x*y;\n"
+                                              "ode(y, t) = sel(case x > 1: pow(y, 2), otherwise: sin(y));\n"
+                                              "k = 2*x;\n",
+                                              false, true);
+    auto jacobian = output.find("\n/*\n * jacobian");
+
+    ASSERT_NE(std::string::npos, jacobian);
+    EXPECT_EQ(expected_test_result_13, output.substr(jacobian));
+}
+
+TEST(CodeGeneration, Failure)
+{
+    tomathml::Converter converter;
+    std::string code;
+
+    EXPECT_FALSE(converter.convertToC("a = b;\nb = a + 1{dimensionless};\n", code));
+    EXPECT_TRUE(code.empty());
+    EXPECT_EQ("Messages from code generator (1)\n'a' is part of a cycle of algebraic equations.\n", converter.messages());
+
+    EXPECT_EQ("Messages from code generator (1)\nThe ODE of 'x' is not of first order.\n", tomathml::processToC("ode(x, t, 2) = x;", false));
+    EXPECT_EQ("Messages from code generator (1)\n'x' has more than one ODE.\n", tomathml::processToC("ode(x, t) = x;\node(x, t) = 1;\n", false));
+    EXPECT_EQ("Messages from code generator (1)\n'factorial' cannot be differentiated.\n", tomathml::processToC("ode(x, t) = fact(x);", false, true));
+}
+
+TEST(CodeGeneration, CompileAndRun)
+{
+#if !defined(TOMATHML_TEST_C_COMPILER) || defined(_WIN32)
+    GTEST_SKIP() << "No C compiler available.";
+#else
+    const std::string text =
+        "k = a/b + log(a, 2) + root(b, 3) + sqrt(b) + sec(a) + acoth(b) + rem(b, a);\n"
+        "ode(x, t) = -k*x + sel(case t > 1: gcd(12, 18), case t > 0.5: lcm(4, 6), otherwise: fact(3));\n"
+        "ode(y, t) = min(x, y, 1) - max(x, y) + abs(sinh(y)) + ceil(y) + floor(y) + exp(-y) + ln(b) + pi;\n";
+
+    // Generate our code and a program calling it, and print the rates.
+
+    TemporaryDirectory directory;
+
+    ASSERT_TRUE(directory.valid());
+
+    std::ofstream(directory / "main.c") << tomathml::processToC(text, false)
+                                         << "\n#include <stdio.h>\n\n"
+                                            "int main(void)\n"
+                                            "{\n"
+                                            "    const double states[] = { 0.75, -1.25 };\n"
+                                            "    const double params[] = { 2.5, 1.5, 0.7 };\n"
+                                            "    double rates[2];\n"
+                                            "    rhs(states, params, rates);\n"
+                                            "    printf(\"%.17g %.17g\\n\", rates[0], rates[1]);\n"
+                                            "    return 0;\n"
+                                            "}\n";
+
+    auto program = directory / "main";
+    auto command = std::string(TOMATHML_TEST_C_COMPILER) + " -o \"" + program.string() + "\" \"" + (directory / "main.c").string() + "\" -lm";
+
+    ASSERT_EQ(0, std::system(command.c_str()));
+
+    auto pipe = popen(program.string().c_str(), "r");
+    ASSERT_NE(nullptr, pipe);
+
+    double xRate = 0.0;
+    double yRate = 0.0;
+    EXPECT_EQ(2, std::fscanf(pipe, "%lf %lf", &xRate, &yRate));
+    pclose(pipe);
+
+    // Check the rates against those computed by our evaluator.
+
+    tomathml::Evaluator evaluator;
+    ASSERT_TRUE(evaluator.compile(text, false));
+    ASSERT_EQ(std::vector<std::string>({ "a", "b", "x", "t", "y" }), evaluator.inputs());
+
+    const double x = 0.75;
+    const double t = 0.7;
+    const double a = 2.5;
+    const double b = 1.5;
+    const double y = -1.25;
+    const double *inputs[] = { &a, &b, &x, &t, &y };
+    double rates[3];
+    double *outputs[] = { &rates[0], &rates[1], &rates[2] };
+
+    ASSERT_TRUE(evaluator.evaluate(inputs, outputs, 1));
+    EXPECT_DOUBLE_EQ(rates[1], xRate);
+    EXPECT_DOUBLE_EQ(rates[2], yRate);
+#endif
+}
+
+TEST(CodeGeneration, CompileAndRunJacobian)
+{
+#if !defined(TOMATHML_TEST_C_COMPILER) || defined(_WIN32)
+    GTEST_SKIP() << "No C compiler available.";
+#else
+    // Check the Jacobian against central differences of the rates.
+
+    const std::string text =
+        "ode(x, t) = -k*x + pow(y, x) + root(x, 3) + log(y, 2) + sel(case x > 1: sec(y), case y > 0: abs(x - y), otherwise: x*y);\n"
+        "k = a/(1 + x*x) + sqrt(y) + min(x, y, 2) + rem(y, x) + tanh(x) + acoth(y) + asec(y) + asinh(x/y);\n"
+        "ode(y, t) = exp(-y)*ln(x) - atan(k) + acos(x/4) + csch(y) + cot(x)*sqr(y);\n"
+        "ode(z, t) = z*x - b;\n";
+
+    TemporaryDirectory directory;
+
+    ASSERT_TRUE(directory.valid());
+
+    std::ofstream(directory / "main.c") << tomathml::processToC(text, false, true)
+                                         << "\n#include <stdio.h>\n\n"
+                                            "int main(void)\n"
+                                            "{\n"
+                                            "    const double states[] = { 1.5, 2.25, -0.5 };\n"
+                                            "    const double params[] = { 0.7, 3.0 };\n"
+                                            "    double jac[9];\n"
+                                            "    double maxError = 0.0;\n"
+                                            "    jacobian(states, params, jac);\n"
+                                            "    for (int j = 0; j < 3; ++j) {\n"
+                                            "        double h = 1e-6;\n"
+                                            "        double plus[3] = { states[0], states[1], states[2] };\n"
+                                            "        double minus[3] = { states[0], states[1], states[2] };\n"
+                                            "        double ratesPlus[3], ratesMinus[3];\n"
+                                            "        plus[j] += h;\n"
+                                            "        minus[j] -= h;\n"
+                                            "        rhs(plus, params, ratesPlus);\n"
+                                            "        rhs(minus, params, ratesMinus);\n"
+                                            "        for (int i = 0; i < 3; ++i) {\n"
+                                            "            double error = fabs((ratesPlus[i] - ratesMinus[i]) / (2.0 * h) - jac[3 * i + j]) / (1.0 + fabs(jac[3 * i + j]));\n"
+                                            "            maxError = (error > maxError) ? error : maxError;\n"
+                                            "        }\n"
+                                            "    }\n"
+                                            "    printf(\"%.17g\\n\", maxError);\n"
+                                            "    return 0;\n"
+                                            "}\n";
+
+    auto program = directory / "main";
+    auto command = std::string(TOMATHML_TEST_C_COMPILER) + " -o \"" + program.string() + "\" \"" + (directory / "main.c").string() + "\" -lm";
+
+    ASSERT_EQ(0, std::system(command.c_str()));
+
+    auto pipe = popen(program.string().c_str(), "r");
+    ASSERT_NE(nullptr, pipe);
+
+    double maxError = 1.0;
+    EXPECT_EQ(1, std::fscanf(pipe, "%lf", &maxError));
+    pclose(pipe);
+
+    EXPECT_LT(maxError, 1e-6);
+#endif
+}
@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tomathml.h"
+#include "tomathml_cache.h"
+#include "tomathml_converter.h"
+
+namespace {
+
+// A model that goes through most of the parser, i.e. units, derivatives,
+// mathematical constants and functions, and piecewise expressions.
+std::string model(int equationCount)
+{
+    std::string res;
+
+    for (int i = 0; i < equationCount; ++i) {
+        auto n = std::to_string(i);
+
+        res += "ode(x" + n + ", t) = -k*x" + n + " + sin(2{dimensionless}*pi*t) + log(x" + n + ", 3{dimensionless});\n";
+        res += "y" + n + " = sel(case x" + n + " > 0{volt}: root(x" + n + ", 3{dimensionless}), otherwise: min(x" + n + ", 1{volt}, -1{volt}));\n";
+    }
+
+    return res;
+}
+
+// Run the given function from the given number of threads, all starting at
+// the same time.
+template<typename Function>
+void runConcurrently(unsigned int threadCount, Function function)
+{
+    std::atomic<bool> go = false;
+    std::vector<std::thread> threads;
+
+    for (unsigned int i = 0; i < threadCount; ++i) {
+        threads.emplace_back([&go, &function, i] {
+            while (!go) {
+                std::this_thread::yield();
+            }
+
+            function(i);
+        });
+    }
+
+    go = true;
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+unsigned int maximumThreadCount()
+{
+    return std::clamp(std::thread::hardware_concurrency(), 2U, 16U);
+}
+
+}
+
+TEST(Concurrency, FirstUse)
+{
+    // Each test runs in its own process, so this is the first use of the
+    // library, i.e. the parser initialises its static tokens while several
+    // threads use it.
+
+    auto text = model(5);
+    std::vector<std::string> outputs(maximumThreadCount());
+
+    runConcurrently(maximumThreadCount(), [&](unsigned int i) {
+        outputs[i] = tomathml::process(text, i % 2 == 0);
+    });
+
+    for (std::size_t i = 0; i < outputs.size(); ++i) {
+        EXPECT_EQ(tomathml::process(text, i % 2 == 0), outputs[i]);
+    }
+}
+
+TEST(Concurrency, Stress)
+{
+    // Many threads converting at once, each with its own converter, and all of
+    // them sharing a cache.
+
+    auto text = model(20);
+    auto expected = tomathml::process(text);
+    tomathml::Options options;
+
+    options.cache = std::make_shared<tomathml::ConversionCache>(1 << 20);
+
+    std::atomic<int> failures = 0;
+
+    runConcurrently(maximumThreadCount(), [&](unsigned int i) {
+        tomathml::Converter converter(options);
+
+        for (int j = 0; j < 20; ++j) {
+            auto variant = text + "z = " + std::to_string((i + j) % 4) + "{volt};\n";
+
+            if (converter.convert(variant).find("<apply>") == std::string::npos) {
+                ++failures;
+            }
+
+            if (tomathml::process(text) != expected) {
+                ++failures;
+            }
+        }
+    });
+
+    EXPECT_EQ(0, failures);
+    EXPECT_GT(options.cache->hits(), 0U);
+}
+
+TEST(Concurrency, Scaling)
+{
+    // Report the throughput of independent conversions from 1 to N threads.
+    // Nothing is shared between the threads, so the throughput should scale
+    // with the number of cores.
+
+    using Clock = std::chrono::steady_clock;
+
+    const auto text = model(200);
+    const int conversionsPerThread = 4;
+    double baseline = 0.0;
+
+    for (unsigned int threadCount = 1; threadCount <= maximumThreadCount(); threadCount *= 2) {
+        auto start = Clock::now();
+
+        runConcurrently(threadCount, [&](unsigned int) {
+            tomathml::Converter converter;
+            std::string output;
+
+            for (int i = 0; i < conversionsPerThread; ++i) {
+                EXPECT_TRUE(converter.convert(text, output));
+            }
+        });
+
+        auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        auto throughput = threadCount * conversionsPerThread / elapsed;
+
+        if (threadCount == 1) {
+            baseline = throughput;
+        }
+
+        std::cout << threadCount << " thread(s): " << throughput << " conversions/s, speedup: " << throughput / baseline << "\n";
+    }
+}
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <memory_resource>
+
+#include "tomathml.h"
+#include "tomathml_converter.h"
+
+// Test utilities headers.
+#include "expectedresultstrings.h"
+
+namespace {
+
+// Memory resource that counts the allocations made from it.
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+    std::size_t allocationCount = 0;
+
+private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        ++allocationCount;
+
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override
+    {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+}
+
+TEST(Namespaces, HoistedOnMath)
+{
+    std::string output = tomathml::process("ode(x, t, 2{dimensionless}) = a - 3{volt};", true, true);
+    EXPECT_EQ(expected_test_result_8, output);
+}
+
+TEST(Namespaces, HoistedCellMLOff)
+{
+    std::string output = tomathml::process("a = b + 3;", false, true);
+    EXPECT_EQ(expected_test_result_7, output);
+}
+
+TEST(Namespaces, HoistedWithoutNumbers)
+{
+    std::string output = tomathml::process("a = b;", true, true);
+    EXPECT_EQ(expected_test_result_1, output);
+}
+
+TEST(Converter, ReuseAcrossConversions)
+{
+    tomathml::Converter converter;
+
+    EXPECT_EQ(expected_test_result_6, converter.convert("a = b - 5{kilogram};"));
+    EXPECT_EQ(expected_test_result_1, converter.convert("a = b;"));
+
+    tomathml::Options options;
+    options.hoistNamespaces = true;
+    converter.setOptions(options);
+
+    EXPECT_EQ(expected_test_result_8, converter.convert("ode(x, t, 2{dimensionless}) = a - 3{volt};"));
+}
+
+TEST(Converter, SwitchBetweenModes)
+{
+    // Each mode has its own parsing code, so switching between them must
+    // give the same output as using a fresh converter.
+
+    tomathml::Converter converter;
+    tomathml::Options options;
+
+    options.hoistNamespaces = true;
+
+    for (auto cellml : { false, true, false }) {
+        options.cellml = cellml;
+        converter.setOptions(options);
+
+        EXPECT_EQ(cellml ? expected_test_result_8 : expected_test_result_7,
+                  converter.convert(cellml ? "ode(x, t, 2{dimensionless}) = a - 3{volt};" : "a = b + 3;"));
+
+        std::string output;
+
+        EXPECT_NE(converter.convert("a = b + 3;", output), cellml);
+    }
+}
+
+TEST(SharedSubexpressions, OutputUnchanged)
+{
+    const std::string text =
+        "alpha_m = 0.1{per_mV}*(V+25{mV})/(exp((V+25{mV})/10{mV})-1{dimensionless});\n"
+        "beta_m = 4{per_ms}*exp(V/18{mV});\n"
+        "alpha_h = 0.07{per_ms}*exp(V/20{mV});\n"
+        "beta_h = 1{per_ms}/(exp((V+30{mV})/10{mV})+1{dimensionless});\n"
+        "ode(m, t) = alpha_m*(1{dimensionless}-m)-beta_m*m;\n"
+        "ode(h, t) = alpha_h*(1{dimensionless}-h)-beta_h*h;\n"
+        "x = sel(case V > 0{mV}: exp(V/18{mV}), otherwise: -exp(V/18{mV}));\n"
+        "y = log(a, 2{dimensionless}) + log(a, 2{dimensionless}) - a - b - c;\n";
+
+    // Sharing subexpressions means fewer DOM nodes, and since identical DOM
+    // nodes are looked for before being created, fewer allocations too.
+
+    for (auto hoistNamespaces : { false, true }) {
+        CountingResource unsharedResource;
+        CountingResource sharedResource;
+        tomathml::Options options;
+
+        options.hoistNamespaces = hoistNamespaces;
+        options.memoryResource = &unsharedResource;
+
+        tomathml::Converter converter(options);
+        std::string expected = converter.convert(text);
+
+        options.shareSubexpressions = true;
+        options.memoryResource = &sharedResource;
+        converter.setOptions(options);
+
+        EXPECT_EQ(expected, converter.convert(text));
+        EXPECT_LT(sharedResource.allocationCount, unsharedResource.allocationCount);
+    }
+}
+
+TEST(ParallelSerialization, OutputUnchanged)
+{
+    std::string text = "// Generated equations.\n";
+    for (int i = 0; i < 100; ++i) {
+        auto n = std::to_string(i);
+        text += "ode(x" + n + ", t) = -k" + n + "*x" + n + " + " + n + "{per_second};\n";
+        if (i % 7 == 0) {
+            text += "// Block " + n + ".\n";
+        }
+    }
+
+    tomathml::Options options;
+    tomathml::Converter converter(options);
+    std::string expected = converter.convert(text);
+
+    for (unsigned int threads : { 2u, 3u, 8u, 0u }) {
+        options.serializationThreads = threads;
+        converter.setOptions(options);
+
+        EXPECT_EQ(expected, converter.convert(text));
+    }
+
+    options.serializationThreads = 4;
+    converter.setOptions(options);
+
+    EXPECT_EQ(expected_test_result_1, converter.convert("a = b;"));
+}
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "tomathml.h"
+#include "tomathml_converter.h"
+
+namespace {
+
+std::string json(const std::string &text, unsigned int minimumSubexpressionCost = 2)
+{
+    tomathml::Converter converter(tomathml::Options { .cellml = false, .eliminateCommonSubexpressions = true, .minimumSubexpressionCost = minimumSubexpressionCost });
+    std::string res;
+
+    EXPECT_TRUE(converter.convertToJson(text, res));
+
+    return res;
+}
+
+}
+
+TEST(Cse, Eliminate)
+{
+    EXPECT_EQ("{\"op\":\"eq\",\"args\":[{\"ci\":\"tmp_1\"},{\"op\":\"exp\",\"args\":[{\"op\":\"divide\",\"args\":[{\"ci\":\"x\"},{\"ci\":\"y\"}]}]}]}\n"
+              "{\"op\":\"eq\",\"args\":[{\"ci\":\"a\"},{\"op\":\"plus\",\"args\":[{\"ci\":\"tmp_1\"},{\"ci\":\"z\"}]}]}\n"
+              "{\"op\":\"eq\",\"args\":[{\"ci\":\"b\"},{\"op\":\"minus\",\"args\":[{\"ci\":\"tmp_1\"},{\"cn\":\"1\"}]}]}\n",
+              json("a = exp(x/y) + z;\nb = exp(x/y) - 1;\n"));
+}
+
+TEST(Cse, MinimumCost)
+{
+    // x*y costs a single operation, so it is only eliminated with a minimum
+    // cost of 1, in which case it is computed before the exp() that uses it.
+
+    std::string text = "a = exp(x*y);\nb = exp(x*y) + x*y;\n";
+
+    EXPECT_EQ("{\"op\":\"eq\",\"args\":[{\"ci\":\"tmp_1\"},{\"op\":\"exp\",\"args\":[{\"op\":\"times\",\"args\":[{\"ci\":\"x\"},{\"ci\":\"y\"}]}]}]}\n"
+              "{\"op\":\"eq\",\"args\":[{\"ci\":\"a\"},{\"ci\":\"tmp_1\"}]}\n"
+              "{\"op\":\"eq\",\"args\":[{\"ci\":\"b\"},{\"op\":\"plus\",\"args\":[{\"ci\":\"tmp_1\"},{\"op\":\"times\",\"args\":[{\"ci\":\"x\"},{\"ci\":\"y\"}]}]}]}\n",
+              json(text));
+    EXPECT_EQ("{\"op\":\"eq\",\"args\":[{\"ci\":\"tmp_1\"},{\"op\":\"times\",\"args\":[{\"ci\":\"x\"},{\"ci\":\"y\"}]}]}\n"
+              "{\"op\":\"eq\",\"args\":[{\"ci\":\"tmp_2\"},{\"op\":\"exp\",\"args\":[{\"ci\":\"tmp_1\"}]}]}\n"
+              "{\"op\":\"eq\",\"args\":[{\"ci\":\"a\"},{\"ci\":\"tmp_2\"}]}\n"
+              "{\"op\":\"eq\",\"args\":[{\"ci\":\"b\"},{\"op\":\"plus\",\"args\":[{\"ci\":\"tmp_2\"},{\"ci\":\"tmp_1\"}]}]}\n",
+              json(text, 1));
+}
+
+TEST(Cse, NameCollisions)
+{
+    EXPECT_EQ("{\"op\":\"eq\",\"args\":[{\"ci\":\"tmp_3\"},{\"op\":\"plus\",\"args\":[{\"op\":\"times\",\"args\":[{\"ci\":\"x\"},{\"ci\":\"tmp_2\"}]},{\"cn\":\"1\"}]}]}\n"
+              "{\"op\":\"eq\",\"args\":[{\"ci\":\"tmp_1\"},{\"ci\":\"tmp_3\"}]}\n"
+              "{\"op\":\"eq\",\"args\":[{\"ci\":\"a\"},{\"ci\":\"tmp_3\"}]}\n",
+              json("tmp_1 = x*tmp_2 + 1;\na = x*tmp_2 + 1;\n"));
+}
+
+TEST(Cse, OdesAndComments)
+{
+    // The derivatives of ODEs are left alone, and comments stay where they are.
+
+    std::string text = "// Gates.\node(m, t) = exp(V/10)*(1-m);\node(h, t) = exp(V/10)*h;\n";
+
+    EXPECT_EQ("{\"comment\":\" Gates.\"}\n"
+              "{\"op\":\"eq\",\"args\":[{\"ci\":\"tmp_1\"},{\"op\":\"exp\",\"args\":[{\"op\":\"divide\",\"args\":[{\"ci\":\"V\"},{\"cn\":\"10\"}]}]}]}\n"
+              "{\"op\":\"eq\",\"args\":[{\"op\":\"diff\",\"bvar\":{\"ci\":\"t\"},\"args\":[{\"ci\":\"m\"}]},{\"op\":\"times\",\"args\":[{\"ci\":\"tmp_1\"},{\"op\":\"minus\",\"args\":[{\"cn\":\"1\"},{\"ci\":\"m\"}]}]}]}\n"
+              "{\"op\":\"eq\",\"args\":[{\"op\":\"diff\",\"bvar\":{\"ci\":\"t\"},\"args\":[{\"ci\":\"h\"}]},{\"op\":\"times\",\"args\":[{\"ci\":\"tmp_1\"},{\"ci\":\"h\"}]}]}\n",
+              json(text));
+}
+
+TEST(Cse, Process)
+{
+    std::string text = "a = b + 3{dimensionless};\n";
+
+    EXPECT_EQ(tomathml::process(text), tomathml::process(text, true, false, true));
+    EXPECT_NE(std::string::npos, tomathml::process("a = exp(b*c);\nd = exp(b*c);\n", true, false, true).find("tmp_1"));
+}
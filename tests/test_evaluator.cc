@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <numbers>
+#include <string>
+#include <vector>
+
+#include "tomathml.h"
+#include "tomathml_evaluator.h"
+
+TEST(Evaluator, InputsAndOutputs)
+{
+    tomathml::Evaluator evaluator;
+
+    EXPECT_TRUE(evaluator.compile("a = b + c*2{dimensionless};\node(x, t) = -a*x;\n"));
+    EXPECT_EQ(std::vector<std::string>({ "b", "c", "x" }), evaluator.inputs());
+    EXPECT_EQ(std::vector<std::string>({ "a", "ode(x, t)" }), evaluator.outputs());
+    EXPECT_EQ("", evaluator.messages());
+}
+
+TEST(Evaluator, Batch)
+{
+    // More parameter sets than fit in one block, with a partial last block.
+
+    const std::size_t count = 21;
+    std::vector<double> b(count);
+    std::vector<double> c(count);
+    std::vector<double> x(count);
+
+    for (std::size_t i = 0; i < count; ++i) {
+        b[i] = 0.5 * i;
+        c[i] = 3.0 - i;
+        x[i] = 1.0 + i;
+    }
+
+    tomathml::Evaluator evaluator;
+    std::vector<double> a(count);
+    std::vector<double> dxdt(count);
+    const double *inputs[] = { b.data(), c.data(), x.data() };
+    double *outputs[] = { a.data(), dxdt.data() };
+
+    EXPECT_TRUE(evaluator.compile("a = b + c*2{dimensionless};\node(x, t) = -a*x;\n"));
+    EXPECT_TRUE(evaluator.evaluate(inputs, outputs, count));
+
+    for (std::size_t i = 0; i < count; ++i) {
+        EXPECT_DOUBLE_EQ(b[i] + c[i] * 2.0, a[i]);
+        EXPECT_DOUBLE_EQ(-a[i] * x[i], dxdt[i]);
+    }
+}
+
+TEST(Evaluator, Functions)
+{
+    auto res = tomathml::evaluate("a = exp(x) + ln(x) + log(x) + log(x, 2) + root(x, 3) + sqrt(x) + sqr(x) + pow(x, 3);\n"
+                                  "b = sin(x) + cos(x) + tan(x) + sec(x) + csc(x) + cot(x);\n"
+                                  "c = sinh(x) + cosh(x) + tanh(x) + sech(x) + csch(x) + coth(x);\n"
+                                  "d = asin(x/4) + acos(x/4) + atan(x) + asec(x) + acsc(x) + acot(x);\n"
+                                  "h = asinh(x) + acosh(x) + atanh(x/4) + asech(x/4) + acsch(x) + acoth(x);\n"
+                                  "f = abs(-x) + ceil(x) + floor(x) + fact(3) + rem(7, x) + min(x, 1, 5) + max(x, 1, 5) + gcd(12, 18) + lcm(4, 6);\n"
+                                  "g = pi + e + true + false;\n",
+                                  { "x" }, { { 1.5 } }, false);
+    double x = 1.5;
+
+    ASSERT_EQ(7u, res.size());
+    EXPECT_DOUBLE_EQ(std::exp(x) + std::log(x) + std::log10(x) + std::log2(x) + std::cbrt(x) + std::sqrt(x) + x * x + x * x * x, res[0][0]);
+    EXPECT_DOUBLE_EQ(std::sin(x) + std::cos(x) + std::tan(x) + 1.0 / std::cos(x) + 1.0 / std::sin(x) + 1.0 / std::tan(x), res[1][0]);
+    EXPECT_DOUBLE_EQ(std::sinh(x) + std::cosh(x) + std::tanh(x) + 1.0 / std::cosh(x) + 1.0 / std::sinh(x) + 1.0 / std::tanh(x), res[2][0]);
+    EXPECT_DOUBLE_EQ(std::asin(x / 4) + std::acos(x / 4) + std::atan(x) + std::acos(1 / x) + std::asin(1 / x) + std::atan(1 / x), res[3][0]);
+    EXPECT_DOUBLE_EQ(std::asinh(x) + std::acosh(x) + std::atanh(x / 4) + std::acosh(4 / x) + std::asinh(1 / x) + std::atanh(1 / x), res[4][0]);
+    EXPECT_DOUBLE_EQ(x + 2.0 + 1.0 + 6.0 + 1.0 + 1.0 + 5.0 + 6.0 + 12.0, res[5][0]);
+    EXPECT_DOUBLE_EQ(std::numbers::pi + std::numbers::e + 1.0, res[6][0]);
+}
+
+TEST(Evaluator, Piecewise)
+{
+    auto res = tomathml::evaluate("y = sel(case x < 0: -1, case (x >= 0) and (x < 1): x, otherwise: 1);\n"
+                                  "z = sel(case x > 1: x);\n",
+                                  { "x" }, { { -2.0, 0.5, 3.0 } }, false);
+
+    ASSERT_EQ(2u, res.size());
+    EXPECT_EQ(std::vector<double>({ -1.0, 0.5, 1.0 }), res[0]);
+    EXPECT_TRUE(std::isnan(res[1][0]));
+    EXPECT_TRUE(std::isnan(res[1][1]));
+    EXPECT_EQ(3.0, res[1][2]);
+}
+
+TEST(Evaluator, OutOfOrderEquations)
+{
+    // Algebraic equations can come in any order.
+
+    tomathml::Evaluator evaluator;
+
+    ASSERT_TRUE(evaluator.compile("ode(x, t) = c - x;\nc = b + 1;\nb = a*2;\n", false));
+    EXPECT_EQ(std::vector<std::string>({ "a", "x" }), evaluator.inputs());
+    EXPECT_EQ(std::vector<std::string>({ "ode(x, t)", "c", "b" }), evaluator.outputs());
+
+    double a[] = { 1.0, 2.0 };
+    double x[] = { 0.0, 1.0 };
+    double ode[2];
+    double c[2];
+    double b[2];
+    const double *inputs[] = { a, x };
+    double *outputs[] = { ode, c, b };
+
+    ASSERT_TRUE(evaluator.evaluate(inputs, outputs, 2));
+    EXPECT_EQ(3.0, ode[0]);
+    EXPECT_EQ(4.0, ode[1]);
+    EXPECT_EQ(3.0, c[0]);
+    EXPECT_EQ(5.0, c[1]);
+    EXPECT_EQ(2.0, b[0]);
+    EXPECT_EQ(4.0, b[1]);
+}
+
+TEST(Evaluator, Failure)
+{
+    tomathml::Evaluator evaluator;
+    const double *inputs[] = { nullptr };
+    double *outputs[] = { nullptr };
+
+    EXPECT_FALSE(evaluator.compile("a = b + 3;"));
+    EXPECT_EQ(0u, evaluator.messages().find("Messages from parser (1)\n"));
+    EXPECT_FALSE(evaluator.evaluate(inputs, outputs, 1));
+
+    EXPECT_FALSE(evaluator.compile("a = b;\nb = a;\n"));
+    EXPECT_EQ("Messages from compiler (1)\n'a' is part of a cycle of algebraic equations.\n", evaluator.messages());
+
+    EXPECT_FALSE(evaluator.compile("a = 2{dimensionless}*a;\n"));
+    EXPECT_EQ("Messages from compiler (1)\n'a' is part of a cycle of algebraic equations.\n", evaluator.messages());
+
+    EXPECT_FALSE(evaluator.compile("a = b;\na = c;\n"));
+    EXPECT_EQ("Messages from compiler (1)\n'a' is computed by more than one equation.\n", evaluator.messages());
+
+    EXPECT_TRUE(tomathml::evaluate("a = b;", { "c" }, { { 1.0 } }).empty());
+}
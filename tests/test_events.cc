@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "tomathml_converter.h"
+#include "tomathml_events.h"
+
+// Test utilities headers.
+#include "expectedresultstrings.h"
+
+namespace {
+
+// Rebuild the text output of a conversion from its events.
+class TextWriter: public tomathml::EventHandler
+{
+public:
+    std::string output = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+
+    void startElement(std::string_view name, std::span<const tomathml::Attribute> attributes) override
+    {
+        closeStartTag();
+        output += indent() + "<" + std::string(name);
+        for (const auto &attribute : attributes) {
+            output += " " + std::string(attribute.name) + "=\"" + std::string(attribute.value) + "\"";
+        }
+        mStartTagOpen = true;
+        ++mDepth;
+    }
+
+    void endElement(std::string_view name) override
+    {
+        --mDepth;
+        if (mStartTagOpen) {
+            output += " />\n";
+            mStartTagOpen = false;
+        } else {
+            output += indent() + "</" + std::string(name) + ">\n";
+        }
+    }
+
+    void text(std::string_view text) override
+    {
+        closeStartTag();
+        output += indent() + std::string(text) + "\n";
+    }
+
+    void comment(std::string_view comment) override
+    {
+        closeStartTag();
+        output += indent() + "<!-- " + std::string(comment) + " -->\n";
+    }
+
+private:
+    int mDepth = 0;
+    bool mStartTagOpen = false;
+
+    std::string indent() const
+    {
+        return std::string(2 * mDepth, ' ');
+    }
+
+    void closeStartTag()
+    {
+        if (mStartTagOpen) {
+            output += ">\n";
+            mStartTagOpen = false;
+        }
+    }
+};
+
+class EventRecorder: public tomathml::EventHandler
+{
+public:
+    std::vector<std::string> events;
+
+    void startElement(std::string_view name, std::span<const tomathml::Attribute> attributes) override
+    {
+        std::string event = "start " + std::string(name);
+        for (const auto &attribute : attributes) {
+            event += " " + std::string(attribute.name) + "=" + std::string(attribute.value);
+        }
+        events.push_back(event);
+    }
+
+    void endElement(std::string_view name) override
+    {
+        events.push_back("end " + std::string(name));
+    }
+
+    void text(std::string_view text) override
+    {
+        events.push_back("text " + std::string(text));
+    }
+};
+
+}
+
+TEST(Events, Sequence)
+{
+    tomathml::Converter converter;
+    EventRecorder recorder;
+
+    EXPECT_TRUE(converter.convert("a = 2{kg};", recorder));
+
+    std::vector<std::string> expected = {
+        "start math xmlns=http://www.w3.org/1998/Math/MathML",
+        "start apply",
+        "start eq",
+        "end eq",
+        "start ci",
+        "text a",
+        "end ci",
+        "start cn cellml:units=kg xmlns:cellml=http://www.cellml.org/cellml/2.0#",
+        "text 2",
+        "end cn",
+        "end apply",
+        "end math",
+    };
+
+    EXPECT_EQ(expected, recorder.events);
+}
+
+TEST(Events, MatchTextOutput)
+{
+    const std::vector<std::string> texts = {
+        "a = b;\nc = d;",
+        "ode(y,t)=mu*(1{dimensionless}-sqr(x))*y-x;",
+        "// Comment.\na = b - 5.2e-3{kilogram};",
+        "a = sel case b > 1{volt}: c; otherwise: d; endsel;",
+        "y = log(a, 2{dimensionless}) + root(b, 3{dimensionless});",
+    };
+
+    tomathml::Converter converter;
+
+    for (const auto &text : texts) {
+        TextWriter writer;
+
+        EXPECT_TRUE(converter.convert(text, writer));
+        EXPECT_EQ(converter.convert(text), writer.output);
+    }
+}
+
+TEST(Events, Failure)
+{
+    tomathml::Converter converter;
+    EventRecorder recorder;
+
+    EXPECT_FALSE(converter.convert("a = 2;", recorder));
+    EXPECT_TRUE(recorder.events.empty());
+    EXPECT_EQ(0, converter.messages().find("Messages from parser (1)\n[1, 6]: '{' is expected"));
+}
@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "tomathml.h"
+#include "tomathml_converter.h"
+#include "tomathml_incremental.h"
+
+namespace {
+
+std::vector<std::string> statements()
+{
+    std::vector<std::string> res;
+
+    for (int i = 0; i < 60; ++i) {
+        auto n = std::to_string(i);
+
+        switch (i % 6) {
+        case 0:
+            res.push_back("a" + n + " = b*c + " + n + "{volt};\n");
+
+            break;
+        case 1:
+            res.push_back("// Comment " + n + "\n// on two lines\node(x" + n + ", t) = -k*x" + n + ";\n");
+
+            break;
+        case 2:
+            res.push_back("y" + n + " = sel case x > 1{volt}: x; otherwise: 2{volt}; endsel;\n");
+
+            break;
+        case 3:
+            res.push_back("/* ignored */ z" + n + " = exp(-y/2{dimensionless}); ");
+
+            break;
+        case 4:
+            res.push_back("w" + n + " = sqrt(a);\n\n");
+
+            break;
+        default:
+            res.push_back("v" + n + " = pow(w, 2{dimensionless}); // trailing\nu" + n + " = v;\n");
+
+            break;
+        }
+    }
+
+    return res;
+}
+
+std::string join(const std::vector<std::string> &parts)
+{
+    std::string res;
+
+    for (const auto &part : parts) {
+        res += part;
+    }
+
+    return res;
+}
+
+}
+
+TEST(Incremental, SameAsConverter)
+{
+    for (bool hoistNamespaces : { false, true }) {
+        tomathml::Options options;
+
+        options.hoistNamespaces = hoistNamespaces;
+
+        tomathml::IncrementalConverter incrementalConverter(options);
+        tomathml::Converter converter(options);
+        auto parts = statements();
+        auto text = join(parts);
+
+        ASSERT_TRUE(incrementalConverter.update(text));
+        EXPECT_EQ(converter.convert(text), incrementalConverter.output());
+        EXPECT_EQ(71u, incrementalConverter.statementCount());
+
+        // Change, insert, remove and move statements at random.
+
+        std::mt19937 generator(42);
+
+        for (int i = 0; i < 200; ++i) {
+            auto index = generator() % parts.size();
+
+            switch (generator() % 4) {
+            case 0:
+                parts[index] = "c" + std::to_string(i) + " = d + " + std::to_string(i) + "{metre};\n";
+
+                break;
+            case 1:
+                parts.insert(parts.begin() + static_cast<std::ptrdiff_t>(index), "e" + std::to_string(i) + " = f;\n");
+
+                break;
+            case 2:
+                if (parts.size() > 1) {
+                    parts.erase(parts.begin() + static_cast<std::ptrdiff_t>(index));
+                }
+
+                break;
+            default:
+                std::swap(parts[index], parts[generator() % parts.size()]);
+
+                break;
+            }
+
+            text = join(parts);
+
+            ASSERT_TRUE(incrementalConverter.update(text));
+            ASSERT_EQ(converter.convert(text), incrementalConverter.output());
+        }
+    }
+}
+
+TEST(Incremental, OnlyChangedStatements)
+{
+    std::string text;
+
+    for (int i = 0; i < 1000; ++i) {
+        text += "a" + std::to_string(i) + " = b*c + " + std::to_string(i) + "{volt};\n";
+    }
+
+    tomathml::IncrementalConverter converter;
+
+    ASSERT_TRUE(converter.update(text));
+    EXPECT_EQ(1000u, converter.reconvertedStatementCount());
+
+    auto position = text.find("a500 = b*c");
+
+    text.replace(position, 10, "a500 = b/c");
+
+    ASSERT_TRUE(converter.update(text));
+    EXPECT_EQ(1u, converter.reconvertedStatementCount());
+    EXPECT_EQ(tomathml::process(text), converter.output());
+
+    // Appending a statement only converts that statement.
+
+    text += "x = y;\n";
+
+    ASSERT_TRUE(converter.update(text));
+    EXPECT_EQ(1u, converter.reconvertedStatementCount());
+    EXPECT_EQ(tomathml::process(text), converter.output());
+
+    // An unchanged text string converts nothing.
+
+    ASSERT_TRUE(converter.update(text));
+    EXPECT_EQ(0u, converter.reconvertedStatementCount());
+    EXPECT_EQ(1002u, converter.statementCount());
+}
+
+TEST(Incremental, Errors)
+{
+    tomathml::IncrementalConverter converter;
+    std::string text = "a = b;\nc = d;\nh = f;\n";
+
+    ASSERT_TRUE(converter.update(text));
+
+    auto output = converter.output();
+
+    // The messages are those of a full conversion, and the last successful
+    // update is kept.
+
+    EXPECT_FALSE(converter.update("a = b;\nc = ;\nh = f;\n"));
+    EXPECT_EQ(tomathml::process("a = b;\nc = ;\nh = f;\n"), converter.messages());
+    EXPECT_EQ(output, converter.output());
+
+    ASSERT_TRUE(converter.update("a = b;\nc = g;\nh = f;\n"));
+    EXPECT_EQ(1u, converter.reconvertedStatementCount());
+    EXPECT_TRUE(converter.messages().empty());
+    EXPECT_EQ(tomathml::process("a = b;\nc = g;\nh = f;\n"), converter.output());
+}
+
+TEST(Incremental, Empty)
+{
+    tomathml::IncrementalConverter converter;
+
+    ASSERT_TRUE(converter.update(""));
+    EXPECT_EQ(tomathml::process(""), converter.output());
+
+    ASSERT_TRUE(converter.update("a = b;"));
+    EXPECT_EQ(tomathml::process("a = b;"), converter.output());
+
+    ASSERT_TRUE(converter.update("  "));
+    EXPECT_EQ(tomathml::process("  "), converter.output());
+}
+
+TEST(Incremental, FullConversions)
+{
+    tomathml::Options options;
+
+    options.checkUnits = true;
+
+    tomathml::IncrementalConverter converter(options);
+    std::string text = "a = 1{volt} + 2{second};\nb = c;\n";
+
+    ASSERT_TRUE(converter.update(text));
+    EXPECT_EQ(tomathml::Converter(options).convert(text), converter.output());
+    EXPECT_FALSE(converter.messages().empty());
+}
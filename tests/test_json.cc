@@ -0,0 +1,36 @@
+#include <gtest/gtest.h>
+
+#include "tomathml.h"
+#include "tomathml_converter.h"
+
+// Test utilities headers.
+#include "expectedresultstrings.h"
+
+TEST(Json, Derivatives)
+{
+    std::string output = tomathml::processToJson("ode(x, t, 2{dimensionless}) = log(a, 2{dimensionless}) - 1.2e-3{volt};\n"
+                                                 "b = root(pi, 3{dimensionless});\n");
+    EXPECT_EQ(expected_test_result_10, output);
+}
+
+TEST(Json, PiecewiseCellMLOff)
+{
+    std::string output = tomathml::processToJson("a = sel(case b > 1: c, otherwise: d);", false);
+    EXPECT_EQ(expected_test_result_11, output);
+}
+
+TEST(Json, Comments)
+{
+    std::string output = tomathml::processToJson("// A \"quoted\" comment\na = b;\n");
+    EXPECT_EQ("{\"comment\":\" A \\\"quoted\\\" comment\"}\n{\"op\":\"eq\",\"args\":[{\"ci\":\"a\"},{\"ci\":\"b\"}]}\n", output);
+}
+
+TEST(Json, Failure)
+{
+    tomathml::Converter converter;
+    std::string json;
+
+    EXPECT_FALSE(converter.convertToJson("a = b + 3;", json));
+    EXPECT_TRUE(json.empty());
+    EXPECT_EQ(converter.messages(), tomathml::processToJson("a = b + 3;"));
+}
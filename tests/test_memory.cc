@@ -0,0 +1,223 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tomathml.h"
+#include "tomathml_converter.h"
+
+namespace {
+
+// Memory resource that keeps track of what is allocated from it.
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+    std::size_t allocationCount = 0;
+    std::size_t allocatedBytes = 0;
+
+private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        ++allocationCount;
+        allocatedBytes += bytes;
+
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override
+    {
+        allocatedBytes -= bytes;
+
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+// Memory resource that runs out of memory after a given number of allocations,
+// from whichever thread.
+class FailingResource : public std::pmr::memory_resource
+{
+public:
+    explicit FailingResource(std::ptrdiff_t allocationCount)
+        : mAllocationCount(allocationCount)
+    {
+    }
+
+private:
+    std::atomic<std::ptrdiff_t> mAllocationCount;
+
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        if (mAllocationCount.fetch_sub(1) <= 0) {
+            throw std::bad_alloc();
+        }
+
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override
+    {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+std::string model()
+{
+    std::string res;
+
+    for (int i = 0; i < 100; ++i) {
+        auto n = std::to_string(i);
+
+        res += "ode(x" + n + ", t) = -k*x" + n + " + sin(2{dimensionless}*t);\n";
+    }
+
+    return res;
+}
+
+}
+
+TEST(Memory, DocumentFromResource)
+{
+    auto text = model();
+    CountingResource resource;
+
+    {
+        tomathml::Options options;
+
+        options.memoryResource = &resource;
+
+        tomathml::Converter converter(options);
+
+        EXPECT_EQ(tomathml::process(text), converter.convert(text));
+
+        // Every node of the document, its attributes and its children come
+        // from our resource.
+
+        EXPECT_GT(resource.allocationCount, 100U);
+        EXPECT_GT(resource.allocatedBytes, 0U);
+    }
+
+    // Everything is given back once the converter is gone.
+
+    EXPECT_EQ(0U, resource.allocatedBytes);
+}
+
+TEST(Memory, MonotonicBuffer)
+{
+    // A request that converts a text string from its own region of memory,
+    // which gets released all at once at the end of the request.
+
+    auto text = model();
+    auto expected = tomathml::process(text);
+    std::vector<std::byte> buffer(1 << 16);
+
+    for (int request = 0; request < 3; ++request) {
+        std::pmr::monotonic_buffer_resource resource(buffer.data(), buffer.size());
+        tomathml::Options options;
+
+        options.memoryResource = &resource;
+        options.shareSubexpressions = (request == 1);
+
+        tomathml::Converter converter(options);
+        std::pmr::string output(&resource);
+
+        EXPECT_TRUE(converter.convert(text, output));
+        EXPECT_EQ(expected, std::string_view(output));
+        EXPECT_EQ(&resource, output.get_allocator().resource());
+    }
+}
+
+TEST(Memory, SwitchResources)
+{
+    // A converter that is given another resource allocates its next document
+    // from it, while its previous resource is still alive.
+
+    auto text = model();
+    auto expected = tomathml::process(text);
+    CountingResource first;
+    CountingResource second;
+    tomathml::Options options;
+
+    options.shareSubexpressions = true;
+    options.memoryResource = &first;
+
+    {
+        tomathml::Converter converter(options);
+
+        EXPECT_EQ(expected, converter.convert(text));
+
+        options.memoryResource = &second;
+        converter.setOptions(options);
+
+        EXPECT_EQ(expected, converter.convert(text));
+        EXPECT_EQ(0U, first.allocatedBytes);
+        EXPECT_GT(second.allocatedBytes, 0U);
+
+        // Back to the default resource.
+
+        options.memoryResource = nullptr;
+        converter.setOptions(options);
+
+        EXPECT_EQ(expected, converter.convert(text));
+        EXPECT_EQ(0U, second.allocatedBytes);
+    }
+}
+
+TEST(Memory, InvalidText)
+{
+    CountingResource resource;
+    tomathml::Options options;
+
+    options.memoryResource = &resource;
+
+    {
+        tomathml::Converter converter(options);
+        std::pmr::string output("previous content", &resource);
+
+        EXPECT_FALSE(converter.convert("a = b +;", output));
+        EXPECT_TRUE(output.empty());
+        EXPECT_FALSE(converter.messages().empty());
+    }
+
+    EXPECT_EQ(0U, resource.allocatedBytes);
+}
+
+TEST(Memory, OutOfMemoryInBatch)
+{
+    // Running out of memory in a worker of convertBatch() is reported to its
+    // caller rather than terminating us, and the converter remains usable.
+
+    auto text = model();
+    std::vector<std::string_view> texts(16, text);
+    FailingResource resource(1000);
+    tomathml::Options options;
+
+    options.batchThreads = 4;
+    options.memoryResource = &resource;
+
+    tomathml::Converter converter(options);
+
+    EXPECT_THROW(converter.convertBatch(texts), std::bad_alloc);
+
+    options.memoryResource = nullptr;
+    converter.setOptions(options);
+
+    auto outputs = converter.convertBatch(texts);
+
+    ASSERT_EQ(texts.size(), outputs.size());
+    EXPECT_EQ(tomathml::process(text), outputs.back());
+}
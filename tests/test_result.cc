@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "tomathml.h"
+#include "tomathml_converter.h"
+#include "tomathml_result.h"
+
+TEST(Result, Success)
+{
+    std::string text = "a = b + 2{volt};";
+    auto result = tomathml::processToResult(text);
+
+    EXPECT_TRUE(result);
+    EXPECT_EQ(tomathml::process(text), result.output);
+    EXPECT_TRUE(result.diagnostics.empty());
+    EXPECT_EQ(text.size(), result.statistics.inputSize);
+    EXPECT_EQ(result.output.size(), result.statistics.outputSize);
+    EXPECT_GE(result.statistics.parseTime, 0.0);
+    EXPECT_GE(result.statistics.serializationTime, 0.0);
+}
+
+TEST(Result, Failure)
+{
+    auto result = tomathml::processToResult("a = b +;");
+
+    EXPECT_FALSE(result);
+    EXPECT_TRUE(result.output.empty());
+    EXPECT_EQ(0u, result.statistics.outputSize);
+    ASSERT_EQ(1u, result.diagnostics.size());
+
+    const auto &diagnostic = result.diagnostics.front();
+
+    EXPECT_EQ(tomathml::Diagnostic::Severity::Error, diagnostic.severity);
+    EXPECT_EQ("parser", diagnostic.source);
+    EXPECT_EQ(1, diagnostic.line);
+    EXPECT_EQ(8, diagnostic.column);
+    EXPECT_EQ("Messages from parser (1)\n[1, 8]: " + diagnostic.message + "\n", tomathml::process("a = b +;"));
+}
+
+TEST(Result, Warnings)
+{
+    tomathml::Options options;
+
+    options.checkUnits = true;
+
+    tomathml::Converter converter(options);
+    tomathml::ConvertResult result;
+
+    EXPECT_TRUE(converter.convert("a = 1{volt} + 2{second};", result));
+    EXPECT_FALSE(result.output.empty());
+    ASSERT_EQ(1u, result.diagnostics.size());
+    EXPECT_EQ(tomathml::Diagnostic::Severity::Warning, result.diagnostics.front().severity);
+    EXPECT_EQ(converter.diagnostics().size(), result.diagnostics.size());
+}
+
+TEST(Result, Reuse)
+{
+    tomathml::Converter converter;
+    tomathml::ConvertResult result;
+
+    EXPECT_FALSE(converter.convert("a = ;", result));
+    EXPECT_EQ(1u, result.diagnostics.size());
+
+    EXPECT_TRUE(converter.convert("a = b;", result));
+    EXPECT_TRUE(result.diagnostics.empty());
+    EXPECT_EQ(converter.convert("a = b;"), result.output);
+
+    auto data = result.output.data();
+
+    EXPECT_TRUE(converter.convert("a = c;", result));
+    EXPECT_EQ(data, result.output.data());
+}
+
+TEST(Result, Python)
+{
+    auto res = tomathml::processWithDiagnostics("a = b;");
+
+    ASSERT_EQ(1u, res.size());
+    EXPECT_EQ(tomathml::process("a = b;"), res.front());
+
+    res = tomathml::processWithDiagnostics("a = b +;");
+
+    ASSERT_EQ(2u, res.size());
+    EXPECT_TRUE(res.front().empty());
+    EXPECT_EQ(0u, res.back().find("[1, 8]: "));
+}
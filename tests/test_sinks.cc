@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+#include "tomathml.h"
+#include "tomathml_converter.h"
+
+#ifndef _WIN32
+#    include <unistd.h>
+#endif
+
+namespace {
+
+// A model large enough for its output to be handed over in several chunks.
+std::string model()
+{
+    std::string res;
+
+    for (int i = 0; i < 2000; ++i) {
+        res += "ode(x" + std::to_string(i) + ", t) = -k*x" + std::to_string(i) + " + sin(t);\n";
+    }
+
+    return res;
+}
+
+}
+
+TEST(Sinks, String)
+{
+    tomathml::Converter converter;
+    auto text = model();
+    auto expected = converter.convert(text);
+    std::string output = "previous content";
+
+    EXPECT_TRUE(converter.convert(text, output));
+    EXPECT_EQ(expected, output);
+
+    // The capacity of the string is reused.
+
+    auto capacity = output.capacity();
+    auto data = output.data();
+
+    EXPECT_TRUE(converter.convert(text, output));
+    EXPECT_EQ(expected, output);
+    EXPECT_EQ(capacity, output.capacity());
+    EXPECT_EQ(data, output.data());
+
+    EXPECT_FALSE(converter.convert("a = ;", output));
+    EXPECT_TRUE(output.empty());
+    EXPECT_FALSE(converter.messages().empty());
+}
+
+TEST(Sinks, Stream)
+{
+    tomathml::Converter converter;
+    auto text = model();
+    std::ostringstream stream;
+
+    EXPECT_TRUE(converter.convert(text, stream));
+    EXPECT_EQ(converter.convert(text), stream.str());
+
+    std::ostringstream failedStream;
+
+    failedStream.setstate(std::ios::badbit);
+
+    EXPECT_FALSE(converter.convert(text, failedStream));
+    EXPECT_EQ("Messages from writer (1)\nThe output could not be written.\n", converter.messages());
+}
+
+TEST(Sinks, Callback)
+{
+    tomathml::Options options;
+
+    options.serializationThreads = 4;
+
+    tomathml::Converter converter(options);
+    auto text = model();
+    std::string output;
+    std::size_t chunkCount = 0;
+
+    EXPECT_TRUE(converter.convert(text, [&](const char *data, std::size_t size) {
+        output.append(data, size);
+        ++chunkCount;
+    }));
+    EXPECT_EQ(tomathml::process(text), output);
+    EXPECT_GT(chunkCount, 1u);
+
+    chunkCount = 0;
+
+    EXPECT_FALSE(converter.convert("a = ;", [&](const char *, std::size_t) {
+        ++chunkCount;
+    }));
+    EXPECT_EQ(0u, chunkCount);
+}
+
+TEST(Sinks, File)
+{
+    tomathml::Converter converter;
+    auto text = model();
+    auto file = std::tmpfile();
+
+    ASSERT_NE(nullptr, file);
+    EXPECT_TRUE(converter.convert(text, file));
+
+    std::string output(static_cast<std::size_t>(std::ftell(file)), '\0');
+
+    std::rewind(file);
+
+    EXPECT_EQ(output.size(), std::fread(output.data(), 1, output.size(), file));
+    EXPECT_EQ(converter.convert(text), output);
+
+    std::fclose(file);
+}
+
+#ifndef _WIN32
+TEST(Sinks, FileDescriptor)
+{
+    tomathml::Converter converter;
+    auto file = std::tmpfile();
+
+    ASSERT_NE(nullptr, file);
+
+    auto fd = fileno(file);
+
+    EXPECT_TRUE(converter.convertToFileDescriptor("a = b;", fd));
+
+    std::string output(static_cast<std::size_t>(lseek(fd, 0, SEEK_CUR)), '\0');
+
+    EXPECT_EQ(static_cast<ssize_t>(output.size()), pread(fd, output.data(), output.size(), 0));
+    EXPECT_EQ(converter.convert("a = b;"), output);
+
+    EXPECT_FALSE(converter.convertToFileDescriptor("a = b;", -1));
+    EXPECT_EQ("Messages from writer (1)\nThe output could not be written.\n", converter.messages());
+
+    std::fclose(file);
+}
+#endif
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "tomathml.h"
+#include "tomathml_converter.h"
+#include "tomathml_structure.h"
+
+namespace {
+
+const std::string model =
+    "ode(V, t) = -i/Cm;\n"
+    "i = g_m*(V-E);\n"
+    "ode(m, t) = alpha*(1-m)-beta*m;\n"
+    "g_m = g*pow(m, 3);\n"
+    "alpha = 0.1*(V+25)/(exp((V+25)/10)-1);\n"
+    "beta = 4*exp(V/18);\n"
+    "ode(c, t) = -k*c + sin(t);\n";
+
+}
+
+TEST(Structure, Incidence)
+{
+    tomathml::Converter converter(tomathml::Options { .cellml = false });
+    tomathml::Structure structure;
+
+    EXPECT_TRUE(converter.analyseStructure(model, structure));
+
+    EXPECT_EQ(std::vector<std::string>({ "V", "m", "c", "i", "Cm", "g_m", "E", "alpha", "beta", "g", "k", "t" }), structure.variables);
+    EXPECT_EQ(3u, structure.stateCount);
+
+    EXPECT_EQ(7u, structure.incidence.rowCount);
+    EXPECT_EQ(12u, structure.incidence.columnCount);
+    EXPECT_EQ(std::vector<std::size_t>({ 0, 3, 7, 10, 13, 15, 17, 20 }), structure.incidence.rowOffsets);
+    EXPECT_EQ(std::vector<std::size_t>({ 0, 3, 4, 0, 3, 5, 6, 1, 7, 8, 1, 5, 9, 0, 7, 0, 8, 2, 10, 11 }), structure.incidence.columnIndices);
+    EXPECT_EQ(std::vector<std::size_t>({ 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 5, 5, 6, 6, 6 }), structure.incidence.rowIndices());
+}
+
+TEST(Structure, JacobianSparsity)
+{
+    EXPECT_EQ(std::vector<std::vector<std::size_t>>({ { 0, 1 }, { 0, 1 }, { 2 } }), tomathml::jacobianSparsity(model, false));
+}
+
+TEST(Structure, AlgebraicCycle)
+{
+    // The rate of y depends on x through a and b, which depend on each other.
+
+    std::string text = "ode(x, t) = -x;\node(y, t) = a;\na = b + 1;\nb = sel(case a > 0: x, otherwise: a);\n";
+
+    EXPECT_EQ(std::vector<std::vector<std::size_t>>({ { 0 }, { 0 } }), tomathml::jacobianSparsity(text, false));
+}
+
+TEST(Structure, EvaluationOrder)
+{
+    tomathml::Converter converter(tomathml::Options { .cellml = false });
+    tomathml::Structure structure;
+
+    EXPECT_TRUE(converter.analyseStructure(model, structure));
+
+    EXPECT_EQ(std::vector<std::vector<std::size_t>>({ { 3 }, { 1 }, { 0 }, { 4 }, { 5 }, { 2 }, { 6 } }), structure.blocks);
+    EXPECT_EQ(std::vector<std::size_t>({ 0, 1, 2, 0, 0, 1, 0 }), structure.blockLevels);
+}
+
+TEST(Structure, AlgebraicLoop)
+{
+    std::string text = "ode(x, t) = -x;\node(y, t) = a;\na = b + 1;\nb = sel(case a > 0: x, otherwise: a);\n";
+
+    EXPECT_EQ(std::vector<std::vector<std::size_t>>({ { 0 }, { 2, 3 }, { 1 } }), tomathml::evaluationBlocks(text, false));
+    EXPECT_EQ(std::vector<std::vector<std::size_t>>({ { 0, 1 }, { 2 } }), tomathml::evaluationLevels(text, false));
+}
+
+TEST(Structure, LongChain)
+{
+    // A chain of equations, each using the next one, must neither be slow nor
+    // overflow the stack.
+
+    const std::size_t count = 200000;
+    std::string text;
+
+    for (std::size_t i = 0; i < count; ++i) {
+        text += "a" + std::to_string(i) + " = a" + std::to_string(i + 1) + " + 1;\n";
+    }
+
+    tomathml::Converter converter(tomathml::Options { .cellml = false });
+    tomathml::Structure structure;
+
+    EXPECT_TRUE(converter.analyseStructure(text, structure));
+
+    ASSERT_EQ(count, structure.blocks.size());
+    EXPECT_EQ(std::vector<std::size_t>({ count - 1 }), structure.blocks.front());
+    EXPECT_EQ(std::vector<std::size_t>({ 0 }), structure.blocks.back());
+    EXPECT_EQ(count - 1, structure.blockLevels.back());
+}
+
+TEST(Structure, PythonApi)
+{
+    EXPECT_EQ(std::vector<std::string>({ "x", "a", "b", "t" }), tomathml::incidenceVariables("ode(x, t) = a*x;\na = b*t;\n", false));
+    EXPECT_EQ(std::vector<std::vector<std::size_t>>({ { 0, 1 }, { 1, 2, 3 } }), tomathml::incidence("ode(x, t) = a*x;\na = b*t;\n", false));
+    EXPECT_TRUE(tomathml::incidence("a = b + 3;").empty());
+}
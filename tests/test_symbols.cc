@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "tomathml.h"
+#include "tomathml_converter.h"
+#include "tomathml_symbols.h"
+
+TEST(Symbols, Roles)
+{
+    tomathml::Converter converter(tomathml::Options { .cellml = false });
+    std::vector<tomathml::Symbol> symbols;
+
+    EXPECT_TRUE(converter.symbols("ode(V, t) = -i/Cm;\n"
+                                  "i = g*(V-E);\n"
+                                  "  g = 3*ode(V, t) + t;\n",
+                                  symbols));
+
+    ASSERT_EQ(6u, symbols.size());
+
+    EXPECT_EQ("V", symbols[0].name);
+    EXPECT_EQ(3u, symbols[0].count);
+    EXPECT_EQ(1, symbols[0].line);
+    EXPECT_EQ(5, symbols[0].column);
+    EXPECT_EQ(tomathml::Symbol::Role::State, symbols[0].role);
+
+    EXPECT_EQ("t", symbols[1].name);
+    EXPECT_EQ(3u, symbols[1].count);
+    EXPECT_EQ(tomathml::Symbol::Role::VariableOfIntegration, symbols[1].role);
+
+    EXPECT_EQ("i", symbols[2].name);
+    EXPECT_EQ(2u, symbols[2].count);
+    EXPECT_EQ(1, symbols[2].line);
+    EXPECT_EQ(14, symbols[2].column);
+    EXPECT_EQ(tomathml::Symbol::Role::Algebraic, symbols[2].role);
+
+    EXPECT_EQ("Cm", symbols[3].name);
+    EXPECT_EQ(1u, symbols[3].count);
+    EXPECT_EQ(tomathml::Symbol::Role::RightHandSide, symbols[3].role);
+
+    EXPECT_EQ("g", symbols[4].name);
+    EXPECT_EQ(2, symbols[4].line);
+    EXPECT_EQ(5, symbols[4].column);
+    EXPECT_EQ(tomathml::Symbol::Role::Algebraic, symbols[4].role);
+
+    EXPECT_EQ("E", symbols[5].name);
+}
+
+TEST(Symbols, SharedNames)
+{
+    // Every identifier of a symbol shares the text of its name, without
+    // changing the output.
+
+    std::string text = "a = b + b*c;\nd = a/b;\n";
+
+    tomathml::Converter converter(tomathml::Options { .cellml = false });
+
+    EXPECT_EQ(tomathml::process(text, false), converter.convert(text));
+}
+
+TEST(Symbols, PythonApi)
+{
+    std::string text = "ode(x, t) = a*x;\na = 2{dimensionless}*b;\n";
+
+    EXPECT_EQ(std::vector<std::string>({ "x", "t", "a", "b" }), tomathml::symbolNames(text));
+    EXPECT_EQ(std::vector<std::vector<std::size_t>>({ { 2, 1, 5 }, { 1, 1, 8 }, { 2, 1, 13 }, { 1, 2, 22 } }), tomathml::symbolInfo(text));
+    EXPECT_EQ(std::vector<std::string>({ "state", "variableOfIntegration", "algebraic", "rightHandSide" }), tomathml::symbolRoles(text));
+    EXPECT_TRUE(tomathml::symbolNames("a = b + 3;").empty());
+    EXPECT_TRUE(tomathml::symbolRoles("a = b + 3;").empty());
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "tomathml.h"
+#include "tomathml_converter.h"
+
+TEST(Units, Consistent)
+{
+    EXPECT_EQ("", tomathml::checkUnits("i = 3{ampere};\n"
+                                       "Cm = 2{farad};\n"
+                                       "V = i*1{second}/Cm;\n"
+                                       "P = V*i + 1{watt}*2{dimensionless};\n"
+                                       "ode(x, t) = -x/1{millisecond};\n"
+                                       "y = exp(x/1{metre}) + sin(2{radian}) + pi;\n"
+                                       "z = sel(case i > 1{ampere}: sqrt(pow(V, 2{dimensionless})), otherwise: V);\n"));
+}
+
+TEST(Units, Inconsistent)
+{
+    EXPECT_EQ("Messages from parser (3)\n"
+              "[1, 1]: The units of the operands of 'plus' are not consistent (volt and second).\n"
+              "[3, 3]: The units of both sides of the equation have different scales (volt and millivolt).\n"
+              "[4, 1]: The units of the operands of 'exp' must be dimensionless (volt).\n",
+              tomathml::checkUnits("a = 3{volt} + 2{second};\n"
+                                   "b = 2{volt};\n"
+                                   "  b = 2{millivolt};\n"
+                                   "c = exp(b);\n"));
+}
+
+TEST(Units, DerivedUnits)
+{
+    // The units of V are inferred from its ODE, while those of i and g are
+    // only known through their product.
+
+    EXPECT_EQ("Messages from parser (2)\n"
+              "[3, 1]: The units of the operands of 'minus' are not consistent (volt and m^2.kg.s^-2.A^-1).\n"
+              "[4, 1]: The units of 'root' do not have integer exponents (volt to the power of 0.5).\n",
+              tomathml::checkUnits("t = 1{second};\n"
+                                   "ode(V, t) = 1{volt}/1{second};\n"
+                                   "a = V - 1{volt}*t;\n"
+                                   "b = sqrt(V);\n"));
+}
+
+TEST(Units, UnknownUnits)
+{
+    // Units that are not SI units, with or without an SI prefix, are not checked.
+
+    EXPECT_EQ("", tomathml::checkUnits("a = 3{mV}*2{second};\nb = 1{volt} + a;\n"));
+}
+
+TEST(Units, Options)
+{
+    std::string text = "a = 3{volt} + 2{second};\n";
+
+    tomathml::Converter converter;
+
+    EXPECT_EQ(tomathml::process(text), converter.convert(text));
+    EXPECT_EQ("", converter.messages());
+
+    converter.setOptions(tomathml::Options { .checkUnits = true });
+
+    EXPECT_EQ(tomathml::process(text), converter.convert(text));
+    EXPECT_EQ("Messages from parser (1)\n"
+              "[1, 1]: The units of the operands of 'plus' are not consistent (volt and second).\n",
+              converter.messages());
+}
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "tomathml.h"
+#include "tomathml_converter.h"
+#include "tomathml_symbols.h"
+
+TEST(Validate, Valid)
+{
+    tomathml::Converter converter;
+
+    EXPECT_TRUE(converter.validate("ode(x, t) = a*x;\na = sel(case b > 1{volt}: 2{volt}, otherwise: b);\n"));
+    EXPECT_EQ("", converter.messages());
+    EXPECT_EQ("", tomathml::validate("a = b + 3;", false));
+}
+
+TEST(Validate, Invalid)
+{
+    tomathml::Converter converter;
+
+    EXPECT_FALSE(converter.validate("a = b + 3;"));
+    EXPECT_EQ(tomathml::process("a = b + 3;"), converter.messages());
+    EXPECT_EQ(tomathml::process("a = b + 3;"), tomathml::validate("a = b + 3;"));
+}
+
+TEST(Validate, Analyse)
+{
+    tomathml::Converter converter(tomathml::Options { .cellml = false });
+    tomathml::Summary summary;
+
+    EXPECT_TRUE(converter.analyse("// Model.\node(x, t) = a*x;\na = b + 3;\nc = a*ode(x, t);\n", summary));
+    EXPECT_EQ(1u, summary.odeCount);
+    EXPECT_EQ(2u, summary.algebraicEquationCount);
+    EXPECT_EQ(5u, summary.symbols.size());
+
+    // The summary covers the equations up to the first error.
+
+    EXPECT_FALSE(converter.analyse("a = b;\nc = ;\n", summary));
+    EXPECT_EQ(0u, summary.odeCount);
+    EXPECT_EQ(1u, summary.algebraicEquationCount);
+    EXPECT_EQ(3u, summary.symbols.size());
+}
+
+TEST(Validate, ConvertAfterwards)
+{
+    // Validating with a converter does not affect its later conversions.
+
+    std::string text = "// Model.\na = sel(case b > 1: c, otherwise: d) + e*f*g;\n";
+    tomathml::Converter converter(tomathml::Options { .cellml = false, .shareSubexpressions = true });
+
+    EXPECT_TRUE(converter.validate(text));
+    EXPECT_EQ(tomathml::process(text, false), converter.convert(text));
+}
+
+TEST(Validate, PythonApi)
+{
+    EXPECT_EQ(std::vector<std::size_t>({ 1, 1, 4 }), tomathml::statistics("ode(x, t) = a*x;\na = 2{dimensionless}*b;\n"));
+    EXPECT_TRUE(tomathml::statistics("a = b + 3;").empty());
+}